@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <boost/random.hpp>
+#include <boost/cstdint.hpp>
 
 namespace imaging
 {
@@ -19,6 +20,14 @@ namespace imaging
       symmetric_uniform_distribution(random_number_generator, symmetric_interval);
       boost::variate_generator<boost::minstd_rand&, boost::normal_distribution<float_t> >
       std_normal_distribution(random_number_generator, std_normal);
+      
+      boost::uint64_t mix(boost::uint64_t x)
+      {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+      }
   }
       
       
@@ -36,4 +45,22 @@ namespace imaging
   {
     return distribution_utilities_impl::std_normal_distribution();
   }
+  
+  void normal_distribution(unsigned long seed, ublas::vector<float_t> & sample)
+  {
+    boost::mt19937 generator(static_cast<boost::uint32_t>(seed));
+    boost::normal_distribution<float_t> std_normal(0.0, 1.0);
+    boost::variate_generator<boost::mt19937&, boost::normal_distribution<float_t> > normal(generator, std_normal);
+    
+    for(std::size_t i = 0; i < sample.size(); ++i)
+      sample(i) = normal();
+  }
+  
+  unsigned long stream_seed(unsigned long seed, unsigned long i, unsigned long j)
+  {
+    boost::uint64_t x = distribution_utilities_impl::mix(seed);
+    x = distribution_utilities_impl::mix(x ^ i);
+    x = distribution_utilities_impl::mix(x ^ j);
+    return static_cast<unsigned long>(boost::uint32_t(x ^ (x >> 32)));
+  }
 }
@@ -43,6 +43,20 @@ namespace imaging
       Returns a sample from the <em>N(0, 1)</em>-normal distribution.
   */
   float_t normal_distribution();
+  
+  /** \ingroup core
+      <tt>\#include <core/distribution_utilities.hpp></tt>
+      
+      Fills \em sample with independent samples from the <em>N(0, 1)</em>-normal distribution. The samples are drawn from a random number generator which is initialized with \em seed, i.e. the result depends only on \em seed and the size of \em sample. In contrast to normal_distribution() this function is thread-safe.
+  */
+  void normal_distribution(unsigned long seed, ublas::vector<float_t> & sample);
+  
+  /** \ingroup core
+      <tt>\#include <core/distribution_utilities.hpp></tt>
+      
+      Returns a seed computed from \em seed and the indices \em i and \em j. Different triples result in seeds which can be considered independent. This allows to assign a reproducible random number stream to e.g. each candidate \em j in each generation \em i of a stochastic algorithm (see normal_distribution(unsigned long, ublas::vector<float_t> &)).
+  */
+  unsigned long stream_seed(unsigned long seed, unsigned long i, unsigned long j);
 }
 
 #endif
@@ -11,5 +11,22 @@ namespace imaging
       for(iter2 = iter1.begin(); iter2 != iter1.end(); ++iter2)
         *iter2 = 0;
   }
+  
+  size_t Assembler::find_position(const ublas::compressed_matrix<float_t> & matrix, size_t row, size_t column)
+  {
+    // rows with index larger than filled1() - 2 are empty
+    if(row + 1 >= matrix.filled1())
+      return NO_POSITION;
+      
+    const size_t * columns = & matrix.index2_data()[0];
+    const size_t * row_begin = columns + matrix.index1_data()[row];
+    const size_t * row_end = columns + matrix.index1_data()[row + 1];
+    const size_t * position = std::lower_bound(row_begin, row_end, column);
+    
+    if(position == row_end || *position != column)
+      return NO_POSITION;
+      
+    return size_t(position - columns);
+  }
 }
 
@@ -20,8 +20,15 @@
 #ifndef FEM_ASSEMBLER_H
 #define FEM_ASSEMBLER_H
 
+#include <vector>
+#include <string>
+#include <exception>
+#include <algorithm>
+
 #include <fem/Grid.hpp>
 #include <fem/FemKernel.hpp>
+#include <fem/AssemblyMap.hpp>
+#include <fem/GridGeometryCache.hpp>
 
 
 
@@ -32,12 +39,70 @@ namespace imaging
       \brief Assembles the stiffness matrix and force vector of a FE problem.
       
       The Assembler class provides functions to assemble the stiffness matrix and force vector for a given equation and a given grid.
+      
+      The element contributions can be computed by several threads in parallel (see Assembler::Assembler()). This requires the library to be compiled with OpenMP support. The elements are processed in blocks: the threads evaluate the equation on the elements of a block and store the element contributions in a buffer which is then added to the stiffness matrix and the force vector by a single thread in the order of the element indices. Thus there are no concurrent writes to the matrix and the result is identical (bit for bit) to the result of a serial assembly, regardless of the number of threads. If no AssemblyMap is given, the threads also look up the positions of the element contributions in the sparsity pattern of the stiffness matrix, such that the single thread only has to add the values; matrix entries which are not in the pattern yet are inserted by the single thread. The equation object is shared by all threads, i.e. its const member functions must be safe to call concurrently. This is the case for all equations provided by \em imaging2.
   */
   class Assembler
   {
+    static const size_t ELEMENT_BLOCK_SIZE = 4096;
+    
+    // marks a local matrix entry which is not contained in the sparsity pattern of the stiffness matrix
+    static const size_t NO_POSITION = size_t(-1);
+    
+    size_t _n_threads;
+    
     static void clear_matrix(ublas::compressed_matrix<float_t> & matrix);
     
+    static size_t find_position(const ublas::compressed_matrix<float_t> & matrix, size_t row, size_t column);
+    
+    template<class fem_types, class equation_t>
+    void assemble_system(const std::string & function, const equation_t & equation, const Grid<fem_types> & grid,
+                         const GridGeometryCache<fem_types> * geometry_cache,
+                         const AssemblyMap * assembly_map,
+                         ublas::compressed_matrix<float_t> * stiffness_matrix,
+                         ublas::vector<float_t> * force_vector) const;
+    
+    template<class fem_types, class equation_t>
+    void assemble_blocks(const std::string & function, const equation_t & equation, const Grid<fem_types> & grid,
+                         bool boundary,
+                         const GridGeometryCache<fem_types> * geometry_cache,
+                         const AssemblyMap * assembly_map,
+                         ublas::compressed_matrix<float_t> * stiffness_matrix,
+                         ublas::vector<float_t> * force_vector) const;
+    
+    template<class fem_types, class equation_t>
+    static void element_contributions(const equation_t & equation, const FemKernel<fem_types> & kernel,
+                                      const typename fem_types::integrator_t & integrator,
+                                      float_t * local_matrix, float_t * local_vector);
+    
+    template<class fem_types, class equation_t>
+    static void boundary_element_contributions(const equation_t & equation, const FemKernel<fem_types> & kernel,
+                                               const typename fem_types::boundary_integrator_t & boundary_integrator,
+                                               float_t * local_matrix, float_t * local_vector);
+    
+    template<class fem_types>
+    static void find_element_positions(const ublas::compressed_matrix<float_t> & matrix, const Grid<fem_types> & grid,
+                                       size_t element, size_t system_size, size_t * positions);
+                                    
+    template<class fem_types>
+    static void scatter_block(const Grid<fem_types> & grid, size_t system_size,
+                              size_t block_begin, size_t block_size, bool boundary,
+                              const std::vector<float_t> & local_matrices,
+                              const std::vector<float_t> & local_vectors,
+                              const std::vector<size_t> & positions,
+                              const AssemblyMap * assembly_map,
+                              ublas::compressed_matrix<float_t> * stiffness_matrix,
+                              ublas::vector<float_t> * force_vector);
+    
   public:
+    /** Constructs an Assembler which computes the element contributions with \em n_threads threads. If the library was compiled without OpenMP support, \em n_threads is ignored and the assembly is serial. The results do not depend on the number of threads. */
+    Assembler(size_t n_threads = 1) : _n_threads(n_threads > 0 ? n_threads : 1) {}
+    
+    /** Returns the number of threads used for the assembly. */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads used for the assembly. */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
 
     /** Assembles the stiffness matrix and the force vector for \em equation on \em grid. This is done in one big loop and thus faster than calling assemble_stiffness_matrix() and assemble_force_vector() separately. For performance reasons the type of \em equation is a template parameter.
     
@@ -76,287 +141,497 @@ namespace imaging
     void assemble_force_vector(const equation_t & equation, const Grid<fem_types> & grid,
                   ublas::vector<float_t> & force_vector) const;
 
+    /** Assembles the stiffness matrix and the force vector for \em equation on \em grid. In contrast to assemble(const equation_t &, const Grid<fem_types> &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &) the entries of the element stiffness matrices are added directly to the storage of \em stiffness_matrix at the positions given by \em assembly_map. No searches or insertions in the sparse matrix take place. The results are identical to the ones of assemble() (apart from entries which are structurally zero, which are not stored by \em assembly_map).
+    
+        The map \em assembly_map must have been constructed for \em grid, \em stiffness_matrix and the system size of \em equation by AssemblyMap::construct(), otherwise an Exception is thrown.
+    
+        \sa AssemblyMap
+    */
+    template<class fem_types, class equation_t>
+    void assemble(const equation_t & equation, const Grid<fem_types> & grid,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix,
+                  ublas::vector<float_t> & force_vector) const;
+                  
+    /** Assembles the stiffness matrix for \em equation on \em grid using the precomputed positions in \em assembly_map (cf. assemble(const equation_t &, const Grid<fem_types> &, const AssemblyMap &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &)).
+    
+        \sa AssemblyMap
+    */
+    template<class fem_types, class equation_t>
+    void assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+
+    /** Assembles the stiffness matrix and the force vector for \em equation on \em grid (cf. assemble(const equation_t &, const Grid<fem_types> &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &)). The element geometry is read from \em geometry_cache instead of being computed for each element. The results are identical to the ones of the function without \em geometry_cache.
+    
+        \sa GridGeometryCache
+    */
+    template<class fem_types, class equation_t>
+    void assemble(const equation_t & equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix,
+                  ublas::vector<float_t> & force_vector) const;
+                  
+    /** Assembles the stiffness matrix for \em equation on \em grid using the element geometry in \em geometry_cache (cf. assemble(const equation_t &, const Grid<fem_types> &, const GridGeometryCache<fem_types> &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &)).
+    
+        \sa GridGeometryCache
+    */
+    template<class fem_types, class equation_t>
+    void assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+                  
+    /** Assembles the stiffness matrix and the force vector for \em equation on \em grid using the precomputed positions in \em assembly_map (cf. assemble(const equation_t &, const Grid<fem_types> &, const AssemblyMap &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &)). The element geometry is read from \em geometry_cache instead of being computed for each element. This speeds up the assembly on grids which are not regular. The results are identical to the ones of the functions without \em geometry_cache.
+    
+        The cache \em geometry_cache must have been constructed for \em grid by GridGeometryCache::construct(), otherwise an Exception is thrown.
+    
+        \sa GridGeometryCache, AssemblyMap
+    */
+    template<class fem_types, class equation_t>
+    void assemble(const equation_t & equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix,
+                  ublas::vector<float_t> & force_vector) const;
+                  
+    /** Assembles the stiffness matrix for \em equation on \em grid using the element geometry in \em geometry_cache and the precomputed positions in \em assembly_map (cf. assemble(const equation_t &, const Grid<fem_types> &, const GridGeometryCache<fem_types> &, const AssemblyMap &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &)).
+    
+        \sa GridGeometryCache, AssemblyMap
+    */
+    template<class fem_types, class equation_t>
+    void assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+                  
+    /** Assembles the force vector for \em equation on \em grid using the element geometry in \em geometry_cache (cf. assemble(const equation_t &, const Grid<fem_types> &, const GridGeometryCache<fem_types> &, const AssemblyMap &, ublas::compressed_matrix<float_t> &, ublas::vector<float_t> &)).
+    
+        \sa GridGeometryCache
+    */
+    template<class fem_types, class equation_t>
+    void assemble_force_vector(const equation_t & equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  ublas::vector<float_t> & force_vector) const;
+
   }
   ;
 
   template<class fem_types, class equation_t>
   void Assembler::assemble(const equation_t & equation, const Grid<fem_types> & grid,
-                                       ublas::compressed_matrix<float_t> & stiffness_matrix,
-                                       ublas::vector<float_t> & force_vector) const
+                           ublas::compressed_matrix<float_t> & stiffness_matrix,
+                           ublas::vector<float_t> & force_vector) const
   {
-    typedef typename fem_types::shape_function_t shape_function_t;
-    typedef typename fem_types::integrator_t integrator_t;
-    typedef typename fem_types::boundary_integrator_t boundary_integrator_t;
-    typedef typename fem_types::transform_t transform_t;
-    
-    if(stiffness_matrix.size1() != equation.system_size() * grid.n_nodes() &&
-       stiffness_matrix.size2() != equation.system_size() * grid.n_nodes() )
-      throw Exception("Exception: Dimension of stiffness matrix does not agree with grid size in Assembler::assemble()");
-      
-    clear_matrix(stiffness_matrix);
+    assemble_system("assemble", equation, grid, static_cast<const GridGeometryCache<fem_types> *>(0), static_cast<const AssemblyMap *>(0), &stiffness_matrix, &force_vector);
+  }
 
-    force_vector.resize(equation.system_size() * grid.n_nodes(), false);
-    force_vector.clear();
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                                            ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    assemble_system("assemble_stiffness_matrix", equation, grid, static_cast<const GridGeometryCache<fem_types> *>(0), static_cast<const AssemblyMap *>(0), &stiffness_matrix, static_cast<ublas::vector<float_t> *>(0));
+  }
 
-    integrator_t integrator;
-    boundary_integrator_t boundary_integrator;
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_force_vector(const equation_t & equation, const Grid<fem_types> & grid,
+                                        ublas::vector<float_t> & force_vector) const
+  {
+    assemble_system("assemble_force_vector", equation, grid, static_cast<const GridGeometryCache<fem_types> *>(0), static_cast<const AssemblyMap *>(0), static_cast<ublas::compressed_matrix<float_t> *>(0), &force_vector);
+  }
 
+  template<class fem_types, class equation_t>
+  void Assembler::assemble(const equation_t & equation, const Grid<fem_types> & grid,
+                           const AssemblyMap & assembly_map,
+                           ublas::compressed_matrix<float_t> & stiffness_matrix,
+                           ublas::vector<float_t> & force_vector) const
+  {
+    assemble_system("assemble", equation, grid, static_cast<const GridGeometryCache<fem_types> *>(0), &assembly_map, &stiffness_matrix, &force_vector);
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                                            const AssemblyMap & assembly_map,
+                                            ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    assemble_system("assemble_stiffness_matrix", equation, grid, static_cast<const GridGeometryCache<fem_types> *>(0), &assembly_map, &stiffness_matrix, static_cast<ublas::vector<float_t> *>(0));
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble(const equation_t & equation, const Grid<fem_types> & grid,
+                           const GridGeometryCache<fem_types> & geometry_cache,
+                           ublas::compressed_matrix<float_t> & stiffness_matrix,
+                           ublas::vector<float_t> & force_vector) const
+  {
+    assemble_system("assemble", equation, grid, &geometry_cache, static_cast<const AssemblyMap *>(0), &stiffness_matrix, &force_vector);
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                                            const GridGeometryCache<fem_types> & geometry_cache,
+                                            ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    assemble_system("assemble_stiffness_matrix", equation, grid, &geometry_cache, static_cast<const AssemblyMap *>(0), &stiffness_matrix, static_cast<ublas::vector<float_t> *>(0));
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble(const equation_t & equation, const Grid<fem_types> & grid,
+                           const GridGeometryCache<fem_types> & geometry_cache,
+                           const AssemblyMap & assembly_map,
+                           ublas::compressed_matrix<float_t> & stiffness_matrix,
+                           ublas::vector<float_t> & force_vector) const
+  {
+    assemble_system("assemble", equation, grid, &geometry_cache, &assembly_map, &stiffness_matrix, &force_vector);
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_stiffness_matrix(const equation_t & equation, const Grid<fem_types> & grid,
+                                            const GridGeometryCache<fem_types> & geometry_cache,
+                                            const AssemblyMap & assembly_map,
+                                            ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    assemble_system("assemble_stiffness_matrix", equation, grid, &geometry_cache, &assembly_map, &stiffness_matrix, static_cast<ublas::vector<float_t> *>(0));
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_force_vector(const equation_t & equation, const Grid<fem_types> & grid,
+                                        const GridGeometryCache<fem_types> & geometry_cache,
+                                        ublas::vector<float_t> & force_vector) const
+  {
+    assemble_system("assemble_force_vector", equation, grid, &geometry_cache, static_cast<const AssemblyMap *>(0), static_cast<ublas::compressed_matrix<float_t> *>(0), &force_vector);
+  }
+
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_system(const std::string & function, const equation_t & equation, const Grid<fem_types> & grid,
+                                  const GridGeometryCache<fem_types> * geometry_cache,
+                                  const AssemblyMap * assembly_map,
+                                  ublas::compressed_matrix<float_t> * stiffness_matrix,
+                                  ublas::vector<float_t> * force_vector) const
+  {
+    const size_t size = equation.system_size() * grid.n_nodes();
+
+    if(geometry_cache && ! geometry_cache->is_compatible(grid))
+      throw Exception("Exception: Geometry cache does not agree with grid in Assembler::" + function + "().");
+
+    if(stiffness_matrix && assembly_map)
+    {
+      if( ! assembly_map->is_compatible(grid, *stiffness_matrix, equation.system_size()) )
+        throw Exception("Exception: Assembly map does not agree with grid or stiffness matrix in Assembler::" + function + "().");
+
+      AssemblyMap::clear_values(*stiffness_matrix);
+    }
+    else if(stiffness_matrix)
+    {
+      if(stiffness_matrix->size1() != size || stiffness_matrix->size2() != size)
+        throw Exception("Exception: Dimension of stiffness matrix does not agree with grid size in Assembler::" + function + "().");
+
+      clear_matrix(*stiffness_matrix);
+    }
+
+    if(force_vector)
+    {
+      force_vector->resize(size, false);
+      force_vector->clear();
+    }
+
+    // set the reference element once outside of the parallel regions such that errors are thrown here
     FemKernel<fem_types> kernel(grid);
 
     if(grid.is_regular() && grid.n_elements() > 0)
       kernel.set_element(0);
-      
-    std::string sanity_check_message = "";
-    if( ! equation.sanity_check_stiffness_matrix(kernel, sanity_check_message) )
-      throw Exception("Exception: sanity check failed in Assembler::assemble() with message '" + sanity_check_message + "'.");
-    if( ! equation.sanity_check_force_vector(kernel, sanity_check_message) )
-      throw Exception("Exception: sanity check failed in Assembler::assemble() with message '" + sanity_check_message + "'.");
-      
-    for(size_t element = 0; element < grid.n_elements(); ++element)
-    {
-      float_t value;
 
-      if(grid.is_regular())
-        kernel.lazy_set_element(element);
-      else
-        kernel.set_element(element);
+    std::string sanity_check_message = "";
+    if(stiffness_matrix && ! equation.sanity_check_stiffness_matrix(kernel, sanity_check_message) )
+      throw Exception("Exception: sanity check failed in Assembler::" + function + "() with message '" + sanity_check_message + "'.");
+    if(force_vector && ! equation.sanity_check_force_vector(kernel, sanity_check_message) )
+      throw Exception("Exception: sanity check failed in Assembler::" + function + "() with message '" + sanity_check_message + "'.");
 
-      for(size_t i = 0; i < fem_types::shape_function_t::n_element_nodes; ++i)
-      {
-        for(size_t l = 0; l < equation.system_size(); ++l)
-        {
-          for(size_t j = 0; j < fem_types::shape_function_t::n_element_nodes; ++j)
-          {
-            for(size_t m = 0; m < equation.system_size(); ++m)
-            {
-              value = 0.0;
-  
-              for(size_t k = 0; k < integrator_t::n_nodes; ++k)
-                value += equation.stiffness_matrix(l, m, i, j, k, kernel) * 
-                         kernel.transform_determinant(k) *
-                         integrator.weight(k);
-  
-              stiffness_matrix(equation.system_size() * grid.global_node_index(element, i) + l,
-                               equation.system_size() * grid.global_node_index(element, j) + m) += value;
-            }
-          }
+    assemble_blocks(function, equation, grid, false, geometry_cache, assembly_map, stiffness_matrix, force_vector);
+    assemble_blocks(function, equation, grid, true, geometry_cache, assembly_map, stiffness_matrix, force_vector);
+  }
 
-          value = 0.0;
+  template<class fem_types, class equation_t>
+  void Assembler::assemble_blocks(const std::string & function, const equation_t & equation, const Grid<fem_types> & grid,
+                                  bool boundary,
+                                  const GridGeometryCache<fem_types> * geometry_cache,
+                                  const AssemblyMap * assembly_map,
+                                  ublas::compressed_matrix<float_t> * stiffness_matrix,
+                                  ublas::vector<float_t> * force_vector) const
+  {
+    typedef typename fem_types::integrator_t integrator_t;
+    typedef typename fem_types::boundary_integrator_t boundary_integrator_t;
 
-          for(size_t k = 0; k < integrator_t::n_nodes; ++k)
-            value += equation.force_vector(l, i, k, kernel) *
-                         kernel.transform_determinant(k) *
-                         integrator.weight(k);
+    const size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    const size_t system_size = equation.system_size();
+    const size_t n_local = n_element_nodes * system_size;
+    const size_t n_elements = boundary ? grid.n_boundary_elements() : grid.n_elements();
 
-          force_vector(equation.system_size() * grid.global_node_index(element, i) + l) += value;
-        }
-      }
-    }
+    // without an assembly map the positions of the local entries in the matrix are searched in parallel
+    const bool search_positions = stiffness_matrix && ! assembly_map;
 
+    std::vector<float_t> local_matrices(stiffness_matrix ? ELEMENT_BLOCK_SIZE * n_local * n_local : 0);
+    std::vector<float_t> local_vectors(force_vector ? ELEMENT_BLOCK_SIZE * n_local : 0);
+    std::vector<size_t> positions(search_positions ? ELEMENT_BLOCK_SIZE * n_local * n_local : 0);
 
-    for(size_t element = 0; element < grid.n_boundary_elements(); ++element)
+    for(size_t block_begin = 0; block_begin < n_elements; block_begin += ELEMENT_BLOCK_SIZE)
     {
-      kernel.set_boundary_element(element);
-      size_t parent_element = grid.parent_element(element);
-      
-      for(size_t i = 0; i < fem_types::shape_function_t::n_element_nodes; ++i)
+      const long block_size = long(std::min(size_t(ELEMENT_BLOCK_SIZE), n_elements - block_begin));
+      bool failed = false;
+      std::string error_message;
+
+      #pragma omp parallel num_threads(_n_threads)
       {
-        for(size_t l = 0; l < equation.system_size(); ++l)
-        {  
-          for(size_t j = 0; j < fem_types::shape_function_t::n_element_nodes; ++j)
+        integrator_t integrator;
+        boundary_integrator_t boundary_integrator;
+        FemKernel<fem_types> kernel(grid);
+
+        if(! boundary && grid.is_regular())
+          kernel.set_element(0);
+
+        #pragma omp for schedule(static)
+        for(long block_element = 0; block_element < block_size; ++block_element)
+        {
+          try
           {
-            for(size_t m = 0; m < equation.system_size(); ++m)
+            size_t element = block_begin + block_element;
+            float_t * local_matrix = stiffness_matrix ? & local_matrices[block_element * n_local * n_local] : 0;
+            float_t * local_vector = force_vector ? & local_vectors[block_element * n_local] : 0;
+
+            if(boundary)
             {
-              float_t value = 0.0;
-  
-              for(size_t k = 0; k < boundary_integrator_t::n_nodes; ++k)
-                value += equation.stiffness_matrix_at_boundary(l, m, i, j, k, kernel) *
-                 kernel.boundary_transform_determinant(k) *
-                 boundary_integrator.weight(k);
-                
-              stiffness_matrix(equation.system_size() * grid.global_node_index(parent_element, i) + l,
-                               equation.system_size() * grid.global_node_index(parent_element, j) + m) += value;
+              kernel.set_boundary_element(element);
+              boundary_element_contributions(equation, kernel, boundary_integrator, local_matrix, local_vector);
+            }
+            else
+            {
+              if(grid.is_regular())
+                kernel.lazy_set_element(element);
+              else if(geometry_cache)
+                kernel.set_element(element, *geometry_cache);
+              else
+                kernel.set_element(element);
+
+              element_contributions(equation, kernel, integrator, local_matrix, local_vector);
             }
 
+            if(search_positions)
+              find_element_positions(*stiffness_matrix, grid, boundary ? grid.parent_element(element) : element,
+                                     system_size, & positions[block_element * n_local * n_local]);
+          }
+          catch(Exception & e)
+          {
+            #pragma omp critical(assembler_error)
+            {
+              failed = true;
+              error_message = e.error_msg();
+            }
+          }
+          catch(std::exception & e)
+          {
+            #pragma omp critical(assembler_error)
+            {
+              failed = true;
+              error_message = "Exception: " + std::string(e.what()) + " in Assembler::" + function + "().";
+            }
+          }
+          catch(...)
+          {
+            #pragma omp critical(assembler_error)
+            {
+              failed = true;
+              error_message = "Exception: Unknown exception in Assembler::" + function + "().";
+            }
           }
-
-          float_t value = 0.0;
-
-          for(size_t k = 0; k < boundary_integrator_t::n_nodes; ++k)
-            value += equation.force_vector_at_boundary(l, i, k, kernel) *
-                 kernel.boundary_transform_determinant(k) *
-                 boundary_integrator.weight(k);
-
-          force_vector(equation.system_size() * grid.global_node_index(parent_element, i) + l) += value;
         }
       }
-    }
 
+      if(failed)
+        throw Exception(error_message);
+
+      scatter_block(grid, system_size, block_begin, size_t(block_size), boundary,
+                    local_matrices, local_vectors, positions, assembly_map, stiffness_matrix, force_vector);
+    }
   }
 
   template<class fem_types, class equation_t>
-  void Assembler::assemble_stiffness_matrix(const equation_t & equation,
-                                      const Grid<fem_types> & grid,
-                                      ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  void Assembler::element_contributions(const equation_t & equation, const FemKernel<fem_types> & kernel,
+                                        const typename fem_types::integrator_t & integrator,
+                                        float_t * local_matrix, float_t * local_vector)
   {
-    typedef typename fem_types::shape_function_t shape_function_t;
     typedef typename fem_types::integrator_t integrator_t;
-    typedef typename fem_types::boundary_integrator_t boundary_integrator_t;
-    typedef typename fem_types::transform_t transform_t;
-   
-    if(stiffness_matrix.size1() != equation.system_size() * grid.n_nodes() &&
-       stiffness_matrix.size2() != equation.system_size() * grid.n_nodes() )
-      throw Exception("Exception: Dimension of stiffness matrix does not agree with grid size in Assembler::assemble()");
-
-    clear_matrix(stiffness_matrix);
-    
-    integrator_t integrator;
-    boundary_integrator_t boundary_integrator;
 
-    FemKernel<fem_types> kernel(grid);
+    const size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    const size_t system_size = equation.system_size();
+    const size_t n_local = n_element_nodes * system_size;
 
-    if(grid.is_regular() && grid.n_elements() > 0)
-      kernel.set_element(0);
-      
-    std::string sanity_check_message = "";
-    if( ! equation.sanity_check_stiffness_matrix(kernel, sanity_check_message) )
-      throw Exception("Exception: sanity check failed in Assembler::assemble() with message '" + sanity_check_message + "'.");  
-      
-    for(size_t element = 0; element < grid.n_elements(); ++element)
+    for(size_t i = 0; i < n_element_nodes; ++i)
     {
-      float_t value;
-
-      if(grid.is_regular())
-        kernel.lazy_set_element(element);
-      else
-        kernel.set_element(element);
-
-      for(size_t i = 0; i < fem_types::shape_function_t::n_element_nodes; ++i)
+      for(size_t l = 0; l < system_size; ++l)
       {
-        for(size_t l = 0; l < equation.system_size(); ++l)
+        const size_t local_row = i * system_size + l;
+
+        if(local_matrix)
         {
-          for(size_t j = 0; j < fem_types::shape_function_t::n_element_nodes; ++j)
+          for(size_t j = 0; j < n_element_nodes; ++j)
           {
-            for(size_t m = 0; m < equation.system_size(); ++m)
+            for(size_t m = 0; m < system_size; ++m)
             {
-              value = 0.0;
-  
+              float_t value = 0.0;
+
               for(size_t k = 0; k < integrator_t::n_nodes; ++k)
-                value += equation.stiffness_matrix(l, m, i, j, k, kernel) * 
+                value += equation.stiffness_matrix(l, m, i, j, k, kernel) *
                          kernel.transform_determinant(k) *
                          integrator.weight(k);
-  
-              stiffness_matrix(equation.system_size() * grid.global_node_index(element, i) + l,
-                               equation.system_size() * grid.global_node_index(element, j) + m) += value;
+
+              local_matrix[local_row * n_local + j * system_size + m] = value;
             }
           }
         }
+
+        if(local_vector)
+        {
+          float_t value = 0.0;
+
+          for(size_t k = 0; k < integrator_t::n_nodes; ++k)
+            value += equation.force_vector(l, i, k, kernel) *
+                     kernel.transform_determinant(k) *
+                     integrator.weight(k);
+
+          local_vector[local_row] = value;
+        }
       }
     }
+  }
 
+  template<class fem_types, class equation_t>
+  void Assembler::boundary_element_contributions(const equation_t & equation, const FemKernel<fem_types> & kernel,
+                                                 const typename fem_types::boundary_integrator_t & boundary_integrator,
+                                                 float_t * local_matrix, float_t * local_vector)
+  {
+    typedef typename fem_types::boundary_integrator_t boundary_integrator_t;
 
-    for(size_t element = 0; element < grid.n_boundary_elements(); ++element)
+    const size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    const size_t system_size = equation.system_size();
+    const size_t n_local = n_element_nodes * system_size;
+
+    for(size_t i = 0; i < n_element_nodes; ++i)
     {
-      kernel.set_boundary_element(element);
-      size_t parent_element = grid.parent_element(element);
-      
-      for(size_t i = 0; i < fem_types::shape_function_t::n_element_nodes; ++i)
+      for(size_t l = 0; l < system_size; ++l)
       {
-        for(size_t l = 0; l < equation.system_size(); ++l)
-        {  
-          for(size_t j = 0; j < fem_types::shape_function_t::n_element_nodes; ++j)
+        const size_t local_row = i * system_size + l;
+
+        if(local_matrix)
+        {
+          for(size_t j = 0; j < n_element_nodes; ++j)
           {
-            for(size_t m = 0; m < equation.system_size(); ++m)
+            for(size_t m = 0; m < system_size; ++m)
             {
               float_t value = 0.0;
-  
+
               for(size_t k = 0; k < boundary_integrator_t::n_nodes; ++k)
                 value += equation.stiffness_matrix_at_boundary(l, m, i, j, k, kernel) *
-                 kernel.boundary_transform_determinant(k) *
-                 boundary_integrator.weight(k);
-                
-              stiffness_matrix(equation.system_size() * grid.global_node_index(parent_element, i) + l,
-                               equation.system_size() * grid.global_node_index(parent_element, j) + m) += value;
+                         kernel.boundary_transform_determinant(k) *
+                         boundary_integrator.weight(k);
+
+              local_matrix[local_row * n_local + j * system_size + m] = value;
             }
           }
         }
+
+        if(local_vector)
+        {
+          float_t value = 0.0;
+
+          for(size_t k = 0; k < boundary_integrator_t::n_nodes; ++k)
+            value += equation.force_vector_at_boundary(l, i, k, kernel) *
+                     kernel.boundary_transform_determinant(k) *
+                     boundary_integrator.weight(k);
+
+          local_vector[local_row] = value;
+        }
       }
     }
-
   }
 
-  template<class fem_types, class equation_t>
-  void Assembler::assemble_force_vector(const equation_t & equation,
-                                      const Grid<fem_types> & grid,
-                                      ublas::vector<float_t> & force_vector) const
+  template<class fem_types>
+  void Assembler::find_element_positions(const ublas::compressed_matrix<float_t> & matrix, const Grid<fem_types> & grid,
+                                         size_t element, size_t system_size, size_t * positions)
   {
-    typedef typename fem_types::shape_function_t shape_function_t;
-    typedef typename fem_types::integrator_t integrator_t;
-    typedef typename fem_types::boundary_integrator_t boundary_integrator_t;
-    typedef typename fem_types::transform_t transform_t;
-   
-    force_vector.resize(equation.system_size() * grid.n_nodes(), false);
-    force_vector.clear();
-
-    integrator_t integrator;
-    boundary_integrator_t boundary_integrator;
-
-    FemKernel<fem_types> kernel(grid);
+    const size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    const size_t n_local = n_element_nodes * system_size;
 
-    if(grid.is_regular() && grid.n_elements() > 0)
-      kernel.set_element(0);
-      
-    std::string sanity_check_message = "";
-    if( ! equation.sanity_check_force_vector(kernel, sanity_check_message) )
-      throw Exception("Exception: sanity check failed in Assembler::assemble() with message '" + sanity_check_message + "'.");
-      
-    for(size_t element = 0; element < grid.n_elements(); ++element)
+    for(size_t i = 0; i < n_element_nodes; ++i)
     {
-      float_t value;
-
-      if(grid.is_regular())
-        kernel.lazy_set_element(element);
-      else
-        kernel.set_element(element);
-
-      for(size_t i = 0; i < fem_types::shape_function_t::n_element_nodes; ++i)
+      for(size_t l = 0; l < system_size; ++l)
       {
-        for(size_t l = 0; l < equation.system_size(); ++l)
-        {
-          value = 0.0;
-
-          for(size_t k = 0; k < integrator_t::n_nodes; ++k)
-            value += equation.force_vector(l, i, k, kernel) *
-                         kernel.transform_determinant(k) *
-                         integrator.weight(k);
+        size_t row = system_size * grid.global_node_index(element, i) + l;
+        size_t * row_positions = positions + (i * system_size + l) * n_local;
 
-          force_vector(equation.system_size() * grid.global_node_index(element, i) + l) += value;
-        }
+        for(size_t j = 0; j < n_element_nodes; ++j)
+          for(size_t m = 0; m < system_size; ++m)
+            row_positions[j * system_size + m] = find_position(matrix, row, system_size * grid.global_node_index(element, j) + m);
       }
     }
+  }
 
+  template<class fem_types>
+  void Assembler::scatter_block(const Grid<fem_types> & grid, size_t system_size,
+                                size_t block_begin, size_t block_size, bool boundary,
+                                const std::vector<float_t> & local_matrices,
+                                const std::vector<float_t> & local_vectors,
+                                const std::vector<size_t> & positions,
+                                const AssemblyMap * assembly_map,
+                                ublas::compressed_matrix<float_t> * stiffness_matrix,
+                                ublas::vector<float_t> * force_vector)
+  {
+    const size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    const size_t n_local = n_element_nodes * system_size;
+
+    // the positions are only valid if no entry has to be inserted into the matrix
+    const bool use_positions = ! assembly_map && ! positions.empty() &&
+      std::find(positions.begin(), positions.begin() + block_size * n_local * n_local, NO_POSITION) == positions.begin() + block_size * n_local * n_local;
 
-    for(size_t element = 0; element < grid.n_boundary_elements(); ++element)
+    for(size_t block_element = 0; block_element < block_size; ++block_element)
     {
-      kernel.set_boundary_element(element);
-      size_t parent_element = grid.parent_element(element);
-      
-      for(size_t i = 0; i < fem_types::shape_function_t::n_element_nodes; ++i)
+      size_t element = boundary ? grid.parent_element(block_begin + block_element) : block_begin + block_element;
+
+      for(size_t i = 0; i < n_element_nodes; ++i)
       {
-        for(size_t l = 0; l < equation.system_size(); ++l)
-        {  
-          float_t value = 0.0;
+        for(size_t l = 0; l < system_size; ++l)
+        {
+          const size_t local_index = (block_element * n_local + i * system_size + l) * n_local;
+          size_t row = system_size * grid.global_node_index(element, i) + l;
 
-          for(size_t k = 0; k < boundary_integrator_t::n_nodes; ++k)
-            value += equation.force_vector_at_boundary(l, i, k, kernel) *
-                 kernel.boundary_transform_determinant(k) *
-                 boundary_integrator.weight(k);
+          if(stiffness_matrix)
+          {
+            const float_t * local_matrix = & local_matrices[local_index];
+
+            if(assembly_map)
+            {
+              const AssemblyMap::offset_t * offsets = assembly_map->element_offsets(element) + (i * system_size + l) * n_local;
+              float_t * row_values = & stiffness_matrix->value_data()[stiffness_matrix->index1_data()[row]];
+
+              for(size_t j = 0; j < n_local; ++j)
+                row_values[offsets[j]] += local_matrix[j];
+            }
+            else if(use_positions)
+            {
+              const size_t * local_positions = & positions[local_index];
+
+              for(size_t j = 0; j < n_local; ++j)
+                stiffness_matrix->value_data()[local_positions[j]] += local_matrix[j];
+            }
+            else
+            {
+              for(size_t j = 0; j < n_element_nodes; ++j)
+                for(size_t m = 0; m < system_size; ++m)
+                  (*stiffness_matrix)(row, system_size * grid.global_node_index(element, j) + m) += local_matrix[j * system_size + m];
+            }
+          }
 
-          force_vector(equation.system_size() * grid.global_node_index(parent_element, i) + l) += value;
+          if(force_vector)
+            (*force_vector)(row) += local_vectors[block_element * n_local + i * system_size + l];
         }
       }
     }
-
   }
 }
 
@@ -0,0 +1,18 @@
+#include <fem/AssemblyMap.hpp>
+
+namespace imaging
+{
+  void AssemblyMap::clear_values(ublas::compressed_matrix<float_t> & stiffness_matrix)
+  {
+    std::fill(stiffness_matrix.value_data().begin(), stiffness_matrix.value_data().begin() + stiffness_matrix.nnz(), 0.0);
+  }
+  
+  bool AssemblyMap::is_compatible(const ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    return stiffness_matrix.size1() == _size &&
+           stiffness_matrix.size2() == _size &&
+           stiffness_matrix.nnz() == _n_non_zeros &&
+           stiffness_matrix.filled1() == _size + 1;
+  }
+}
+
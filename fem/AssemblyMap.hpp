@@ -0,0 +1,194 @@
+/*
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FEM_ASSEMBLYMAP_H
+#define FEM_ASSEMBLYMAP_H
+
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+
+#include <fem/Grid.hpp>
+
+
+namespace imaging
+{
+  /** \ingroup fem
+      \brief Maps the element stiffness matrices of a grid to the storage of a compressed stiffness matrix.
+
+      When the stiffness matrix is assembled by calling the accessor of \em ublas::compressed_matrix, each update of a matrix entry requires a binary search in the current row and possibly the insertion of a new entry. AssemblyMap performs this work once for a given grid (the <em>symbolic phase</em>). construct() computes the exact sparsity pattern of the stiffness matrix, allocates the stiffness matrix with this pattern and stores for each entry of each element stiffness matrix its position in the value array of the compressed matrix. Assembler::assemble() and Assembler::assemble_stiffness_matrix() accept an AssemblyMap and then add the element contributions directly to the value array of the matrix (the <em>numeric phase</em>).
+
+      The map remains valid as long as the connectivity of the grid and the sparsity pattern of the stiffness matrix do not change. This is typically the case in time stepping loops, where only the equation data changes from one step to the next:
+  \code
+  img::Grid<img::fem_2d_square_types> grid;
+  // construct grid...
+
+  img::ublas::compressed_matrix<img::float_t> stiffness_matrix;
+  img::AssemblyMap assembly_map;
+  assembly_map.construct(grid, stiffness_matrix);
+
+  for(std::size_t i = 0; i < n_steps; ++i)
+  {
+    assembler.assemble(equation, grid, assembly_map, stiffness_matrix, force_vector);
+    // solve...
+  }
+  \endcode
+
+      The position of an entry is stored relative to the beginning of its row in the compressed matrix to keep the map small (2 bytes per entry of each element stiffness matrix).
+  */
+  class AssemblyMap
+  {
+  public:
+    /** The type of the offset of an entry relative to the beginning of its row. */
+    typedef unsigned short offset_t;
+
+  private:
+    std::vector<offset_t> _element_offsets;
+    size_t _n_elements;
+    size_t _n_local_entries;
+    size_t _system_size;
+    size_t _size;
+    size_t _n_non_zeros;
+    boost::uint64_t _node_signature;
+
+  public:
+    /** Constructs an empty AssemblyMap. Call construct() before passing it to an assembly function. */
+    AssemblyMap() : _n_elements(0), _n_local_entries(0), _system_size(0), _size(0), _n_non_zeros(0), _node_signature(0) {}
+
+    /** Computes the sparsity pattern of the stiffness matrix of \em grid for a system of \em system_size equations. The matrix \em stiffness_matrix is resized and filled with zeros at exactly the positions which are touched by the elements of \em grid. Then the position of each entry of the element stiffness matrices in the storage of \em stiffness_matrix is computed and stored. This function must be called again if the connectivity of \em grid changes. */
+    template <class fem_types>
+    void construct(const Grid<fem_types> & grid, ublas::compressed_matrix<float_t> & stiffness_matrix, size_t system_size = 1);
+
+    /** Returns the number of equations the map was constructed for. */
+    size_t system_size() const { return _system_size; }
+
+    /** Returns the number of non-zero entries of the stiffness matrix the map was constructed for. */
+    size_t n_non_zeros() const { return _n_non_zeros; }
+
+    /** Returns true if the map was constructed for \em grid and a system of \em system_size equations and the sparsity pattern of \em stiffness_matrix has not been changed since. In addition to the dimensions the hash Grid::node_signature() of the global node indices of all elements is compared, such that maps of grids which have been reordered (Grid::reorder_nodes()) or reconstructed with the same dimensions are rejected. */
+    template <class fem_types>
+    bool is_compatible(const Grid<fem_types> & grid, const ublas::compressed_matrix<float_t> & stiffness_matrix, size_t system_size) const
+    {
+      return system_size == _system_size &&
+             grid.n_elements() == _n_elements &&
+             Grid<fem_types>::n_element_nodes * system_size * Grid<fem_types>::n_element_nodes * system_size == _n_local_entries &&
+             grid.n_nodes() * system_size == _size &&
+             is_compatible(stiffness_matrix) &&
+             grid.node_signature() == _node_signature;
+    }
+
+    /** Returns a pointer to the offsets of the element stiffness matrix of \em element. The offset of the entry (\em i, \em j) of the element matrix is stored at position <tt>i * n + j</tt>, where \em n is the number of rows of the element matrix. */
+    const offset_t * element_offsets(size_t element) const { return & _element_offsets[element * _n_local_entries]; }
+
+    /** Sets all values of \em stiffness_matrix to zero without changing its sparsity pattern. */
+    static void clear_values(ublas::compressed_matrix<float_t> & stiffness_matrix);
+
+  private:
+    bool is_compatible(const ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+  }
+  ;
+
+  template <class fem_types>
+  void AssemblyMap::construct(const Grid<fem_types> & grid, ublas::compressed_matrix<float_t> & stiffness_matrix, size_t system_size)
+  {
+    const size_t n_element_nodes = Grid<fem_types>::n_element_nodes;
+    const size_t n_local = n_element_nodes * system_size;
+    const size_t n_nodes = grid.n_nodes();
+
+    if(system_size == 0)
+      throw Exception("Exception: System size must be positive in AssemblyMap::construct().");
+
+    // collect the neighbours of each node
+    std::vector< std::vector<size_t> > neighbours(n_nodes);
+
+    for(size_t element = 0; element < grid.n_elements(); ++element)
+      for(size_t i = 0; i < n_element_nodes; ++i)
+        for(size_t j = 0; j < n_element_nodes; ++j)
+          neighbours[grid.global_node_index(element, i)].push_back(grid.global_node_index(element, j));
+
+    size_t n_non_zeros = 0;
+
+    for(size_t node = 0; node < n_nodes; ++node)
+    {
+      std::sort(neighbours[node].begin(), neighbours[node].end());
+      neighbours[node].erase(std::unique(neighbours[node].begin(), neighbours[node].end()), neighbours[node].end());
+
+      if(neighbours[node].size() * system_size > size_t(offset_t(-1)) + 1)
+        throw Exception("Exception: Too many non-zero entries per row in AssemblyMap::construct().");
+
+      n_non_zeros += neighbours[node].size() * system_size * system_size;
+    }
+
+    // allocate the stiffness matrix and write its sparsity pattern
+    const size_t size = n_nodes * system_size;
+    stiffness_matrix = ublas::compressed_matrix<float_t>(size, size, n_non_zeros);
+
+    ublas::compressed_matrix<float_t>::index_array_type & row_starts = stiffness_matrix.index1_data();
+    ublas::compressed_matrix<float_t>::index_array_type & columns = stiffness_matrix.index2_data();
+    ublas::compressed_matrix<float_t>::value_array_type & values = stiffness_matrix.value_data();
+
+    size_t entry = 0;
+    row_starts[0] = 0;
+
+    for(size_t node = 0; node < n_nodes; ++node)
+      for(size_t l = 0; l < system_size; ++l)
+      {
+        for(size_t k = 0; k < neighbours[node].size(); ++k)
+          for(size_t m = 0; m < system_size; ++m)
+          {
+            columns[entry] = system_size * neighbours[node][k] + m;
+            values[entry] = 0.0;
+            ++entry;
+          }
+
+        row_starts[system_size * node + l + 1] = entry;
+      }
+
+    stiffness_matrix.set_filled(size + 1, n_non_zeros);
+
+    // compute the positions of the element matrix entries
+    _n_elements = grid.n_elements();
+    _n_local_entries = n_local * n_local;
+    _system_size = system_size;
+    _size = size;
+    _n_non_zeros = n_non_zeros;
+    _node_signature = grid.node_signature();
+    _element_offsets.resize(_n_elements * _n_local_entries);
+
+    for(size_t element = 0; element < _n_elements; ++element)
+      for(size_t i = 0; i < n_element_nodes; ++i)
+        for(size_t l = 0; l < system_size; ++l)
+        {
+          size_t row = system_size * grid.global_node_index(element, i) + l;
+          ublas::compressed_matrix<float_t>::index_array_type::const_iterator row_begin = columns.begin() + row_starts[row];
+          ublas::compressed_matrix<float_t>::index_array_type::const_iterator row_end = columns.begin() + row_starts[row + 1];
+
+          for(size_t j = 0; j < n_element_nodes; ++j)
+            for(size_t m = 0; m < system_size; ++m)
+            {
+              size_t column = system_size * grid.global_node_index(element, j) + m;
+              _element_offsets[element * _n_local_entries + (i * system_size + l) * n_local + j * system_size + m] =
+                offset_t(std::lower_bound(row_begin, row_end, column) - row_begin);
+            }
+        }
+  }
+}
+
+
+#endif
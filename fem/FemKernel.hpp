@@ -27,6 +27,7 @@ namespace imaging
 {
 
   template<class fem_types> class Grid;
+  template<class fem_types> class GridGeometryCache;
 
   template<std::size_t M, std::size_t N>
   float_t transform_det(const ublas::fixed_matrix<float_t, M, N> & derivative)
@@ -34,6 +35,13 @@ namespace imaging
     return fabs(determinant(derivative));
   }
 
+  /** \ingroup fem
+      <tt>\#include <fem/FemKernel.hpp></tt>
+      
+      The slots of the buffered interpolation of vectors in FemKernel (cf. FemKernel::interpolated_value(std::size_t, const ublas::vector<float_t> &, std::size_t) const). An equation passes FIRST_GATHER_SLOT for the first vector it interpolates, SECOND_GATHER_SLOT for the second one and so forth. Each vector must be queried with the same slot on all elements, i.e. in evaluations of the stiffness matrix and of the force vector.
+  */
+  enum gather_slots { FIRST_GATHER_SLOT, SECOND_GATHER_SLOT, THIRD_GATHER_SLOT, FOURTH_GATHER_SLOT };
+
   /** \ingroup fem
       \brief Computes the values of the shape functions and the element transformation in the integration nodes. 
       
@@ -73,11 +81,35 @@ namespace imaging
     const Grid<fem_types> & _grid;
     std::size_t _current_element;
     std::size_t _current_boundary_element;
-
+    
   public:
+    /** The number of slots for the buffered interpolation of vectors (cf. interpolated_value(std::size_t, const ublas::vector<float_t> &, std::size_t) const and gather_slots). */
+    static const std::size_t N_GATHER_SLOTS = FOURTH_GATHER_SLOT + 1;
+    
+  private:
+    class GatherBuffer
+    {
+    public:
+      const ublas::vector<float_t> * _data;
+      std::size_t _element_serial;
+      ublas::fixed_vector<float_t, integrator_t::n_nodes> _values;
+      ublas::fixed_vector< ublas::fixed_vector<float_t, data_dimension>, integrator_t::n_nodes> _gradients;
+    };
+    
+    // the interpolations of the vectors which have been queried on the current element, one per slot;
+    // a buffer is valid if its serial is equal to _element_serial and it was computed from the queried vector
+    mutable GatherBuffer _gather_buffers[N_GATHER_SLOTS];
+    std::size_t _element_serial;
+    
+    const GatherBuffer & gather(const ublas::vector<float_t> & data, std::size_t slot) const;
 
+  public:
     /** Construct kernel from \em grid. The kernel object stores only a reference to the grid. When the kernel is later on set to an element by calling void set_element(std::size_t element) or set_boundary_element(std::size_t element) the argument \em element refers to \em grid. */
-    FemKernel(const Grid<fem_types> & grid) : _grid(grid) {}
+    FemKernel(const Grid<fem_types> & grid) : _grid(grid), _current_element(0), _current_boundary_element(0), _element_serial(1)
+    {
+      for(std::size_t i = 0; i < N_GATHER_SLOTS; ++i)
+        _gather_buffers[i]._element_serial = 0;
+    }
 
     /** Returns a reference to the grid, which was passed to kernel during construction. The kernel object stores only a reference to the grid. */
     const Grid<fem_types> & grid() const { return _grid; };
@@ -89,6 +121,10 @@ namespace imaging
     */
     void set_element(std::size_t element);
     
+    /** Initializes the kernel to \em element and copies the transform determinants and the gradients of the shape functions of \em element from \em geometry_cache. The values of the shape functions are computed on the reference element. The result is identical to set_element(std::size_t) but the element transform and its inverse are not evaluated. \em geometry_cache must have been constructed for the grid of the kernel (cf. GridGeometryCache::construct()).
+    */
+    void set_element(std::size_t element, const GridGeometryCache<fem_types> & geometry_cache);
+    
     /** Initializes the kernel to \em boundary_element, computes
           - the values and derivatives of the boundary shape functions and
           - the boundary element transform determinant (determinant of the Jacobian of the transform),
@@ -98,7 +134,7 @@ namespace imaging
 
     /** Initializes the kernel to \em element, but does \em not compute new values of the shape and transformation functions. Use this function if you know for sure that the geometry of the new element is exactly the same as the one of the previous element. As long as set_element() or lazy_set_element() are not called with a different parameter \em element, current_element() will return \em element.
     */
-    void lazy_set_element(std::size_t element) { _current_element = element; }
+    void lazy_set_element(std::size_t element) { _current_element = element; ++_element_serial; }
 
     /** Returns the value of the shape function assciated with \em element_node in the integration node \em integrator_node. */
     float_t shape_value(std::size_t integrator_node, std::size_t element_node) const
@@ -111,6 +147,23 @@ namespace imaging
     /** Returns the value of the transformation determinant (determinant of the Jacobian of the transform) in the integration node \em integrator_node. This value reflects the distortion of the actual element with respect to its reference element. Note that \em integrator_node refers to the corresponding node of the \em boundary integrator. */
     float_t transform_determinant(std::size_t integrator_node) const
       { return _transform_determinants(integrator_node); }
+      
+    /** Returns the interpolation of \em data in the integration node \em integrator_node of the current element. The vector \em data has the size Grid::n_nodes() and contains the values of a scalar function in the nodes of the grid. The result is identical to Grid::interpolate_value(). */
+    float_t interpolated_value(std::size_t integrator_node, const ublas::vector<float_t> & data) const;
+      
+    /** Returns the gradient of the interpolation of \em data in the integration node \em integrator_node of the current element. The result is identical to Grid::interpolate_gradient(). */
+    ublas::fixed_vector<float_t, fem_types::data_dimension> interpolated_gradient(std::size_t integrator_node, const ublas::vector<float_t> & data) const;
+    
+    /** Returns the interpolation of \em data in the integration node \em integrator_node of the current element as interpolated_value(std::size_t, const ublas::vector<float_t> &) const, but the values of \em data in the element nodes are gathered only once per element: on the first query of \em slot on the current element, the kernel interpolates \em data and its gradient in all integration nodes and stores the results in the buffer \em slot. Subsequent queries of \em slot with the same vector on the same element (e.g. for each pair of element nodes in the assembly of the stiffness matrix) only read the buffer. The buffers are invalidated by set_element() and lazy_set_element().
+    
+        The caller chooses a separate slot (see gather_slots) for each vector it queries. If a slot is queried with another vector than before on the same element, the buffer is recomputed. The contents of \em data must not change while the kernel is set to the same element. This is the case for vectors which are members of an equation during the assembly. Throws an Exception if \em slot is out of range.
+    */
+    float_t interpolated_value(std::size_t integrator_node, const ublas::vector<float_t> & data, std::size_t slot) const
+      { return gather(data, slot)._values(integrator_node); }
+      
+    /** Returns the gradient of the interpolation of \em data in the integration node \em integrator_node of the current element. The values are buffered in \em slot as described for interpolated_value(std::size_t, const ublas::vector<float_t> &, std::size_t) const. */
+    ublas::fixed_vector<float_t, fem_types::data_dimension> interpolated_gradient(std::size_t integrator_node, const ublas::vector<float_t> & data, std::size_t slot) const
+      { return gather(data, slot)._gradients(integrator_node); }
   
     /** Returns the value of shape function associated with \em element_node on the parent element of the current boundary element in the integration node \em integrator_node on the boundary element. This means that the shape function <em>on the element</em> is evaluated <em>at the boundary</em> of the element. Keep in mind that here the element is \em not the current element but the parent element of the current boundary element. I.e. this function depends only on the current boundary element. Note that \em integrator_node refers to the corresponding node of the \em boundary integrator. */  
     float_t shape_boundary_value(std::size_t integrator_node, std::size_t element_node) const
@@ -142,6 +195,9 @@ namespace imaging
   }
   ;
 
+  template <class fem_types>
+  const std::size_t FemKernel<fem_types>::N_GATHER_SLOTS;
+
   template <class fem_types>
   void FemKernel<fem_types>::set_element(std::size_t element)
   {
@@ -150,6 +206,7 @@ namespace imaging
     integrator_t integrator;
 
     _current_element = element;
+    ++_element_serial;
 
     _grid.element_transform(element, transform);
 
@@ -175,6 +232,91 @@ namespace imaging
 
 
 
+  template <class fem_types>
+  void FemKernel<fem_types>::set_element(std::size_t element, const GridGeometryCache<fem_types> & geometry_cache)
+  {
+    shape_function_t shape_function;
+    integrator_t integrator;
+    
+    const float_t * determinants = geometry_cache.transform_determinants(element);
+    const float_t * gradients = geometry_cache.shape_gradients(element);
+
+    _current_element = element;
+    ++_element_serial;
+
+    for(std::size_t integrator_node = 0; integrator_node < integrator_t::n_nodes; ++integrator_node)
+    {
+      _transform_determinants(integrator_node) = determinants[integrator_node];
+
+      for(std::size_t element_node = 0; element_node < n_element_nodes; ++element_node)
+      {
+        _shape_values(integrator_node)(element_node) = shape_function.value(element_node, integrator.node(integrator_node));
+        
+        for(std::size_t d = 0; d < data_dimension; ++d)
+          _shape_gradients(integrator_node)(element_node)(d) = gradients[(integrator_node * n_element_nodes + element_node) * data_dimension + d];
+      }
+    }
+  }
+
+  template <class fem_types>
+  float_t FemKernel<fem_types>::interpolated_value(std::size_t integrator_node, const ublas::vector<float_t> & data) const
+  {
+    float_t value = 0.0;
+    
+    for(std::size_t element_node = 0; element_node < n_element_nodes; ++element_node)
+      value += data(_grid.global_node_index(_current_element, element_node)) * _shape_values(integrator_node)(element_node);
+      
+    return value;
+  }
+
+  template <class fem_types>
+  ublas::fixed_vector<float_t, fem_types::data_dimension> FemKernel<fem_types>::interpolated_gradient(std::size_t integrator_node, const ublas::vector<float_t> & data) const
+  {
+    ublas::fixed_vector<float_t, data_dimension> gradient(0.0);
+    
+    for(std::size_t element_node = 0; element_node < n_element_nodes; ++element_node)
+      gradient += data(_grid.global_node_index(_current_element, element_node)) * _shape_gradients(integrator_node)(element_node);
+      
+    return gradient;
+  }
+
+  template <class fem_types>
+  const typename FemKernel<fem_types>::GatherBuffer & FemKernel<fem_types>::gather(const ublas::vector<float_t> & data, std::size_t slot) const
+  {
+    if(slot >= N_GATHER_SLOTS)
+      throw Exception("Exception: Invalid gather slot in FemKernel::interpolated_value().");
+      
+    GatherBuffer & buffer = _gather_buffers[slot];
+    
+    if(buffer._element_serial == _element_serial && buffer._data == & data)
+      return buffer;
+    
+    ublas::fixed_vector<float_t, n_element_nodes> node_values;
+    
+    for(std::size_t element_node = 0; element_node < n_element_nodes; ++element_node)
+      node_values(element_node) = data(_grid.global_node_index(_current_element, element_node));
+    
+    for(std::size_t integrator_node = 0; integrator_node < integrator_t::n_nodes; ++integrator_node)
+    {
+      float_t & value = buffer._values(integrator_node);
+      ublas::fixed_vector<float_t, data_dimension> & gradient = buffer._gradients(integrator_node);
+      
+      value = 0.0;
+      gradient.assign(0.0);
+      
+      for(std::size_t element_node = 0; element_node < n_element_nodes; ++element_node)
+      {
+        value += node_values(element_node) * _shape_values(integrator_node)(element_node);
+        gradient += node_values(element_node) * _shape_gradients(integrator_node)(element_node);
+      }
+    }
+    
+    buffer._data = & data;
+    buffer._element_serial = _element_serial;
+    
+    return buffer;
+  }
+
   template <class fem_types>
   void FemKernel<fem_types>::set_boundary_element(std::size_t element)
   {
@@ -21,10 +21,11 @@
 #define GRID_H
 
 #include <vector>
-#include <map>
-#include <set>
+#include <boost/cstdint.hpp>
 
 #include <fem/FemKernel.hpp>
+#include <fem/RegularGrid.hpp>
+#include <fem/node_ordering.hpp>
 #include <fem/fem_3d_tetrahedra_types.hpp>
 #include <fem/fem_2d_triangle_types.hpp>
 #include <fem/fem_1d_types.hpp>
@@ -60,6 +61,11 @@ namespace imaging
     class BoundaryElement
     {
     public:
+      // the parent element of a boundary element which has not been set yet
+      static const size_t UNSET = size_t(-1);
+      
+      BoundaryElement() : _parent_element(UNSET), _parent_element_face(0) {}
+      
       size_t _parent_element;
       size_t _parent_element_face;
       ublas::fixed_vector<float_t, fem_types::data_dimension> _normal;
@@ -101,87 +107,204 @@ namespace imaging
     std::vector<element_vertices_t> _element_vertices;
     std::vector<element_nodes_t> _element_nodes;
     std::vector<BoundaryElement> _boundary_elements;
-    std::multimap<size_t, size_t> _boundary_node_boundary_elements;
-    std::set<size_t> _boundary_nodes;
+    
+    // one bit per node which is set for boundary nodes
+    static const size_t BITS_PER_WORD = 32;
+    std::vector<boost::uint32_t> _boundary_node_bits;
+    // the number of boundary nodes with a smaller index than the first node of each word of _boundary_node_bits
+    std::vector<size_t> _boundary_node_ranks;
+    // the unit normals of the boundary nodes in the order of their indices
+    std::vector<vertex_t> _boundary_node_normals;
+    size_t _n_boundary_nodes;
+    size_t _n_unset_boundary_elements;
+    
+    std::vector<size_t> _node_permutation;
 
     size_t _n_nodes;
 
     bool _is_regular;
+    
+    RegularGrid<fem_types> _implicit_grid;
+    bool _is_implicit;
+    
+    // a hash of the global node indices of all elements which is computed on demand by node_signature()
+    mutable boost::uint64_t _node_signature;
+    mutable bool _is_node_signature_valid;
+    
+    void check_explicit(const char * function) const
+    {
+      if(_is_implicit)
+        throw Exception("Exception: Implicit grids can not be modified in Grid::" + std::string(function) + "().");
+    }
+    
+    static size_t bit_count(boost::uint32_t word)
+    {
+      word = word - ((word >> 1) & 0x55555555);
+      word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+      return (((word + (word >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+    }
+    
+    // the position of the boundary node 'global_node_index' in _boundary_node_normals
+    size_t boundary_node_rank(size_t global_node_index) const
+    {
+      size_t word = global_node_index / BITS_PER_WORD;
+      boost::uint32_t lower_bits = (boost::uint32_t(1) << (global_node_index % BITS_PER_WORD)) - 1;
+      
+      return _boundary_node_ranks[word] + bit_count(_boundary_node_bits[word] & lower_bits);
+    }
+    
+    void mark_boundary_node(size_t global_node_index)
+    {
+      boost::uint32_t & word = _boundary_node_bits[global_node_index / BITS_PER_WORD];
+      boost::uint32_t bit = boost::uint32_t(1) << (global_node_index % BITS_PER_WORD);
+      
+      if(! (word & bit))
+      {
+        word |= bit;
+        ++_n_boundary_nodes;
+      }
+    }
+    
+    // sums the normals of the boundary elements at each boundary node
+    void update_boundary_normals()
+    {
+      _boundary_node_ranks.resize(_boundary_node_bits.size());
+      
+      size_t rank = 0;
+      for(size_t i = 0; i < _boundary_node_bits.size(); ++i)
+      {
+        _boundary_node_ranks[i] = rank;
+        rank += bit_count(_boundary_node_bits[i]);
+      }
+      
+      _boundary_node_normals.assign(_n_boundary_nodes, vertex_t(0.0));
+      
+      for(size_t i = 0; i < _boundary_elements.size(); ++i)
+        for(size_t j = 0; j < shape_function_t::n_shape_face_nodes; ++j)
+          _boundary_node_normals[boundary_node_rank(global_node_index(_boundary_elements[i]._parent_element, shape_function_t::face_node(_boundary_elements[i]._parent_element_face, j)))] += _boundary_elements[i]._normal;
+          
+      for(size_t i = 0; i < _boundary_node_normals.size(); ++i)
+        _boundary_node_normals[i] /= norm_2(_boundary_node_normals[i]);
+    }
 
   public:
+    /** The node orderings which can be applied by reorder_nodes(). */
+    enum node_orderings { REVERSE_CUTHILL_MCKEE_ORDERING, MORTON_ORDERING };
     
     /** Default constructor. */
-    Grid() : _n_nodes(0), _is_regular(false) {}
+    Grid() : _n_boundary_nodes(0), _n_unset_boundary_elements(0), _n_nodes(0), _is_regular(false), _is_implicit(false), _node_signature(0), _is_node_signature_valid(false) {}
 
     /** Returns the number of elements of the grid (excluding boundary elements). */
-    size_t n_elements() const { return _element_vertices.size(); }
+    size_t n_elements() const { return _is_implicit ? _implicit_grid.n_elements() : _element_vertices.size(); }
     
     /** Returns the number of element vertices of the grid. In case there is exactly shape function one per element vertex this equals the number of nodes. */
-    size_t n_vertices() const { return _vertices.size(); }
+    size_t n_vertices() const { return _is_implicit ? _implicit_grid.n_vertices() : _vertices.size(); }
     
     /** Returns the number of element nodes of this grid. The number of element nodes equals the number of degrees of freedom of FE discretization of a scalar PDE on this grid. For a system of equations this number has to be multiplied by the number of equations to obtain the total number of degrees of freedom. */
     size_t n_nodes() const { return _n_nodes; }
     
     /** Returns the number of nodes which are at the boundary of the grid. The equations for these nodes will be influenced by boundary conditions. */
-    size_t n_boundary_nodes() const { return _boundary_nodes.size(); }
+    size_t n_boundary_nodes() const { return _is_implicit ? _implicit_grid.n_boundary_vertices() : _n_boundary_nodes; }
     
     /** Returns the number of boundary elements, i.e. those boundary elements of parent elements which are at the actual boundary of the grid. */
-    size_t n_boundary_elements() const { return _boundary_elements.size(); }
+    size_t n_boundary_elements() const { return _is_implicit ? _implicit_grid.n_boundary_elements() : _boundary_elements.size(); }
     
     /** Sets the vertex with global index \em global_vertex_index to \em vertex. */
-    void set_vertex(size_t global_vertex_index, const vertex_t & vertex) { _vertices[global_vertex_index] = vertex; }
+    void set_vertex(size_t global_vertex_index, const vertex_t & vertex) { check_explicit("set_vertex"); _vertices[global_vertex_index] = vertex; }
     
-    /** Returns a const reference to the vertex with global index \em global_vertex_index. */
-    const vertex_t & vertex(size_t global_vertex_index) const { return _vertices[global_vertex_index]; }
+    /** Returns the vertex with global index \em global_vertex_index. */
+    const vertex_t vertex(size_t global_vertex_index) const { return _is_implicit ? _implicit_grid.vertex(global_vertex_index) : _vertices[global_vertex_index]; }
     
     /** Sets the vertex with index \em vertex_index on the element \em element_index to \em vertex. */
-    void set_vertex(size_t element_index, size_t vertex_index, const vertex_t & vertex) { _vertices[global_vertex_index(element_index, vertex_index)] = vertex; }
+    void set_vertex(size_t element_index, size_t vertex_index, const vertex_t & vertex) { check_explicit("set_vertex"); _vertices[global_vertex_index(element_index, vertex_index)] = vertex; }
     
-    /** Returns a const reference to the vertex with index \em vertex_index on the element \em element_index. */
-    const vertex_t & vertex(size_t element_index, size_t vertex_index) const { return _vertices[global_vertex_index(element_index, vertex_index)]; }
+    /** Returns the vertex with index \em vertex_index on the element \em element_index. */
+    const vertex_t vertex(size_t element_index, size_t vertex_index) const { return vertex(global_vertex_index(element_index, vertex_index)); }
     
     /** Returns the global vertex index of the node with index \em vertex_index on the element \em element_index. This index corresponds to the index of the vertex coordinates in the vertex coordinate list stored by the Grid object. */
-    size_t global_vertex_index(size_t element_index, size_t vertex_index) const { return _element_vertices[element_index](vertex_index); }
+    size_t global_vertex_index(size_t element_index, size_t vertex_index) const
+    {
+      return _is_implicit ? _implicit_grid.global_vertex_index(element_index, vertex_index) : _element_vertices[element_index](vertex_index);
+    }
     
     /** Sets the global vertex index of the vertex with index \em vertex_index on the element \em element_index. This index corresponds to the index of the vertex coordinates in the vertex coordinate list stored by the Grid object. */
-    void set_global_vertex_index(size_t element_index, size_t vertex_index, size_t global_vertex_index) { _element_vertices[element_index](vertex_index) = global_vertex_index; }
+    void set_global_vertex_index(size_t element_index, size_t vertex_index, size_t global_vertex_index) { check_explicit("set_global_vertex_index"); _element_vertices[element_index](vertex_index) = global_vertex_index; }
     
     /** Returns the global node index of the node with index \em node_index on the element \em element_index. This index corresponds to the position of the node in the stiffness matrix and the force vector of the associated FE problem. */
-    size_t global_node_index(size_t element_index, size_t node_index) const { return _element_nodes[element_index](node_index); }
+    size_t global_node_index(size_t element_index, size_t node_index) const
+    {
+      return _is_implicit ? _implicit_grid.global_vertex_index(element_index, node_index) : _element_nodes[element_index](node_index);
+    }
     
     /** Sets the global node index of the node with index \em node_index on the element \em element_index. This index corresponds to the position of the node in the stiffness matrix and the force vector of the associated FE problem. */
-    void set_global_node_index(size_t element_index, size_t node_index, size_t global_node_index) { _element_nodes[element_index](node_index) = global_node_index; }
+    void set_global_node_index(size_t element_index, size_t node_index, size_t global_node_index) { check_explicit("set_global_node_index"); _element_nodes[element_index](node_index) = global_node_index; _is_node_signature_valid = false; }
     
-    /** Sets the boundary element \em boundary_element_index. Note that the nodes on the boundary element are \em not automatically set to be boundary nodes; the user has to do this manually during grid construction. */
+    /** Returns a hash of the global node indices of all elements. The hash is computed when it is requested for the first time after the element nodes have been changed and is cached until the next change. AssemblyMap compares it to check whether it belongs to the grid. */
+    boost::uint64_t node_signature() const
+    {
+      #pragma omp critical(grid_node_signature)
+      {
+        if(! _is_node_signature_valid)
+        {
+          boost::uint64_t signature = UINT64_C(14695981039346656037);
+          
+          for(size_t element = 0; element < n_elements(); ++element)
+            for(size_t i = 0; i < n_element_nodes; ++i)
+              signature = (signature ^ global_node_index(element, i)) * UINT64_C(1099511628211);
+              
+          _node_signature = signature;
+          _is_node_signature_valid = true;
+        }
+      }
+      
+      return _node_signature;
+    }
+    
+    /** Sets the boundary element \em boundary_element_index. The nodes on the face \em parent_element_face of the parent element become boundary nodes. Thus the parent element and its vertices must be set before. Once all boundary elements have been set the boundary normals of the boundary nodes are computed. Setting a boundary element again after this point recomputes all normals. */
     void set_boundary_element(size_t boundary_element_index, size_t parent_element_index, size_t parent_element_face)
     { 
+      check_explicit("set_boundary_element");
+      
       transform_t transform;
-      ublas::fixed_vector<float_t, fem_types::data_dimension - 1> in;
       vertex_t out;
       element_transform(parent_element_index, transform);
       transform.boundary_normal(parent_element_face, out);
       
-      _boundary_elements[boundary_element_index]._parent_element = parent_element_index; 
-      _boundary_elements[boundary_element_index]._parent_element_face = parent_element_face;
-      _boundary_elements[boundary_element_index]._normal = out;
+      BoundaryElement & boundary_element = _boundary_elements[boundary_element_index];
+      
+      if(boundary_element._parent_element == BoundaryElement::UNSET)
+        --_n_unset_boundary_elements;
+      
+      boundary_element._parent_element = parent_element_index; 
+      boundary_element._parent_element_face = parent_element_face;
+      boundary_element._normal = out;
       
       for(size_t i = 0; i < shape_function_t::n_shape_face_nodes; ++i)
-      {
-        _boundary_nodes.insert(global_node_index(parent_element_index, shape_function_t::face_node(parent_element_face, i)));
-        _boundary_node_boundary_elements.insert(std::pair<size_t, size_t>(global_node_index(parent_element_index, shape_function_t::face_node(parent_element_face, i)), boundary_element_index));
-      }
+        mark_boundary_node(global_node_index(parent_element_index, shape_function_t::face_node(parent_element_face, i)));
+      
+      if(_n_unset_boundary_elements == 0)
+        update_boundary_normals();
     }
     
     /** Returns the index of the parent element of the boundary element \em boundary_element_index.*/
-    size_t parent_element(size_t boundary_element_index) const { return _boundary_elements[boundary_element_index]._parent_element; }
+    size_t parent_element(size_t boundary_element_index) const
+    {
+      return _is_implicit ? _implicit_grid.parent_element(boundary_element_index) : _boundary_elements[boundary_element_index]._parent_element;
+    }
     
     /** Returns the index of the face of the parent element of the boundary element \em boundary_element_index.*/
-    size_t parent_element_face(size_t boundary_element_index) const { return _boundary_elements[boundary_element_index]._parent_element_face; }
+    size_t parent_element_face(size_t boundary_element_index) const
+    {
+      return _is_implicit ? _implicit_grid.parent_element_face(boundary_element_index) : _boundary_elements[boundary_element_index]._parent_element_face;
+    }
     
     /** Returns true if the node \em global_node_index lies at the boundary of the grid. */
     bool is_boundary_node(size_t global_node_index) const
     {
-      return (_boundary_nodes.count(global_node_index) > 0);
+      if(_is_implicit)
+        return _implicit_grid.is_boundary_vertex(global_node_index);
+        
+      return (_boundary_node_bits[global_node_index / BITS_PER_WORD] >> (global_node_index % BITS_PER_WORD)) & 1;
     }
     
     /** Returns true if the node \em node_index on the element \em element_index lies at the boundary of the grid. */
@@ -190,21 +313,19 @@ namespace imaging
       return is_boundary_node(global_node_index(element_index, node_index));
     }
     
-    /** Returns the unit boundary normal of the node \em global_node_index. If the node happens not to be a boundary node an Exception is thrown. */
+    /** Returns the unit boundary normal of the node \em global_node_index, i.e. the normalized sum of the normals of the boundary elements which contain the node. If the node happens not to be a boundary node or if not all boundary elements have been set an Exception is thrown. */
     const vertex_t boundary_normal(size_t global_node_index) const
     { 
-      if( ! _boundary_node_boundary_elements.count(global_node_index))
+      if(_is_implicit)
+        return _implicit_grid.boundary_normal(global_node_index);
+        
+      if(! is_boundary_node(global_node_index))
         throw Exception("Invalid argument 'node' in Grid::boundary_normal().");
         
-      std::pair< std::multimap<size_t, size_t>::const_iterator, std::multimap<size_t, size_t>::const_iterator > boundary_elements = _boundary_node_boundary_elements.equal_range(global_node_index);
-      
-      std::multimap<size_t, size_t>::const_iterator iter = boundary_elements.first;
-      
-      vertex_t result(0.0);
-      for( ; iter != boundary_elements.second; ++iter)
-        result += _boundary_elements[iter->second]._normal;
+      if(_n_unset_boundary_elements > 0)
+        throw Exception("Exception: Not all boundary elements have been set in Grid::boundary_normal().");
       
-      return result / norm_2(result);
+      return _boundary_node_normals[boundary_node_rank(global_node_index)];
     }
   
     /** Returns the unit boundary normal of the node \em node_index on the element \em element_index. If the node happens not to be a boundary node an Exception is thrown. */
@@ -218,23 +339,73 @@ namespace imaging
     
     /** Returns true if the grid is regular, i.e. the geometry of each of its elements is the identical modulo rigid transformation. Marking a grid as regular speeds up the assembly of the stiffness matrix and the force vector. Prominent examples of regular grids are pixel and voxel discretizations. */
     bool is_regular() const { return _is_regular; }
+    
+    /** Replaces the vertices, elements and boundary elements of the grid by the implicit description \em regular_grid. The grid then stores no vertex, element or boundary tables; all these are computed from the indices by \em regular_grid on demand. The grid is marked as regular. Calls to the functions which modify the grid (e.g. set_vertex()) throw an Exception until set_dimensions() is called. This is only possible for element types which are supported by RegularGrid.
+    
+        \sa Image2Grid::construct_implicit_grid()
+    */
+    void set_implicit(const RegularGrid<fem_types> & regular_grid)
+    {
+      std::vector<vertex_t>().swap(_vertices);
+      std::vector<element_vertices_t>().swap(_element_vertices);
+      std::vector<element_nodes_t>().swap(_element_nodes);
+      std::vector<BoundaryElement>().swap(_boundary_elements);
+      std::vector<boost::uint32_t>().swap(_boundary_node_bits);
+      std::vector<size_t>().swap(_boundary_node_ranks);
+      std::vector<vertex_t>().swap(_boundary_node_normals);
+      _n_boundary_nodes = 0;
+      _n_unset_boundary_elements = 0;
+      _node_permutation.clear();
+      
+      _implicit_grid = regular_grid;
+      _n_nodes = regular_grid.n_vertices();
+      _is_implicit = true;
+      _is_regular = true;
+      _is_node_signature_valid = false;
+    }
+    
+    /** Returns true if the grid has been set to an implicit RegularGrid by set_implicit(). */
+    bool is_implicit() const { return _is_implicit; }
+    
+    /** Renumbers the nodes of the grid according to \em ordering and sorts the elements by their smallest node index. The reverse Cuthill-McKee ordering (REVERSE_CUTHILL_MCKEE_ORDERING) minimizes the bandwidth of the stiffness matrix and thus the fill-in of direct solvers such as LuSolver. The Morton ordering (MORTON_ORDERING) numbers the nodes along a space-filling curve through their positions. Both improve the cache locality of the assembly and of matrix-vector products compared to a row-by-row or arbitrary numbering of the nodes.
+    
+        If the vertex indices of the grid coincide with its node indices (as for all grids with linear or bilinear shape functions constructed in this library), the vertices are renumbered as well. Boundary elements keep their indices. The applied permutation is accumulated in node_permutation(). Vectors of node values, stiffness matrix prototypes, AssemblyMap and GridGeometryCache objects which were computed for the grid before it was reordered become invalid. Implicit grids can not be reordered.
+        
+        \sa Image2Grid::set_node_permutation()
+    */
+    void reorder_nodes(node_orderings ordering = REVERSE_CUTHILL_MCKEE_ORDERING);
+    
+    /** Returns the permutation of the node indices applied by reorder_nodes(), i.e. <tt>node_permutation()[i]</tt> is the current index of the node which had the index \em i when the grid was constructed. The permutation is empty if the nodes have not been reordered. */
+    const std::vector<size_t> & node_permutation() const { return _node_permutation; }
 
     /** Sets the dimensions of the grid. The parameters refer to the \em total numbers of vertices, elements, boundary elements and nodes, respectively. Note that vertices or nodes which belong to more than one element are only counted once. */
     void set_dimensions(size_t n_vertices, size_t n_elements, size_t n_boundary_elements, size_t n_nodes)
     {
+      _is_implicit = false;
+      _implicit_grid = RegularGrid<fem_types>();
+      
       _vertices.resize(n_vertices);
       _element_vertices.resize(n_elements);
       _element_nodes.resize(n_elements);
-      _boundary_elements.resize(n_boundary_elements);
+      _boundary_elements.assign(n_boundary_elements, BoundaryElement());
+      
+      _boundary_node_bits.assign((n_nodes + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+      _n_boundary_nodes = 0;
+      _n_unset_boundary_elements = n_boundary_elements;
+      _node_permutation.clear();
+      _is_node_signature_valid = false;
 
       _n_nodes = n_nodes;
+      
+      if(n_boundary_elements == 0)
+        update_boundary_normals();
     }
 
     /** Initializes the element transformation \em transform to the element \em element_index. */
     void element_transform(size_t element_index, transform_t & transform) const
     {
       for(size_t i = 0; i < n_element_vertices; ++i)
-        transform.assign(i, _vertices[global_vertex_index(element_index, i)]);
+        transform.assign(i, vertex(global_vertex_index(element_index, i)));
     }
     
     /** Interpolates \em data in \em integrator_node on the current element of \em kernel. The result is written to \em value. 
@@ -293,7 +464,7 @@ namespace imaging
     void interpolate_boundary_value(size_t boundary_integrator_node, const ublas::mapped_vector<float_t> & data, const FemKernel<fem_types> & kernel, float_t & value) const
     { 
       value = 0.0;
-      size_t parent_element = _boundary_elements[kernel.current_boundary_element()]._parent_element;
+      size_t parent_element = this->parent_element(kernel.current_boundary_element());
 
       for(size_t i = 0; i < n_element_nodes; ++i)
         value += data(global_node_index(parent_element, i)) * kernel.shape_boundary_value(boundary_integrator_node, i);
@@ -306,7 +477,7 @@ namespace imaging
     void interpolate_boundary_value(size_t boundary_integrator_node, const ublas::mapped_vector<float_t> & data, const FemKernel<fem_types> & kernel, ublas::fixed_vector<float_t, N> & value) const
     { 
       value.assign(0.0);
-      size_t parent_element = _boundary_elements[kernel.current_boundary_element()]._parent_element;
+      size_t parent_element = this->parent_element(kernel.current_boundary_element());
 
       for(size_t i = 0; i < n_element_nodes; ++i)
         for(size_t j = 0; j < N; ++j)
@@ -319,7 +490,7 @@ namespace imaging
     void interpolate_boundary_derivative(size_t boundary_integrator_node, const ublas::mapped_vector<float_t> & data, const FemKernel<fem_types> & kernel, float_t & value) const
     { 
       value = 0.0;
-      size_t parent_element = _boundary_elements[kernel.current_boundary_element()]._parent_element;
+      size_t parent_element = this->parent_element(kernel.current_boundary_element());
 
       for(size_t i = 0; i < n_element_nodes; ++i)
         value += data(global_node_index(parent_element, i)) * kernel.shape_boundary_derivative(boundary_integrator_node, i);
@@ -332,7 +503,7 @@ namespace imaging
     void interpolate_boundary_derivative(size_t boundary_integrator_node, const ublas::mapped_vector<float_t> & data, const FemKernel<fem_types> & kernel, ublas::fixed_vector<float_t, N> & value) const
     { 
       value.assign(0.0);
-      size_t parent_element = _boundary_elements[kernel.current_boundary_element()]._parent_element;
+      size_t parent_element = this->parent_element(kernel.current_boundary_element());
       
       for(size_t i = 0; i < n_element_nodes; ++i)
         for(size_t j = 0; j < N; ++j)
@@ -356,6 +527,153 @@ namespace imaging
 //     }
   }
   ;
+  
+  template <class fem_types>
+  void Grid<fem_types>::reorder_nodes(node_orderings ordering)
+  {
+    check_explicit("reorder_nodes");
+    
+    const size_t n_elements = _element_nodes.size();
+    std::vector<size_t> permutation;
+    
+    if(ordering == REVERSE_CUTHILL_MCKEE_ORDERING)
+    {
+      // the adjacency of the nodes in compressed row storage
+      std::vector<size_t> offsets(_n_nodes + 1, 0);
+      
+      for(size_t e = 0; e < n_elements; ++e)
+        for(size_t i = 0; i < n_element_nodes; ++i)
+          offsets[_element_nodes[e](i) + 1] += n_element_nodes - 1;
+          
+      for(size_t i = 0; i < _n_nodes; ++i)
+        offsets[i + 1] += offsets[i];
+        
+      std::vector<size_t> neighbours(offsets[_n_nodes]);
+      std::vector<size_t> ends(offsets.begin(), offsets.end() - 1);
+      
+      for(size_t e = 0; e < n_elements; ++e)
+        for(size_t i = 0; i < n_element_nodes; ++i)
+          for(size_t j = 0; j < n_element_nodes; ++j)
+            if(i != j)
+              neighbours[ends[_element_nodes[e](i)]++] = _element_nodes[e](j);
+      
+      // remove the duplicate neighbours of each node
+      size_t n_neighbours = 0;
+      
+      for(size_t i = 0; i < _n_nodes; ++i)
+      {
+        std::vector<size_t>::iterator begin = neighbours.begin() + offsets[i];
+        std::vector<size_t>::iterator end = neighbours.begin() + ends[i];
+        
+        std::sort(begin, end);
+        end = std::unique(begin, end);
+        
+        offsets[i] = n_neighbours;
+        n_neighbours = std::copy(begin, end, neighbours.begin() + n_neighbours) - neighbours.begin();
+      }
+      
+      offsets[_n_nodes] = n_neighbours;
+      neighbours.resize(n_neighbours);
+      
+      reverse_cuthill_mckee_ordering(offsets, neighbours, permutation);
+    }
+    else if(ordering == MORTON_ORDERING)
+    {
+      // nodes which are no element vertices are placed at the center of their element
+      std::vector<vertex_t> positions(_n_nodes, vertex_t(0.0));
+      
+      for(size_t e = 0; e < n_elements; ++e)
+      {
+        vertex_t center(0.0);
+        for(size_t i = 0; i < n_element_vertices; ++i)
+          center += vertex(global_vertex_index(e, i));
+        center /= float_t(n_element_vertices);
+        
+        for(size_t i = 0; i < n_element_nodes; ++i)
+          positions[_element_nodes[e](i)] = i < n_element_vertices ? vertex(global_vertex_index(e, i)) : center;
+      }
+      
+      morton_ordering(positions, permutation);
+    }
+    else
+      throw Exception("Exception: Unknown node ordering in Grid::reorder_nodes().");
+      
+    // check if the vertices are numbered like the nodes
+    bool is_node_numbering = (_vertices.size() == _n_nodes);
+    
+    for(size_t e = 0; e < n_elements && is_node_numbering; ++e)
+      for(size_t i = 0; i < std::min(n_element_vertices, n_element_nodes); ++i)
+        if(_element_vertices[e](i) != _element_nodes[e](i))
+          is_node_numbering = false;
+    
+    for(size_t e = 0; e < n_elements; ++e)
+      for(size_t i = 0; i < n_element_nodes; ++i)
+        _element_nodes[e](i) = permutation[_element_nodes[e](i)];
+        
+    if(is_node_numbering)
+    {
+      std::vector<vertex_t> vertices(_vertices.size());
+      
+      for(size_t i = 0; i < _vertices.size(); ++i)
+        vertices[permutation[i]] = _vertices[i];
+        
+      _vertices.swap(vertices);
+      
+      for(size_t e = 0; e < n_elements; ++e)
+        for(size_t i = 0; i < n_element_vertices; ++i)
+          _element_vertices[e](i) = permutation[_element_vertices[e](i)];
+    }
+    
+    // sort the elements by their smallest node index
+    std::vector< std::pair<size_t, size_t> > element_keys(n_elements);
+    
+    for(size_t e = 0; e < n_elements; ++e)
+      element_keys[e] = std::pair<size_t, size_t>(*std::min_element(_element_nodes[e].begin(), _element_nodes[e].end()), e);
+      
+    std::sort(element_keys.begin(), element_keys.end());
+    
+    std::vector<size_t> element_permutation(n_elements);
+    std::vector<element_vertices_t> element_vertices(n_elements);
+    std::vector<element_nodes_t> element_nodes(n_elements);
+    
+    for(size_t e = 0; e < n_elements; ++e)
+    {
+      element_permutation[element_keys[e].second] = e;
+      element_vertices[e] = _element_vertices[element_keys[e].second];
+      element_nodes[e] = _element_nodes[element_keys[e].second];
+    }
+    
+    _element_vertices.swap(element_vertices);
+    _element_nodes.swap(element_nodes);
+    _is_node_signature_valid = false;
+    
+    // update the boundary
+    _boundary_node_bits.assign(_boundary_node_bits.size(), 0);
+    _n_boundary_nodes = 0;
+    
+    for(size_t b = 0; b < _boundary_elements.size(); ++b)
+    {
+      BoundaryElement & boundary_element = _boundary_elements[b];
+      
+      if(boundary_element._parent_element == BoundaryElement::UNSET)
+        continue;
+        
+      boundary_element._parent_element = element_permutation[boundary_element._parent_element];
+      
+      for(size_t i = 0; i < shape_function_t::n_shape_face_nodes; ++i)
+        mark_boundary_node(global_node_index(boundary_element._parent_element, shape_function_t::face_node(boundary_element._parent_element_face, i)));
+    }
+    
+    if(_n_unset_boundary_elements == 0)
+      update_boundary_normals();
+      
+    // accumulate the permutation
+    if(_node_permutation.empty())
+      _node_permutation.swap(permutation);
+    else
+      for(size_t i = 0; i < _node_permutation.size(); ++i)
+        _node_permutation[i] = permutation[_node_permutation[i]];
+  }
 }
 
 
@@ -0,0 +1,176 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FEM_GRIDGEOMETRYCACHE_H
+#define FEM_GRIDGEOMETRYCACHE_H
+
+#include <vector>
+#include <exception>
+#include <string>
+
+#include <fem/Grid.hpp>
+#include <fem/FemKernel.hpp>
+
+
+namespace imaging
+{
+  /** \ingroup fem
+      \brief Stores the element geometry of a grid in the integration nodes.
+      
+      For each element of a grid which is not regular, FemKernel::set_element() computes the derivative of the element transform, its inverse, the transform determinant and the gradients of the shape functions in every integration node. This is done for every element in every call of an assembly function although the geometry of the grid typically does not change in time stepping loops. GridGeometryCache performs this computation once for all elements and stores the transform determinants and the shape gradients in flat arrays. FemKernel::set_element(std::size_t, const GridGeometryCache<fem_types> &) then copies the values of an element from these arrays instead of recomputing them. Assembler::assemble() and Assembler::assemble_stiffness_matrix() accept a GridGeometryCache and use it for all elements of the grid:
+  \code
+  img::Grid<img::fem_2d_triangle_types> grid;
+  // construct irregular grid...
+  
+  img::GridGeometryCache<img::fem_2d_triangle_types> geometry_cache;
+  geometry_cache.construct(grid);
+  
+  for(std::size_t i = 0; i < n_steps; ++i)
+  {
+    assembler.assemble(equation, grid, geometry_cache, assembly_map, stiffness_matrix, force_vector);
+    // solve...
+  }
+  \endcode
+  
+      The cache requires <tt>(data_dimension * n_element_nodes + 1) * integrator_t::n_nodes</tt> floating point values per element (e.g. 56 bytes per element of a linear triangle grid and 288 bytes per element of a bilinear square grid). The values are identical to the ones computed by FemKernel::set_element(). The cache must be constructed again if the vertices or the connectivity of the grid change. For regular grids the cache is not necessary because the assembly computes the geometry of a single element only.
+  */
+  template <class fem_types>
+  class GridGeometryCache
+  {
+  public:
+    /** The number of coordinates of the element vertices (determined by the template parameter \em fem_types). */
+    static const std::size_t data_dimension = fem_types::data_dimension;
+    
+    /** The number of nodes per element (determined by the template parameter \em fem_types). */
+    static const std::size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    
+    /** The number of integration nodes per element (determined by the template parameter \em fem_types). */
+    static const std::size_t n_integrator_nodes = fem_types::integrator_t::n_nodes;
+    
+  private:
+    std::vector<float_t> _transform_determinants;
+    std::vector<float_t> _shape_gradients;
+    std::size_t _n_elements;
+    
+  public:
+    /** Constructs an empty GridGeometryCache. Call construct() before passing it to an assembly function. */
+    GridGeometryCache() : _n_elements(0) {}
+    
+    /** Computes and stores the geometry of all elements of \em grid. The elements are processed by \em n_threads threads if the library was compiled with OpenMP support. This function must be called again if the vertices or the connectivity of \em grid change. */
+    void construct(const Grid<fem_types> & grid, std::size_t n_threads = 1);
+    
+    /** Returns the number of elements the cache was constructed for. */
+    std::size_t n_elements() const { return _n_elements; }
+    
+    /** Returns true if the cache was constructed for a grid with the same number of elements as \em grid. */
+    bool is_compatible(const Grid<fem_types> & grid) const { return grid.n_elements() == _n_elements; }
+    
+    /** Returns the number of bytes allocated by the cache. */
+    std::size_t memory_size() const { return (_transform_determinants.size() + _shape_gradients.size()) * sizeof(float_t); }
+    
+    /** Returns a pointer to the transform determinants of \em element. The determinant in the integration node \em k is stored at position \em k. */
+    const float_t * transform_determinants(std::size_t element) const { return & _transform_determinants[element * n_integrator_nodes]; }
+    
+    /** Returns a pointer to the shape gradients of \em element. The coordinate \em d of the gradient of the shape function \em i in the integration node \em k is stored at position <tt>(k * n_element_nodes + i) * data_dimension + d</tt>. */
+    const float_t * shape_gradients(std::size_t element) const { return & _shape_gradients[element * n_integrator_nodes * n_element_nodes * data_dimension]; }
+  }
+  ;
+  
+  template <class fem_types>
+  const std::size_t GridGeometryCache<fem_types>::data_dimension;
+  
+  template <class fem_types>
+  const std::size_t GridGeometryCache<fem_types>::n_element_nodes;
+  
+  template <class fem_types>
+  const std::size_t GridGeometryCache<fem_types>::n_integrator_nodes;
+  
+  template <class fem_types>
+  void GridGeometryCache<fem_types>::construct(const Grid<fem_types> & grid, std::size_t n_threads)
+  {
+    const std::size_t n_element_values = n_integrator_nodes * n_element_nodes * data_dimension;
+    
+    _n_elements = grid.n_elements();
+    _transform_determinants.resize(_n_elements * n_integrator_nodes);
+    _shape_gradients.resize(_n_elements * n_element_values);
+    
+    bool failed = false;
+    std::string error_message;
+    
+    #pragma omp parallel num_threads(n_threads > 0 ? n_threads : 1)
+    {
+      FemKernel<fem_types> kernel(grid);
+      
+      #pragma omp for schedule(static)
+      for(long element = 0; element < long(_n_elements); ++element)
+      {
+        try
+        {
+          kernel.set_element(element);
+          
+          float_t * determinants = & _transform_determinants[element * n_integrator_nodes];
+          float_t * gradients = & _shape_gradients[element * n_element_values];
+          
+          for(std::size_t k = 0; k < n_integrator_nodes; ++k)
+          {
+            determinants[k] = kernel.transform_determinant(k);
+            
+            for(std::size_t i = 0; i < n_element_nodes; ++i)
+              for(std::size_t d = 0; d < data_dimension; ++d)
+                gradients[(k * n_element_nodes + i) * data_dimension + d] = kernel.shape_gradient(k, i)(d);
+          }
+        }
+        catch(Exception & e)
+        {
+          #pragma omp critical(grid_geometry_cache_error)
+          {
+            failed = true;
+            error_message = e.error_msg();
+          }
+        }
+        catch(std::exception & e)
+        {
+          #pragma omp critical(grid_geometry_cache_error)
+          {
+            failed = true;
+            error_message = "Exception: " + std::string(e.what()) + " in GridGeometryCache::construct().";
+          }
+        }
+        catch(...)
+        {
+          #pragma omp critical(grid_geometry_cache_error)
+          {
+            failed = true;
+            error_message = "Exception: Unknown exception in GridGeometryCache::construct().";
+          }
+        }
+      }
+    }
+    
+    if(failed)
+    {
+      _n_elements = 0;
+      throw Exception(error_message);
+    }
+  }
+}
+
+
+#endif
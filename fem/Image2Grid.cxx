@@ -48,6 +48,8 @@ namespace imaging
             matrix.insert_element(i, k + system_size * ( n_x_vertices + 1 ), 0.0);
       }
     }
+    
+    image2grid_impl::permute_matrix_pattern(_node_permutation, system_size, matrix);
   }
 
   template <>
@@ -95,7 +97,7 @@ namespace imaging
       }
     }
     
-    
+    image2grid_impl::permute_matrix_pattern(_node_permutation, system_size, matrix);
   }
   
   /** \endcond */
@@ -62,6 +62,7 @@ namespace imaging
   {
     typedef ublas::fixed_vector<float_t, fem_types::data_dimension> vertex_t;
     ublas::fixed_vector<size_t, fem_types::data_dimension> _size;
+    std::vector<size_t> _node_permutation;
     
   public:
     /** Constructs an Image2Grid objects which creates the grid determined by \em dimensions or converts data from and to it. */
@@ -74,10 +75,30 @@ namespace imaging
       construct_grid(grid, ScalarImage<fem_types::data_dimension, ublas::fixed_vector<float_t, fem_types::data_dimension> >(_size, zeros));
     }
 
-    /** Sets the geometry of \em grid to the dimensions specified in the constructor of the Image2Grid object. Each node of the grid is displaced by the displacement vectors in \em displacements. */
+    /** Sets the geometry of \em grid to the dimensions specified in the constructor of the Image2Grid object. Each node of the grid is displaced by the displacement vectors in \em displacements. The grid is marked as regular (cf. Grid::is_regular()) if all displacements are zero. This applies to square, triangle and cube elements; tetrahedral grids are never marked as regular. */
     template <class vector_image_accessor_t>
     void construct_grid(Grid<fem_types> & grid, const vector_image_accessor_t & displacements) const;
 
+    /** Sets \em grid to an implicit grid of the dimensions specified in the constructor of the Image2Grid object (cf. Grid::set_implicit()). The grid has the same vertices, elements and node indices as the one constructed by construct_grid() but stores none of them. Instead they are computed from their indices by a RegularGrid object. This reduces the memory of a grid to a few bytes and is implemented for fem_2d_square_types and fem_3d_cube_types. */
+    void construct_implicit_grid(Grid<fem_types> & grid) const
+    {
+      grid.set_implicit(RegularGrid<fem_types>(_size));
+    }
+
+    /** Sets the permutation of the node indices of a grid which has been constructed by this object and then reordered by Grid::reorder_nodes(), i.e. pass Grid::node_permutation() of the reordered grid. image2vector(), vector2image(), vector2vector_image() and image2boundary_vector() then convert between images and vectors which are indexed like the nodes of the reordered grid. An empty permutation restores the original node indices. stiffness_matrix_prototype() returns the sparsity pattern of the reordered grid. */
+    void set_node_permutation(const std::vector<size_t> & node_permutation)
+    {
+      size_t n_nodes = 1;
+      
+      for(size_t i = 0; i < fem_types::data_dimension; ++i)
+        n_nodes *= _size(i);
+        
+      if(! node_permutation.empty() && node_permutation.size() != n_nodes)
+        throw Exception("Exception: Permutation of wrong length in Image2Grid::set_node_permutation().");
+        
+      _node_permutation = node_permutation;
+    }
+
     /** Resizes \em stiffness_matrix to the correct size for \em grid and prefilled with values at matrix position where non-zero entries are expected (this depends on the geometry of the grid). In case the PDE to be solved is not scalar but a system of equation, the user has to pass the number of equations (\em system_size) to ensure that \em stiffness_matrix is sized correctly. */
     void stiffness_matrix_prototype(ublas::compressed_matrix<float_t> & stiffness_matrix, size_t system_size = 1) const
     {
@@ -130,7 +151,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_2d_square_types>::image2vector(const float_accessor_t & image, ublas::vector<float_t> & vector) const
   {
-    image2grid_impl::image2vector_2d(_size, image, vector);
+    image2grid_impl::image2vector_2d(_size, _node_permutation, image, vector);
   }
 
 
@@ -138,7 +159,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_2d_square_types>::vector2image(const ublas::vector<float_t> & vector, float_accessor_t & image) const
   {
-    image2grid_impl::vector2image_2d(_size, vector, image);
+    image2grid_impl::vector2image_2d(_size, _node_permutation, vector, image);
   }
 
 
@@ -146,7 +167,7 @@ namespace imaging
   template <class vector_image_accessor_t>
   void Image2Grid<fem_2d_square_types>::vector2vector_image(const ublas::vector<float_t> & vector, vector_image_accessor_t & vector_image) const
   {
-    image2grid_impl::vector2vector_image_2d(_size, vector, vector_image);
+    image2grid_impl::vector2vector_image_2d(_size, _node_permutation, vector, vector_image);
   }
 
 
@@ -154,14 +175,14 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_2d_square_types>::image2boundary_vector(const float_accessor_t & image, ublas::mapped_vector<float_t> & vector) const
   {
-    image2grid_impl::image2boundary_vector_2d(_size, image, vector);
+    image2grid_impl::image2boundary_vector_2d(_size, _node_permutation, image, vector);
   }
   
     template<>
   template <class float_accessor_t>
   void Image2Grid<fem_2d_triangle_types>::image2vector(const float_accessor_t & image, ublas::vector<float_t> & vector) const
   {
-    image2grid_impl::image2vector_2d(_size, image, vector);
+    image2grid_impl::image2vector_2d(_size, _node_permutation, image, vector);
   }
 
 
@@ -169,7 +190,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_2d_triangle_types>::vector2image(const ublas::vector<float_t> & vector, float_accessor_t & image) const
   {
-    image2grid_impl::vector2image_2d(_size, vector, image);
+    image2grid_impl::vector2image_2d(_size, _node_permutation, vector, image);
   } 
   
   
@@ -177,7 +198,7 @@ namespace imaging
   template <class vector_image_accessor_t>
   void Image2Grid<fem_2d_triangle_types>::vector2vector_image(const ublas::vector<float_t> & vector, vector_image_accessor_t & vector_image) const
   {
-    image2grid_impl::vector2vector_image_2d(_size, vector, vector_image);
+    image2grid_impl::vector2vector_image_2d(_size, _node_permutation, vector, vector_image);
   }
 
 
@@ -185,7 +206,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_2d_triangle_types>::image2boundary_vector(const float_accessor_t & image, ublas::mapped_vector<float_t> & vector) const
   {
-    image2grid_impl::image2boundary_vector_2d(_size, image, vector);
+    image2grid_impl::image2boundary_vector_2d(_size, _node_permutation, image, vector);
   }
 
 
@@ -193,7 +214,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_3d_cube_types>::image2vector(const float_accessor_t & image, ublas::vector<float_t> & vector) const
   {
-    image2grid_impl::image2vector_3d(_size, image, vector);
+    image2grid_impl::image2vector_3d(_size, _node_permutation, image, vector);
   }
   
   
@@ -201,7 +222,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_3d_cube_types>::vector2image(const ublas::vector<float_t> & vector, float_accessor_t & image) const
   {
-    image2grid_impl::vector2image_3d(_size, vector, image);
+    image2grid_impl::vector2image_3d(_size, _node_permutation, vector, image);
   } 
   
   
@@ -209,7 +230,7 @@ namespace imaging
   template <class vector_image_accessor_t>
   void Image2Grid<fem_3d_cube_types>::vector2vector_image(const ublas::vector<float_t> & vector, vector_image_accessor_t & vector_image) const
   {
-    image2grid_impl::vector2vector_image_3d(_size, vector, vector_image);
+    image2grid_impl::vector2vector_image_3d(_size, _node_permutation, vector, vector_image);
   }
   
   
@@ -217,7 +238,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_3d_cube_types>::image2boundary_vector(const float_accessor_t & image, ublas::mapped_vector<float_t> & vector) const
   {
-    image2grid_impl::image2boundary_vector_3d(_size, image, vector);
+    image2grid_impl::image2boundary_vector_3d(_size, _node_permutation, image, vector);
   }
 
   
@@ -225,14 +246,14 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_3d_tetrahedra_types>::image2vector(const float_accessor_t & image, ublas::vector<float_t> & vector) const
   {
-    image2grid_impl::image2vector_3d(_size, image, vector);
+    image2grid_impl::image2vector_3d(_size, _node_permutation, image, vector);
   }
   
   template<>
   template <class float_accessor_t>
   void Image2Grid<fem_3d_tetrahedra_types>::vector2image(const ublas::vector<float_t> & vector, float_accessor_t & image) const
   {
-    image2grid_impl::vector2image_3d(_size, vector, image);
+    image2grid_impl::vector2image_3d(_size, _node_permutation, vector, image);
   } 
   
   
@@ -240,7 +261,7 @@ namespace imaging
   template <class vector_image_accessor_t>
   void Image2Grid<fem_3d_tetrahedra_types>::vector2vector_image(const ublas::vector<float_t> & vector, vector_image_accessor_t & vector_image) const
   {
-    image2grid_impl::vector2vector_image_3d(_size, vector, vector_image);
+    image2grid_impl::vector2vector_image_3d(_size, _node_permutation, vector, vector_image);
   }
   
   
@@ -248,7 +269,7 @@ namespace imaging
   template <class float_accessor_t>
   void Image2Grid<fem_3d_tetrahedra_types>::image2boundary_vector(const float_accessor_t & image, ublas::mapped_vector<float_t> & vector) const
   {
-    image2grid_impl::image2boundary_vector_3d(_size, image, vector);
+    image2grid_impl::image2boundary_vector_3d(_size, _node_permutation, image, vector);
   }
   
   template<>
@@ -265,10 +286,10 @@ namespace imaging
                          2 * (n_x_elements + n_y_elements),
                          n_x_vertices * n_y_vertices );
                          
-    grid.set_regular(true);
-                         
-    image2grid_impl::construct_regular_2d_vertices(grid, _size, displacements);
+    bool is_undisplaced = image2grid_impl::construct_regular_2d_vertices(grid, _size, displacements);
     image2grid_impl::populate_grid(grid, _size);
+    
+    grid.set_regular(is_undisplaced);
   }
   
   template<>
@@ -285,10 +306,10 @@ namespace imaging
                          2 * (n_x_elements + n_y_elements),
                          n_x_vertices * n_y_vertices );
                          
-    grid.set_regular(true);
-                         
-    image2grid_impl::construct_regular_2d_vertices(grid, _size, displacements);
+    bool is_undisplaced = image2grid_impl::construct_regular_2d_vertices(grid, _size, displacements);
     image2grid_impl::populate_grid(grid, _size);
+    
+    grid.set_regular(is_undisplaced);
   }
   
   template<>
@@ -307,10 +328,10 @@ namespace imaging
                         2 * (n_x_elements * n_y_elements + n_y_elements * n_z_elements + n_z_elements * n_x_elements),
                         n_x_vertices * n_y_vertices * n_z_vertices);
                         
-    grid.set_regular(true);
-    
-    image2grid_impl::construct_regular_3d_vertices(grid, _size, displacements);
+    bool is_undisplaced = image2grid_impl::construct_regular_3d_vertices(grid, _size, displacements);
     image2grid_impl::populate_grid(grid, _size);
+    
+    grid.set_regular(is_undisplaced);
   }
   
     
@@ -330,10 +351,10 @@ namespace imaging
                         4 * (n_x_elements * n_y_elements + n_y_elements * n_z_elements + n_z_elements * n_x_elements),
                         n_x_vertices * n_y_vertices * n_z_vertices);
                         
-    grid.set_regular(false);
-    
     image2grid_impl::construct_regular_3d_vertices(grid, _size, displacements);
     image2grid_impl::populate_grid(grid, _size);
+    
+    grid.set_regular(false);
   }
   /** \endcond */
 }
@@ -1,9 +1,42 @@
 #include <fem/Image2Grid_impl.hpp>
 
+#include <algorithm>
+
 namespace imaging
 {
   namespace image2grid_impl
   {
+    void permute_matrix_pattern(const std::vector<size_t> & node_permutation, size_t system_size, ublas::compressed_matrix<float_t> & matrix)
+    {
+      if(node_permutation.empty())
+        return;
+        
+      if(node_permutation.size() * system_size != matrix.size1() || matrix.size1() != matrix.size2())
+        throw Exception("Exception: Permutation does not match the size of the matrix in image2grid_impl::permute_matrix_pattern().");
+      
+      std::vector< std::vector<size_t> > columns(matrix.size1());
+      
+      for(ublas::compressed_matrix<float_t>::const_iterator1 row_iter = matrix.begin1(); row_iter != matrix.end1(); ++row_iter)
+        for(ublas::compressed_matrix<float_t>::const_iterator2 iter = row_iter.begin(); iter != row_iter.end(); ++iter)
+        {
+          size_t row = system_size * node_permutation[iter.index1() / system_size] + iter.index1() % system_size;
+          size_t column = system_size * node_permutation[iter.index2() / system_size] + iter.index2() % system_size;
+          columns[row].push_back(column);
+        }
+        
+      ublas::compressed_matrix<float_t> permuted(matrix.size1(), matrix.size2(), matrix.nnz());
+      
+      for(size_t i = 0; i < columns.size(); ++i)
+      {
+        std::sort(columns[i].begin(), columns[i].end());
+        
+        for(size_t j = 0; j < columns[i].size(); ++j)
+          permuted.push_back(i, columns[i][j], 0.0);
+      }
+      
+      matrix.swap(permuted);
+    }
+    
    ublas::fixed_vector<float_t, 2> mean_normal(const ublas::fixed_vector<float_t, 2> & reference, const ublas::fixed_vector<float_t, 2> & clockwise_neighbor, const ublas::fixed_vector<float_t, 2> & counter_clockwise_neighbor)
     {
       ublas::fixed_vector<float_t, 2> temp(clockwise_neighbor - counter_clockwise_neighbor);
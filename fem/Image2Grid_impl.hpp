@@ -34,15 +34,15 @@ namespace imaging
     template <class fem_types>
     void populate_grid(Grid<fem_types> & grid, const ublas::fixed_vector<size_t, fem_types::data_dimension> & size);
     
+    // returns true if all displacements are zero
     template <class vector_image_accessor_t, class fem_types>
-    void construct_regular_2d_vertices(Grid<fem_types> & grid, const ublas::fixed_vector<size_t, 2> & size, const vector_image_accessor_t  & displacements)
+    bool construct_regular_2d_vertices(Grid<fem_types> & grid, const ublas::fixed_vector<size_t, 2> & size, const vector_image_accessor_t  & displacements)
     {
       typedef ublas::fixed_vector<float_t, 2> vertex_t;
       
       size_t n_x_vertices = size(0);
       size_t n_y_vertices = size(1);
-  
-      grid.set_regular(true);
+      bool is_undisplaced = true;
   
       for(size_t i = 0; i < n_x_vertices; i++)
         for(size_t j = 0; j < n_y_vertices; ++j)
@@ -50,19 +50,24 @@ namespace imaging
           size_t vertex_index = i + j * n_x_vertices;
           vertex_t offset(displacements[ublas::fixed_vector<size_t, 2>(i, j)]);
           grid.set_vertex(vertex_index, vertex_t( .5 + float_t(i) + offset(0), .5 + float_t(j) + offset(1)));
-        }  
+          
+          if(offset(0) != 0.0 || offset(1) != 0.0)
+            is_undisplaced = false;
+        }
+        
+      return is_undisplaced;
     }
     
+    // returns true if all displacements are zero
     template <class vector_image_accessor_t, class fem_types>
-    void construct_regular_3d_vertices(Grid<fem_types> & grid, const ublas::fixed_vector<size_t, 3> & size, const vector_image_accessor_t  & displacements)
+    bool construct_regular_3d_vertices(Grid<fem_types> & grid, const ublas::fixed_vector<size_t, 3> & size, const vector_image_accessor_t  & displacements)
     {
       typedef ublas::fixed_vector<float_t, 3> vertex_t;
       
       size_t n_x_vertices = size(0);
       size_t n_y_vertices = size(1);
       size_t n_z_vertices = size(2);
-      
-      grid.set_regular(false);
+      bool is_undisplaced = true;
       
       for(size_t i = 0; i < n_x_vertices; i++)
         for(size_t j = 0; j < n_y_vertices; ++j)
@@ -73,11 +78,25 @@ namespace imaging
             grid.set_vertex(vertex_index, vertex_t(0.5 + float_t(i) + offset(0), 
                                                    0.5 + float_t(j) + offset(1),
                                                    0.5 + float_t(k) + offset(2)));
-          }  
+                                                   
+            if(offset(0) != 0.0 || offset(1) != 0.0 || offset(2) != 0.0)
+              is_undisplaced = false;
+          }
+          
+      return is_undisplaced;
+    }
+    
+    // the index of the node at the image index 'index' in a grid whose nodes have been reordered by 'node_permutation'
+    inline size_t node_index(const std::vector<size_t> & node_permutation, size_t index)
+    {
+      return node_permutation.empty() ? index : node_permutation[index];
     }
     
+    // renumbers the rows and columns of the sparsity pattern 'matrix' of a system with 'system_size' equations per node such that it conforms with a grid whose nodes have been reordered by 'node_permutation'
+    void permute_matrix_pattern(const std::vector<size_t> & node_permutation, size_t system_size, ublas::compressed_matrix<float_t> & matrix);
+    
     template<class float_accessor_t> 
-    void image2vector_2d(const ublas::fixed_vector<size_t, 2> size, const float_accessor_t & image, ublas::vector<float_t> & vector)
+    void image2vector_2d(const ublas::fixed_vector<size_t, 2> size, const std::vector<size_t> & node_permutation, const float_accessor_t & image, ublas::vector<float_t> & vector)
     {
       if(image.size() != size)
         throw Exception("Exception: Dimensions of image and grid do not agree in Image2Grid::image2vector().");
@@ -90,13 +109,13 @@ namespace imaging
       for(size_t i = 0; i < n_x_vertices; i++)
         for(size_t j = 0; j < n_y_vertices; ++j)
         {
-          size_t vertex_index = i + j * n_x_vertices;
+          size_t vertex_index = node_index(node_permutation, i + j * n_x_vertices);
           vector(vertex_index) = image[ublas::fixed_vector<size_t, 2>(i, j)];
         }
     }
      
     template<class float_accessor_t> 
-    void image2boundary_vector_2d(const ublas::fixed_vector<size_t, 2> size, const float_accessor_t &image, ublas::mapped_vector<float_t> & vector)
+    void image2boundary_vector_2d(const ublas::fixed_vector<size_t, 2> size, const std::vector<size_t> & node_permutation, const float_accessor_t &image, ublas::mapped_vector<float_t> & vector)
     {
       if(image.size() != size)
         throw Exception("Exception: Dimensions of image and grid do not agree in Image2Grid::image2boundary_vector().");
@@ -109,7 +128,7 @@ namespace imaging
       for(size_t i = 0; i < n_x_vertices; ++i)
         for(size_t j = 0; j < n_y_vertices; ++j)
         {
-          size_t vertex_index = i + j * n_x_vertices;
+          size_t vertex_index = node_index(node_permutation, i + j * n_x_vertices);
           vector(vertex_index) = image[ublas::fixed_vector<size_t, 2>(i, j)];
   
           if(i > 0 && i < n_x_vertices - 1)
@@ -118,7 +137,7 @@ namespace imaging
     }
     
     template <class float_accessor_t>
-    void vector2image_2d(const ublas::fixed_vector<size_t, 2> size, const ublas::vector< float_t > &vector, float_accessor_t & image)
+    void vector2image_2d(const ublas::fixed_vector<size_t, 2> size, const std::vector<size_t> & node_permutation, const ublas::vector< float_t > &vector, float_accessor_t & image)
     {
       size_t n_x_vertices = size(0);
       size_t n_y_vertices = size(1);
@@ -132,13 +151,13 @@ namespace imaging
       for(size_t i = 0; i < n_x_vertices; i++)
         for(size_t j = 0; j < n_y_vertices; ++j)
         {
-          size_t vertex_index = i + j * n_x_vertices;
+          size_t vertex_index = node_index(node_permutation, i + j * n_x_vertices);
           image[ublas::fixed_vector<size_t, 2>(i, j)] = vector(vertex_index);
         }
     }
     
     template <class vector_image_accessor_t>
-    void vector2vector_image_2d(const ublas::fixed_vector<size_t, 2> size, const ublas::vector< float_t > &vector, vector_image_accessor_t & vector_image)
+    void vector2vector_image_2d(const ublas::fixed_vector<size_t, 2> size, const std::vector<size_t> & node_permutation, const ublas::vector< float_t > &vector, vector_image_accessor_t & vector_image)
     {
       const size_t n_x_vertices = size(0);
       const size_t n_y_vertices = size(1);
@@ -154,13 +173,13 @@ namespace imaging
         for(size_t j = 0; j < n_y_vertices; ++j)
           for(size_t k = 0; k < dimension; ++k)
           {
-            size_t vertex_index = dimension * ( i + j * n_x_vertices ) + k;
+            size_t vertex_index = dimension * node_index(node_permutation, i + j * n_x_vertices) + k;
             vector_image[ublas::fixed_vector<size_t, 2>(i, j)](k) = vector(vertex_index);
           }
     }
     
     template<class float_accessor_t> 
-    void image2vector_3d(const ublas::fixed_vector<size_t, 3> size, const float_accessor_t & image, ublas::vector<float_t> & vector)
+    void image2vector_3d(const ublas::fixed_vector<size_t, 3> size, const std::vector<size_t> & node_permutation, const float_accessor_t & image, ublas::vector<float_t> & vector)
     {
       if(image.size() != size)
         throw Exception("Exception: Dimensions of image and grid do not agree in Image2Grid::image2vector().");
@@ -175,13 +194,13 @@ namespace imaging
         for(size_t j = 0; j < n_y_vertices; ++j)
           for (size_t k = 0; k < n_z_vertices; ++k)
           {
-            size_t vertex_index = i + j * n_x_vertices + k * n_x_vertices * n_y_vertices;
+            size_t vertex_index = node_index(node_permutation, i + j * n_x_vertices + k * n_x_vertices * n_y_vertices);
             vector(vertex_index) = image[ublas::fixed_vector<size_t, 3>(i, j, k)];
           }
     }
      
     template<class float_accessor_t> 
-    void image2boundary_vector_3d(const ublas::fixed_vector<size_t, 3> size, const float_accessor_t &image, ublas::mapped_vector<float_t> & vector)
+    void image2boundary_vector_3d(const ublas::fixed_vector<size_t, 3> size, const std::vector<size_t> & node_permutation, const float_accessor_t &image, ublas::mapped_vector<float_t> & vector)
     {
       if(image.size() != size)
         throw Exception("Exception: Dimensions of image and grid do not agree in Image2Grid::image2boundary_map().");
@@ -196,7 +215,7 @@ namespace imaging
         for(size_t j = 0; j < n_y_vertices; ++j)
           for(size_t k = 0; k < n_z_vertices; ++k)  
           {
-            size_t vertex_index = i + j * n_x_vertices + k * n_x_vertices * n_y_vertices;
+            size_t vertex_index = node_index(node_permutation, i + j * n_x_vertices + k * n_x_vertices * n_y_vertices);
             vector(vertex_index) = image[ublas::fixed_vector<size_t, 3>(i, j, k)];
             if(i > 0 && i < n_x_vertices - 1 && j > 0 && j < n_y_vertices -1 )
               k += n_z_vertices - 2;
@@ -204,7 +223,7 @@ namespace imaging
     }
     
     template <class float_accessor_t>
-    void vector2image_3d(const ublas::fixed_vector<size_t, 3> size, const ublas::vector< float_t > &vector, float_accessor_t & image)
+    void vector2image_3d(const ublas::fixed_vector<size_t, 3> size, const std::vector<size_t> & node_permutation, const ublas::vector< float_t > &vector, float_accessor_t & image)
     {
       size_t n_x_vertices = size(0);
       size_t n_y_vertices = size(1);
@@ -220,13 +239,13 @@ namespace imaging
         for(size_t j = 0; j < n_y_vertices; ++j)
           for(size_t k = 0; k < n_z_vertices; ++k) 
           {
-            size_t vertex_index = i + j * n_x_vertices + k * n_x_vertices * n_y_vertices;
+            size_t vertex_index = node_index(node_permutation, i + j * n_x_vertices + k * n_x_vertices * n_y_vertices);
             image[ublas::fixed_vector<size_t, 3>(i, j, k)] = vector(vertex_index);
           }
     }
     
     template <class vector_image_accessor_t>
-    void vector2vector_image_3d(const ublas::fixed_vector<size_t, 3> size, const ublas::vector< float_t > &vector, vector_image_accessor_t & vector_image)
+    void vector2vector_image_3d(const ublas::fixed_vector<size_t, 3> size, const std::vector<size_t> & node_permutation, const ublas::vector< float_t > &vector, vector_image_accessor_t & vector_image)
     {
       const size_t n_x_vertices = size(0);
       const size_t n_y_vertices = size(1); 
@@ -244,7 +263,7 @@ namespace imaging
           for(size_t k = 0; k < n_z_vertices; ++k)  
             for(size_t l = 0; l < dimension; ++l)
             {
-              size_t vertex_index = dimension * ( i + j * n_x_vertices + k * n_x_vertices * n_y_vertices) + l;
+              size_t vertex_index = dimension * node_index(node_permutation, i + j * n_x_vertices + k * n_x_vertices * n_y_vertices) + l;
               vector_image[ublas::fixed_vector<size_t, 3>(i, j, k)](l) = vector(vertex_index);
             }
     }
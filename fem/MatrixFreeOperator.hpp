@@ -0,0 +1,367 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FEM_MATRIXFREEOPERATOR_H
+#define FEM_MATRIXFREEOPERATOR_H
+
+#include <vector>
+#include <exception>
+#include <string>
+
+#include <fem/Grid.hpp>
+#include <fem/FemKernel.hpp>
+#include <fem/equation/SimpleEquationAdaptor.hpp>
+#include <solver/LinearOperatorInterface.hpp>
+
+
+namespace imaging
+{
+  /** \ingroup fem
+      \brief Applies the stiffness operator of a SimpleEquationInterface object without assembling the stiffness matrix.
+      
+      On a regular grid (Grid::is_regular()) the shape values, shape gradients and transform determinants are identical for all elements. MatrixFreeOperator evaluates them once by setting a FemKernel to element 0 and combines them during each call of apply() with the coefficients of the equation in the integration nodes of the current element. Apart from the data of the equation only the input and output vectors are touched, i.e. no stiffness matrix has to be stored. The result of apply() equals the product of the stiffness matrix assembled by SimpleAssembler and the input vector up to round-off.
+      
+      The force vector is not affected and can still be computed by SimpleAssembler::assemble_force_vector(). The operator can be passed to PcgSolver instead of an assembled matrix:
+  \code
+  img::Grid<img::fem_2d_square_types> grid;
+  // construct a regular grid...
+  
+  SomeSimpleEquation<img::fem_2d_square_types> equation;
+  // provide data to the equation...
+  
+  img::MatrixFreeOperator<img::fem_2d_square_types, SomeSimpleEquation<img::fem_2d_square_types> > op(equation, grid);
+  
+  img::ublas::vector<img::float_t> force_vector, solution;
+  img::SimpleAssembler assembler;
+  assembler.assemble_force_vector(equation, grid, force_vector);
+  
+  img::PcgSolver solver;
+  solver.solve(op, force_vector, solution);
+  \endcode
+  
+      For multithreaded operation the elements are partitioned into colors such that no two elements of the same color share a node. The elements of one color are processed in parallel and the colors one after another, thus the result does not depend on the number of threads. Boundary elements are processed serially.
+  */
+  template <class fem_types, class simple_equation_t>
+  class MatrixFreeOperator : public LinearOperatorInterface
+  {
+    typedef typename fem_types::integrator_t integrator_t;
+    typedef typename fem_types::boundary_integrator_t boundary_integrator_t;
+    typedef ublas::fixed_vector<float_t, fem_types::data_dimension> vector_t;
+    
+    static const size_t n_element_nodes = fem_types::shape_function_t::n_element_nodes;
+    static const size_t data_dimension = fem_types::data_dimension;
+    
+    const simple_equation_t & _equation;
+    const Grid<fem_types> & _grid;
+    size_t _n_threads;
+    bool _mask_boundary_nodes;
+    std::vector<char> _is_boundary_node;
+    std::vector< std::vector<size_t> > _colors;
+    
+    void compute_colors();
+    void process_elements(const ublas::vector<float_t> * x, ublas::vector<float_t> & y) const;
+    void process_element(size_t element, const FemKernel<fem_types> & kernel, const integrator_t & integrator,
+                         const ublas::vector<float_t> * x, ublas::vector<float_t> & y) const;
+    void process_boundary_elements(const ublas::vector<float_t> * x, ublas::vector<float_t> & y) const;
+    bool is_masked(size_t node) const { return _mask_boundary_nodes && _is_boundary_node[node]; }
+    
+  public:
+    /** Constructs the operator of \em equation on \em grid. Both objects are stored as references and must not be destroyed before the operator. The grid must be regular. The operator is applied by \em n_threads threads. */
+    MatrixFreeOperator(const simple_equation_t & equation, const Grid<fem_types> & grid, size_t n_threads = 1);
+    
+    /** Returns the number of threads used by apply() and diagonal(). */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads used by apply() and diagonal(). */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    /** Returns the number of nodes of the grid. */
+    size_t size() const { return _grid.n_nodes(); }
+    
+    void apply(const ublas::vector<float_t> & x, ublas::vector<float_t> & y) const
+    {
+      if(x.size() != size())
+        throw Exception("Exception: Dimensions do not agree in MatrixFreeOperator::apply().");
+        
+      y.resize(size(), false);
+      y.clear();
+      process_elements(& x, y);
+      process_boundary_elements(& x, y);
+    }
+    
+    void diagonal(ublas::vector<float_t> & diagonal) const
+    {
+      diagonal.resize(size(), false);
+      diagonal.clear();
+      process_elements(0, diagonal);
+      process_boundary_elements(0, diagonal);
+    }
+  }
+  ;
+  
+  template <class fem_types, class simple_equation_t>
+  MatrixFreeOperator<fem_types, simple_equation_t>::MatrixFreeOperator(const simple_equation_t & equation, const Grid<fem_types> & grid, size_t n_threads) :
+    _equation(equation), _grid(grid), _n_threads(n_threads > 0 ? n_threads : 1)
+  {
+    if(! grid.is_regular())
+      throw Exception("Exception: Grid is not regular in MatrixFreeOperator::MatrixFreeOperator().");
+      
+    if(grid.n_elements() > 0)
+    {
+      FemKernel<fem_types> kernel(grid);
+      kernel.set_element(0);
+      
+      std::string sanity_check_message = "";
+      if( ! equation.sanity_check_stiffness_matrix(kernel, sanity_check_message) )
+        throw Exception("Exception: sanity check failed in MatrixFreeOperator::MatrixFreeOperator() with message '" + sanity_check_message + "'.");
+    }
+    
+    // as in SimpleEquationAdaptor the rows of boundary nodes contain only boundary terms for explicit boundary data
+    _mask_boundary_nodes = equation.boundary_data_type != simple_equation_t::NO_BOUNDARY_DATA &&
+                           equation.boundary_data_type != simple_equation_t::IMPLICIT_NEUMANN_DATA;
+    
+    if(_mask_boundary_nodes)
+    {
+      _is_boundary_node.resize(grid.n_nodes());
+      for(size_t node = 0; node < grid.n_nodes(); ++node)
+        _is_boundary_node[node] = grid.is_boundary_node(node);
+    }
+    
+    compute_colors();
+  }
+  
+  template <class fem_types, class simple_equation_t>
+  void MatrixFreeOperator<fem_types, simple_equation_t>::compute_colors()
+  {
+    // greedy coloring, the colors of the elements adjacent to a node are stored as bit mask
+    const size_t n_max_colors = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> node_colors(_grid.n_nodes(), 0);
+    
+    for(size_t element = 0; element < _grid.n_elements(); ++element)
+    {
+      unsigned long used_colors = 0;
+      for(size_t i = 0; i < n_element_nodes; ++i)
+        used_colors |= node_colors[_grid.global_node_index(element, i)];
+        
+      size_t color = 0;
+      while(color < n_max_colors && (used_colors & (1ul << color)))
+        ++color;
+        
+      if(color == n_max_colors)
+        throw Exception("Exception: Too many element colors in MatrixFreeOperator::compute_colors().");
+        
+      if(color == _colors.size())
+        _colors.push_back(std::vector<size_t>());
+        
+      _colors[color].push_back(element);
+      
+      for(size_t i = 0; i < n_element_nodes; ++i)
+        node_colors[_grid.global_node_index(element, i)] |= (1ul << color);
+    }
+  }
+  
+  template <class fem_types, class simple_equation_t>
+  void MatrixFreeOperator<fem_types, simple_equation_t>::process_elements(const ublas::vector<float_t> * x, ublas::vector<float_t> & y) const
+  {
+    // set the reference element once outside of the parallel region such that errors are thrown here
+    if(_grid.n_elements() > 0)
+      FemKernel<fem_types>(_grid).set_element(0);
+    
+    for(size_t color = 0; color < _colors.size(); ++color)
+    {
+      const std::vector<size_t> & elements = _colors[color];
+      const long n_color_elements = long(elements.size());
+      bool failed = false;
+      std::string error_message;
+      
+      #pragma omp parallel num_threads(_n_threads)
+      {
+        integrator_t integrator;
+        FemKernel<fem_types> kernel(_grid);
+        kernel.set_element(0);
+        
+        #pragma omp for schedule(static)
+        for(long n = 0; n < n_color_elements; ++n)
+        {
+          try
+          {
+            kernel.lazy_set_element(elements[n]);
+            process_element(elements[n], kernel, integrator, x, y);
+          }
+          catch(Exception & e)
+          {
+            #pragma omp critical(matrix_free_operator_error)
+            {
+              failed = true;
+              error_message = e.error_msg();
+            }
+          }
+          catch(std::exception & e)
+          {
+            #pragma omp critical(matrix_free_operator_error)
+            {
+              failed = true;
+              error_message = "Exception: " + std::string(e.what()) + " in MatrixFreeOperator::apply().";
+            }
+          }
+          catch(...)
+          {
+            #pragma omp critical(matrix_free_operator_error)
+            {
+              failed = true;
+              error_message = "Exception: Unknown exception in MatrixFreeOperator::apply().";
+            }
+          }
+        }
+      }
+      
+      if(failed)
+        throw Exception(error_message);
+    }
+  }
+  
+  template <class fem_types, class simple_equation_t>
+  void MatrixFreeOperator<fem_types, simple_equation_t>::process_element(size_t element, const FemKernel<fem_types> & kernel, const integrator_t & integrator,
+                                                                         const ublas::vector<float_t> * x, ublas::vector<float_t> & y) const
+  {
+    typename simple_equation_t::matrix_coefficient_t A;
+    vector_t a, b, gradient, flux;
+    float_t c = 0.0;
+    
+    ublas::fixed_vector<size_t, n_element_nodes> nodes;
+    ublas::fixed_vector<float_t, n_element_nodes> local_x, local_y;
+    
+    for(size_t i = 0; i < n_element_nodes; ++i)
+    {
+      nodes(i) = _grid.global_node_index(element, i);
+      local_x(i) = x ? (*x)(nodes(i)) : 0.0;
+      local_y(i) = 0.0;
+    }
+    
+    for(size_t k = 0; k < integrator_t::n_nodes; ++k)
+    {
+      _equation.stiffness_matrix(k, kernel, A, a, b, c);
+      
+      const float_t weight = kernel.transform_determinant(k) * integrator.weight(k);
+      
+      if(! x)
+      {
+        // diagonal entries of the element stiffness matrix
+        for(size_t i = 0; i < n_element_nodes; ++i)
+        {
+          const vector_t & shape_gradient = kernel.shape_gradient(k, i);
+          const float_t shape_value = kernel.shape_value(k, i);
+          
+          float_t value = inner_prod(prod(A, shape_gradient), shape_gradient);
+          
+          if(_equation.a_active)
+            value += inner_prod(a, shape_gradient) * shape_value;
+          if(_equation.b_active)
+            value += inner_prod(b, shape_gradient) * shape_value;
+          if(_equation.c_active)
+            value += c * shape_value * shape_value;
+            
+          local_y(i) += weight * value;
+        }
+        
+        continue;
+      }
+      
+      // value and gradient of the finite element function x in the integration node
+      float_t value = 0.0;
+      for(size_t d = 0; d < data_dimension; ++d)
+        gradient(d) = 0.0;
+        
+      for(size_t j = 0; j < n_element_nodes; ++j)
+      {
+        value += local_x(j) * kernel.shape_value(k, j);
+        for(size_t d = 0; d < data_dimension; ++d)
+          gradient(d) += local_x(j) * kernel.shape_gradient(k, j)(d);
+      }
+      
+      // the entry (i, j) of the element matrix is (A grad phi_i) . grad phi_j, i.e. row i is tested with A^T grad x
+      for(size_t d = 0; d < data_dimension; ++d)
+      {
+        flux(d) = 0.0;
+        for(size_t e = 0; e < data_dimension; ++e)
+          flux(d) += A(e, d) * gradient(e);
+      }
+      
+      float_t value_factor = 0.0;
+      if(_equation.a_active)
+        value_factor += inner_prod(a, gradient);
+      if(_equation.c_active)
+        value_factor += c * value;
+        
+      for(size_t i = 0; i < n_element_nodes; ++i)
+      {
+        float_t contribution = inner_prod(flux, kernel.shape_gradient(k, i)) + value_factor * kernel.shape_value(k, i);
+        
+        if(_equation.b_active)
+          contribution += inner_prod(b, kernel.shape_gradient(k, i)) * value;
+          
+        local_y(i) += weight * contribution;
+      }
+    }
+    
+    for(size_t i = 0; i < n_element_nodes; ++i)
+      if(! is_masked(nodes(i)))
+        y(nodes(i)) += local_y(i);
+  }
+  
+  template <class fem_types, class simple_equation_t>
+  void MatrixFreeOperator<fem_types, simple_equation_t>::process_boundary_elements(const ublas::vector<float_t> * x, ublas::vector<float_t> & y) const
+  {
+    if(_equation.boundary_data_type == simple_equation_t::NO_BOUNDARY_DATA)
+      return;
+      
+    SimpleEquationAdaptor<simple_equation_t> equation(_equation);
+    boundary_integrator_t boundary_integrator;
+    FemKernel<fem_types> kernel(_grid);
+    
+    for(size_t boundary_element = 0; boundary_element < _grid.n_boundary_elements(); ++boundary_element)
+    {
+      kernel.set_boundary_element(boundary_element);
+      size_t parent_element = _grid.parent_element(boundary_element);
+      
+      for(size_t i = 0; i < n_element_nodes; ++i)
+      {
+        size_t row = _grid.global_node_index(parent_element, i);
+        
+        for(size_t j = 0; j < n_element_nodes; ++j)
+        {
+          if(! x && j != i)
+            continue;
+            
+          float_t value = 0.0;
+          
+          for(size_t k = 0; k < boundary_integrator_t::n_nodes; ++k)
+            value += equation.stiffness_matrix_at_boundary(0, 0, i, j, k, kernel) *
+                     kernel.boundary_transform_determinant(k) *
+                     boundary_integrator.weight(k);
+                     
+          y(row) += x ? value * (*x)(_grid.global_node_index(parent_element, j)) : value;
+        }
+      }
+    }
+  }
+}
+
+
+#endif
@@ -0,0 +1,693 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FEM_MULTIGRIDSOLVER_H
+#define FEM_MULTIGRIDSOLVER_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <fem/Grid.hpp>
+#include <solver/SolverInterface.hpp>
+#include <solver/GaussSeidelSolver.hpp>
+#include <solver/PcgSolver.hpp>
+
+
+namespace imaging
+{
+  /** \ingroup fem
+      \brief Geometric multigrid solver for FE systems on grids constructed by Image2Grid.
+      
+      The grid hierarchy is derived from the dimensions of the image grid (i.e. the dimensions passed to Image2Grid). Each level is obtained from the next finer one by keeping every second node in each direction. If the number of nodes in a direction is even, the last node is kept as well. Coarsening stops if the number of nodes drops below a given threshold or if a direction has only two nodes left. Level 0 denotes the finest level. Coarse grid corrections are transferred by multilinear interpolation (prolongation) and its transpose (restriction).
+      
+      The operators on the coarse levels are either computed by setup() as Galerkin products <tt>R A P</tt> of the fine operator \em A with the restriction \em R and the prolongation \em P, or they are provided for each level by set_level_operator(), e.g. by assembling the equation on a coarser grid (rediscretization). In the latter case inject_vector() transfers nodal data such as the input of a step equation to the coarse levels. Note that Image2Grid constructs grids with unit node spacing, i.e. rediscretized operators on level \em l must account for the actual node spacing 2<sup>l</sup>.
+      
+      The system on the coarsest level is solved by a SolverInterface object, by default by PcgSolver with IC(0) preconditioning. Smoothing is performed by applying a SolverInterface object to the residual equation. By default one symmetric Gauss-Seidel iteration (GaussSeidelSolver) is performed before and after each coarse grid correction. The resulting V-cycle is symmetric and can be used as preconditioner of PcgSolver:
+  \code
+  img::ublas::fixed_vector<std::size_t, 3> size(256, 256, 128);
+  img::Image2Grid<img::fem_3d_cube_types> image2grid(size);
+  // construct the grid, assemble stiffness_matrix and force_vector...
+  
+  img::MultigridSolver<img::fem_3d_cube_types> multigrid(grid, size, 1, 0.0);
+  multigrid.setup(stiffness_matrix);
+  
+  img::PcgSolver solver;
+  solver.set_preconditioner(multigrid);
+  solver.solve(stiffness_matrix, force_vector, solution);
+  \endcode
+      Used as a standalone solver MultigridSolver iterates V-cycles until the relative residual drops below the tolerance. The iteration starts from the current content of \em result if it has the dimension of the system (warm start) and from zero otherwise. The work per cycle is proportional to the number of nodes and the number of cycles does not depend on the resolution for elliptic problems.
+  */
+  template <class fem_types>
+  class MultigridSolver : public SolverInterface
+  {
+  public:
+    /** The type of the image dimensions of a level. */
+    typedef ublas::fixed_vector<size_t, fem_types::data_dimension> size_vector_t;
+    
+  private:
+    static const size_t N = fem_types::data_dimension;
+    
+    std::vector<size_vector_t> _sizes;
+    std::vector< ublas::compressed_matrix<float_t> > _prolongations;
+    std::vector< ublas::compressed_matrix<float_t> > _restrictions;
+    std::vector< std::vector<size_t> > _injections;
+    std::vector< ublas::compressed_matrix<float_t> > _operators;
+    std::vector<bool> _has_operator;
+    
+    size_t _n_max_cycles;
+    float_t _tolerance;
+    
+    GaussSeidelSolver _default_smoother;
+    PcgSolver _default_coarse_solver;
+    const SolverInterface * _smoother;
+    const SolverInterface * _coarse_solver;
+    
+    mutable std::vector< ublas::vector<float_t> > _level_rhs;
+    mutable std::vector< ublas::vector<float_t> > _level_solutions;
+    mutable std::vector< ublas::vector<float_t> > _level_residuals;
+    mutable std::vector< ublas::vector<float_t> > _level_corrections;
+    mutable size_t _n_cycles;
+    mutable float_t _residual;
+    
+    static size_t n_nodes(const size_vector_t & size);
+    static size_t coarse_position(size_t coarse_index, size_t n_fine) { return std::min(2 * coarse_index, n_fine - 1); }
+    static void row_range(const ublas::compressed_matrix<float_t> & matrix, size_t row, size_t & begin, size_t & end);
+    static void sparse_product(const ublas::compressed_matrix<float_t> & a, const ublas::compressed_matrix<float_t> & b, ublas::compressed_matrix<float_t> & c);
+    static void transpose(const ublas::compressed_matrix<float_t> & a, ublas::compressed_matrix<float_t> & a_transposed);
+    static void multiply(const ublas::compressed_matrix<float_t> & a, const ublas::vector<float_t> & x, ublas::vector<float_t> & y, float_t factor, bool add);
+    
+    void init(const size_vector_t & size, size_t n_coarse_nodes);
+    static void check_grid(const Grid<fem_types> & grid, const size_vector_t & size);
+    void construct_transfer(size_t level);
+    void cycle(size_t level, const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    void smooth(size_t level, const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    
+    MultigridSolver(const MultigridSolver &);
+    MultigridSolver & operator=(const MultigridSolver &);
+    
+  public:
+    /** Constructs the grid hierarchy for image grids of dimensions \em size. Coarsening stops if a level has at most \em n_coarse_nodes nodes. When used as standalone solver at most \em n_max_cycles V-cycles are performed until the relative residual is smaller than \em tolerance. For \em tolerance = 0 exactly \em n_max_cycles cycles are performed and the residual is not computed. The rows of the systems passed to setup() and solve() must be numbered like the nodes of a grid constructed by Image2Grid for \em size, i.e. the node with image index (\em i, \em j, \em k) must have the index <tt>i + j * n_x + k * n_x * n_y</tt>. This is not checked; prefer the constructor which takes the grid. */
+    MultigridSolver(const size_vector_t & size, size_t n_max_cycles = 100, float_t tolerance = 1e-8, size_t n_coarse_nodes = 100);
+    
+    /** Constructs the grid hierarchy for \em grid, which must have been constructed by Image2Grid::construct_grid() or Image2Grid::construct_implicit_grid() for the dimensions \em size. The remaining parameters are the same as for the constructor above. An Exception is thrown if the number of nodes of \em grid does not match \em size, if its nodes have been reordered by Grid::reorder_nodes() or if the nodes of an element are not the corners of a cell of the image grid in the node numbering of Image2Grid. */
+    MultigridSolver(const Grid<fem_types> & grid, const size_vector_t & size, size_t n_max_cycles = 100, float_t tolerance = 1e-8, size_t n_coarse_nodes = 100);
+    
+    /** Returns the number of levels. */
+    size_t n_levels() const { return _sizes.size(); }
+    
+    /** Returns the image dimensions of \em level. */
+    const size_vector_t & level_size(size_t level) const { return _sizes[level]; }
+    
+    /** Uses \em smoother for pre- and post-smoothing on all but the coarsest level. The smoother is applied to the residual equation starting from zero. Only a reference to \em smoother is stored. */
+    void set_smoother(const SolverInterface & smoother) { _smoother = & smoother; }
+    
+    /** Uses \em coarse_solver to solve the system on the coarsest level. Only a reference to \em coarse_solver is stored. */
+    void set_coarse_solver(const SolverInterface & coarse_solver) { _coarse_solver = & coarse_solver; }
+    
+    /** Computes the operators of all coarse levels as Galerkin products of the fine operator \em eqs with the transfer operators. This function must be called again if the values of \em eqs change. */
+    void setup(const ublas::compressed_matrix<float_t> & eqs);
+    
+    /** Sets the operator of \em level (> 0) to \em eqs. Use this function instead of setup() if the coarse operators are obtained by rediscretization. */
+    void set_level_operator(size_t level, const ublas::compressed_matrix<float_t> & eqs);
+    
+    /** Interpolates \em coarse on \em level + 1 to \em fine on \em level. */
+    void prolongate_vector(size_t level, const ublas::vector<float_t> & coarse, ublas::vector<float_t> & fine) const
+      { multiply(_prolongations[level], coarse, fine, 1.0, false); }
+    
+    /** Applies the restriction (the transpose of the prolongation) to \em fine on \em level and writes the result on \em level + 1 to \em coarse. */
+    void restrict_vector(size_t level, const ublas::vector<float_t> & fine, ublas::vector<float_t> & coarse) const
+      { multiply(_restrictions[level], fine, coarse, 1.0, false); }
+    
+    /** Copies the values of the nodes of \em level which are also nodes of \em level + 1 from \em fine to \em coarse. Use this function to transfer nodal data (e.g. the input of an equation) to coarse levels. */
+    void inject_vector(size_t level, const ublas::vector<float_t> & fine, ublas::vector<float_t> & coarse) const;
+    
+    void solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    
+    /** Returns the number of V-cycles of the last call to solve(). */
+    size_t n_cycles() const { return _n_cycles; }
+    
+    /** Returns the relative residual after the last call to solve() if the tolerance is positive. */
+    float_t residual() const { return _residual; }
+  }
+  ;
+  
+  template <class fem_types>
+  MultigridSolver<fem_types>::MultigridSolver(const size_vector_t & size, size_t n_max_cycles, float_t tolerance, size_t n_coarse_nodes) :
+    _n_max_cycles(n_max_cycles), _tolerance(tolerance),
+    _default_smoother(1), _default_coarse_solver(10000, 1e-12, PcgSolver::IC0_PRECONDITIONER),
+    _smoother(& _default_smoother), _coarse_solver(& _default_coarse_solver),
+    _n_cycles(0), _residual(0.0)
+  {
+    init(size, n_coarse_nodes);
+  }
+  
+  template <class fem_types>
+  MultigridSolver<fem_types>::MultigridSolver(const Grid<fem_types> & grid, const size_vector_t & size, size_t n_max_cycles, float_t tolerance, size_t n_coarse_nodes) :
+    _n_max_cycles(n_max_cycles), _tolerance(tolerance),
+    _default_smoother(1), _default_coarse_solver(10000, 1e-12, PcgSolver::IC0_PRECONDITIONER),
+    _smoother(& _default_smoother), _coarse_solver(& _default_coarse_solver),
+    _n_cycles(0), _residual(0.0)
+  {
+    check_grid(grid, size);
+    init(size, n_coarse_nodes);
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::check_grid(const Grid<fem_types> & grid, const size_vector_t & size)
+  {
+    const std::string error = "Exception: Grid does not have the node numbering of Image2Grid for the given dimensions in MultigridSolver::MultigridSolver().";
+    
+    size_t n_cells = 1;
+    for(size_t d = 0; d < N; ++d)
+    {
+      if(size(d) < 2)
+        throw Exception("Exception: Grid must have at least two nodes in each direction in MultigridSolver::MultigridSolver().");
+        
+      n_cells *= size(d) - 1;
+    }
+    
+    if(grid.n_nodes() != n_nodes(size) || ! grid.node_permutation().empty())
+      throw Exception(error);
+      
+    // Image2Grid splits each cell of the image grid into the same number of elements
+    if(grid.n_elements() == 0 || grid.n_elements() % n_cells != 0)
+      throw Exception(error);
+      
+    // the nodes of each element must be the corners of a single cell
+    for(size_t element = 0; element < grid.n_elements(); ++element)
+    {
+      size_vector_t lower, upper;
+      
+      for(size_t i = 0; i < Grid<fem_types>::n_element_nodes; ++i)
+      {
+        size_t index = grid.global_node_index(element, i);
+        
+        for(size_t d = 0; d < N; ++d)
+        {
+          size_t position = index % size(d);
+          index /= size(d);
+          
+          lower(d) = i == 0 ? position : std::min(lower(d), position);
+          upper(d) = i == 0 ? position : std::max(upper(d), position);
+        }
+      }
+      
+      for(size_t d = 0; d < N; ++d)
+        if(upper(d) - lower(d) > 1)
+          throw Exception(error);
+    }
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::init(const size_vector_t & size, size_t n_coarse_nodes)
+  {
+    for(size_t d = 0; d < N; ++d)
+      if(size(d) < 2)
+        throw Exception("Exception: Grid must have at least two nodes in each direction in MultigridSolver::MultigridSolver().");
+    
+    _sizes.push_back(size);
+    
+    while(n_nodes(_sizes.back()) > n_coarse_nodes)
+    {
+      size_vector_t coarse_size;
+      bool is_coarser = true;
+      
+      for(size_t d = 0; d < N; ++d)
+      {
+        coarse_size(d) = _sizes.back()(d) / 2 + 1;
+        if(coarse_size(d) >= _sizes.back()(d))
+          is_coarser = false;
+      }
+      
+      if(! is_coarser)
+        break;
+        
+      _sizes.push_back(coarse_size);
+    }
+    
+    const size_t n = n_levels();
+    
+    _prolongations.resize(n - 1);
+    _restrictions.resize(n - 1);
+    _injections.resize(n - 1);
+    _operators.resize(n);
+    _has_operator.resize(n, false);
+    
+    _level_rhs.resize(n);
+    _level_solutions.resize(n);
+    _level_residuals.resize(n);
+    _level_corrections.resize(n);
+    
+    for(size_t level = 0; level + 1 < n; ++level)
+      construct_transfer(level);
+  }
+  
+  template <class fem_types>
+  size_t MultigridSolver<fem_types>::n_nodes(const size_vector_t & size)
+  {
+    size_t n = 1;
+    for(size_t d = 0; d < N; ++d)
+      n *= size(d);
+      
+    return n;
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::row_range(const ublas::compressed_matrix<float_t> & matrix, size_t row, size_t & begin, size_t & end)
+  {
+    // rows with index larger than filled1() - 2 are empty
+    if(row + 1 < matrix.filled1())
+    {
+      begin = matrix.index1_data()[row];
+      end = matrix.index1_data()[row + 1];
+    }
+    else
+      begin = end = 0;
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::multiply(const ublas::compressed_matrix<float_t> & a, const ublas::vector<float_t> & x, ublas::vector<float_t> & y, float_t factor, bool add)
+  {
+    if(! add)
+      y.resize(a.size1(), false);
+      
+    for(size_t i = 0; i < a.size1(); ++i)
+    {
+      size_t begin, end;
+      row_range(a, i, begin, end);
+      
+      float_t value = 0.0;
+      for(size_t pos = begin; pos < end; ++pos)
+        value += a.value_data()[pos] * x(a.index2_data()[pos]);
+        
+      if(add)
+        y(i) += factor * value;
+      else
+        y(i) = factor * value;
+    }
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::construct_transfer(size_t level)
+  {
+    const size_vector_t & fine_size = _sizes[level];
+    const size_vector_t & coarse_size = _sizes[level + 1];
+    const size_t n_fine = n_nodes(fine_size);
+    const size_t n_coarse = n_nodes(coarse_size);
+    
+    // one dimensional interpolation weights, each fine node depends on at most two coarse nodes
+    std::vector< std::vector<size_t> > indices(N);
+    std::vector< std::vector<float_t> > weights(N);
+    std::vector< std::vector<size_t> > n_entries(N);
+    
+    for(size_t d = 0; d < N; ++d)
+    {
+      indices[d].resize(2 * fine_size(d));
+      weights[d].resize(2 * fine_size(d));
+      n_entries[d].resize(fine_size(d));
+      
+      for(size_t i = 0; i < fine_size(d); ++i)
+      {
+        size_t c0 = i / 2;
+        size_t p0 = coarse_position(c0, fine_size(d));
+        
+        if(p0 == i)
+        {
+          indices[d][2 * i] = c0;
+          weights[d][2 * i] = 1.0;
+          n_entries[d][i] = 1;
+          continue;
+        }
+        
+        size_t c1 = c0 + 1;
+        size_t p1 = coarse_position(c1, fine_size(d));
+        
+        if(p1 == i)
+        {
+          indices[d][2 * i] = c1;
+          weights[d][2 * i] = 1.0;
+          n_entries[d][i] = 1;
+        }
+        else
+        {
+          indices[d][2 * i] = c0;
+          weights[d][2 * i] = float_t(p1 - i) / float_t(p1 - p0);
+          indices[d][2 * i + 1] = c1;
+          weights[d][2 * i + 1] = float_t(i - p0) / float_t(p1 - p0);
+          n_entries[d][i] = 2;
+        }
+      }
+    }
+    
+    // the prolongation is the tensor product of the one dimensional interpolations
+    std::vector<size_t> row_starts(n_fine + 1, 0);
+    std::vector<size_t> columns;
+    std::vector<float_t> values;
+    std::vector< std::pair<size_t, float_t> > row;
+    
+    columns.reserve(n_fine * (size_t(1) << N));
+    values.reserve(n_fine * (size_t(1) << N));
+    
+    size_vector_t fine_index(0);
+    
+    for(size_t node = 0; node < n_fine; ++node)
+    {
+      row.clear();
+      
+      for(size_t combination = 0; combination < (size_t(1) << N); ++combination)
+      {
+        size_t column = 0, stride = 1;
+        float_t weight = 1.0;
+        bool is_valid = true;
+        
+        for(size_t d = 0; d < N; ++d)
+        {
+          size_t entry = (combination >> d) & 1;
+          if(entry >= n_entries[d][fine_index(d)])
+          {
+            is_valid = false;
+            break;
+          }
+          
+          column += stride * indices[d][2 * fine_index(d) + entry];
+          weight *= weights[d][2 * fine_index(d) + entry];
+          stride *= coarse_size(d);
+        }
+        
+        if(is_valid)
+          row.push_back(std::pair<size_t, float_t>(column, weight));
+      }
+      
+      std::sort(row.begin(), row.end());
+      
+      for(size_t k = 0; k < row.size(); ++k)
+      {
+        columns.push_back(row[k].first);
+        values.push_back(row[k].second);
+      }
+      
+      row_starts[node + 1] = columns.size();
+      
+      // advance the multi-index, the first direction runs fastest
+      for(size_t d = 0; d < N; ++d)
+      {
+        if(++fine_index(d) < fine_size(d))
+          break;
+        fine_index(d) = 0;
+      }
+    }
+    
+    ublas::compressed_matrix<float_t> & prolongation = _prolongations[level];
+    prolongation = ublas::compressed_matrix<float_t>(n_fine, n_coarse, columns.size());
+    std::copy(row_starts.begin(), row_starts.end(), prolongation.index1_data().begin());
+    std::copy(columns.begin(), columns.end(), prolongation.index2_data().begin());
+    std::copy(values.begin(), values.end(), prolongation.value_data().begin());
+    prolongation.set_filled(n_fine + 1, columns.size());
+    
+    transpose(prolongation, _restrictions[level]);
+    
+    // fine node of each coarse node
+    std::vector<size_t> & injection = _injections[level];
+    injection.resize(n_coarse);
+    size_vector_t coarse_index(0);
+    
+    for(size_t node = 0; node < n_coarse; ++node)
+    {
+      size_t fine_node = 0, stride = 1;
+      
+      for(size_t d = 0; d < N; ++d)
+      {
+        fine_node += stride * coarse_position(coarse_index(d), fine_size(d));
+        stride *= fine_size(d);
+      }
+      
+      injection[node] = fine_node;
+      
+      for(size_t d = 0; d < N; ++d)
+      {
+        if(++coarse_index(d) < coarse_size(d))
+          break;
+        coarse_index(d) = 0;
+      }
+    }
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::transpose(const ublas::compressed_matrix<float_t> & a, ublas::compressed_matrix<float_t> & a_transposed)
+  {
+    const size_t n_rows = a.size1();
+    const size_t n_columns = a.size2();
+    size_t begin, end;
+    
+    std::vector<size_t> row_starts(n_columns + 1, 0);
+    
+    for(size_t i = 0; i < n_rows; ++i)
+    {
+      row_range(a, i, begin, end);
+      for(size_t pos = begin; pos < end; ++pos)
+        ++row_starts[a.index2_data()[pos] + 1];
+    }
+    
+    for(size_t j = 0; j < n_columns; ++j)
+      row_starts[j + 1] += row_starts[j];
+      
+    const size_t n_non_zeros = row_starts[n_columns];
+    std::vector<size_t> positions(row_starts.begin(), row_starts.end() - 1);
+    
+    a_transposed = ublas::compressed_matrix<float_t>(n_columns, n_rows, n_non_zeros);
+    
+    // the rows of a are traversed in ascending order, hence the columns of a_transposed are sorted
+    for(size_t i = 0; i < n_rows; ++i)
+    {
+      row_range(a, i, begin, end);
+      for(size_t pos = begin; pos < end; ++pos)
+      {
+        size_t & position = positions[a.index2_data()[pos]];
+        a_transposed.index2_data()[position] = i;
+        a_transposed.value_data()[position] = a.value_data()[pos];
+        ++position;
+      }
+    }
+    
+    std::copy(row_starts.begin(), row_starts.end(), a_transposed.index1_data().begin());
+    a_transposed.set_filled(n_columns + 1, n_non_zeros);
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::sparse_product(const ublas::compressed_matrix<float_t> & a, const ublas::compressed_matrix<float_t> & b, ublas::compressed_matrix<float_t> & c)
+  {
+    const size_t n_rows = a.size1();
+    const size_t n_columns = b.size2();
+    
+    std::vector<float_t> accumulator(n_columns, 0.0);
+    std::vector<size_t> marker(n_columns, size_t(-1));
+    std::vector<size_t> row_columns;
+    
+    std::vector<size_t> row_starts(n_rows + 1, 0);
+    std::vector<size_t> columns;
+    std::vector<float_t> values;
+    
+    for(size_t i = 0; i < n_rows; ++i)
+    {
+      size_t a_begin, a_end;
+      row_range(a, i, a_begin, a_end);
+      row_columns.clear();
+      
+      for(size_t a_pos = a_begin; a_pos < a_end; ++a_pos)
+      {
+        const float_t a_value = a.value_data()[a_pos];
+        size_t b_begin, b_end;
+        row_range(b, a.index2_data()[a_pos], b_begin, b_end);
+        
+        for(size_t b_pos = b_begin; b_pos < b_end; ++b_pos)
+        {
+          const size_t j = b.index2_data()[b_pos];
+          
+          if(marker[j] != i)
+          {
+            marker[j] = i;
+            accumulator[j] = 0.0;
+            row_columns.push_back(j);
+          }
+          
+          accumulator[j] += a_value * b.value_data()[b_pos];
+        }
+      }
+      
+      std::sort(row_columns.begin(), row_columns.end());
+      
+      for(size_t k = 0; k < row_columns.size(); ++k)
+      {
+        columns.push_back(row_columns[k]);
+        values.push_back(accumulator[row_columns[k]]);
+      }
+      
+      row_starts[i + 1] = columns.size();
+    }
+    
+    c = ublas::compressed_matrix<float_t>(n_rows, n_columns, columns.size());
+    std::copy(row_starts.begin(), row_starts.end(), c.index1_data().begin());
+    std::copy(columns.begin(), columns.end(), c.index2_data().begin());
+    std::copy(values.begin(), values.end(), c.value_data().begin());
+    c.set_filled(n_rows + 1, columns.size());
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::setup(const ublas::compressed_matrix<float_t> & eqs)
+  {
+    if(eqs.size1() != n_nodes(_sizes[0]) || eqs.size2() != eqs.size1())
+      throw Exception("Exception: Dimensions do not agree in MultigridSolver::setup().");
+      
+    ublas::compressed_matrix<float_t> product;
+    const ublas::compressed_matrix<float_t> * fine_operator = & eqs;
+    
+    for(size_t level = 0; level + 1 < n_levels(); ++level)
+    {
+      sparse_product(*fine_operator, _prolongations[level], product);
+      sparse_product(_restrictions[level], product, _operators[level + 1]);
+      _has_operator[level + 1] = true;
+      fine_operator = & _operators[level + 1];
+    }
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::set_level_operator(size_t level, const ublas::compressed_matrix<float_t> & eqs)
+  {
+    if(level == 0 || level >= n_levels())
+      throw Exception("Exception: Invalid level in MultigridSolver::set_level_operator().");
+      
+    if(eqs.size1() != n_nodes(_sizes[level]) || eqs.size2() != eqs.size1())
+      throw Exception("Exception: Dimensions do not agree in MultigridSolver::set_level_operator().");
+      
+    _operators[level] = eqs;
+    _has_operator[level] = true;
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::inject_vector(size_t level, const ublas::vector<float_t> & fine, ublas::vector<float_t> & coarse) const
+  {
+    const std::vector<size_t> & injection = _injections[level];
+    
+    if(fine.size() != n_nodes(_sizes[level]))
+      throw Exception("Exception: Dimensions do not agree in MultigridSolver::inject_vector().");
+      
+    coarse.resize(injection.size(), false);
+    
+    for(size_t i = 0; i < injection.size(); ++i)
+      coarse(i) = fine(injection[i]);
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::smooth(size_t level, const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    ublas::vector<float_t> & residual = _level_residuals[level];
+    ublas::vector<float_t> & correction = _level_corrections[level];
+    
+    residual.resize(rhs.size(), false);
+    correction.resize(rhs.size(), false);
+    
+    noalias(residual) = rhs;
+    multiply(eqs, result, residual, -1.0, true);
+    
+    correction.clear();
+    _smoother->solve(eqs, residual, correction);
+    noalias(result) += correction;
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::cycle(size_t level, const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    if(level + 1 == n_levels())
+    {
+      _coarse_solver->solve(eqs, rhs, result);
+      return;
+    }
+    
+    smooth(level, eqs, rhs, result);
+    
+    ublas::vector<float_t> & residual = _level_residuals[level];
+    noalias(residual) = rhs;
+    multiply(eqs, result, residual, -1.0, true);
+    
+    restrict_vector(level, residual, _level_rhs[level + 1]);
+    
+    ublas::vector<float_t> & coarse_solution = _level_solutions[level + 1];
+    coarse_solution.resize(_level_rhs[level + 1].size(), false);
+    coarse_solution.clear();
+    
+    cycle(level + 1, _operators[level + 1], _level_rhs[level + 1], coarse_solution);
+    
+    multiply(_prolongations[level], coarse_solution, result, 1.0, true);
+    
+    smooth(level, eqs, rhs, result);
+  }
+  
+  template <class fem_types>
+  void MultigridSolver<fem_types>::solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    const size_t size = n_nodes(_sizes[0]);
+    
+    if(eqs.size1() != size || eqs.size2() != size || rhs.size() != size)
+      throw Exception("Exception: Dimensions do not agree in MultigridSolver::solve().");
+      
+    for(size_t level = 1; level < n_levels(); ++level)
+      if(! _has_operator[level])
+        throw Exception("Exception: Coarse operators are not set up in MultigridSolver::solve().");
+        
+    if(result.size() != size)
+    {
+      result.resize(size);
+      result.clear();
+    }
+    
+    _n_cycles = 0;
+    _residual = 0.0;
+    
+    const float_t rhs_norm = norm_2(rhs);
+    
+    if(rhs_norm == 0.0)
+    {
+      result.clear();
+      return;
+    }
+    
+    ublas::vector<float_t> & residual = _level_residuals[0];
+    residual.resize(size, false);
+    
+    while(_n_cycles < _n_max_cycles)
+    {
+      cycle(0, eqs, rhs, result);
+      ++_n_cycles;
+      
+      if(_tolerance > 0.0)
+      {
+        noalias(residual) = rhs;
+        multiply(eqs, result, residual, -1.0, true);
+        _residual = norm_2(residual) / rhs_norm;
+        
+        if(_residual < _tolerance)
+          break;
+      }
+    }
+  }
+}
+
+
+#endif
@@ -0,0 +1,41 @@
+#include <fem/RegularGrid.hpp>
+
+namespace imaging
+{
+  namespace regular_grid_impl
+  {
+    template <>
+    void element_corner<fem_2d_square_types>(size_t vertex, ublas::fixed_vector<size_t, 2> & corner)
+    {
+      // counter-clockwise as in image2grid_impl::populate_grid()
+      static const size_t corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+      
+      corner(0) = corners[vertex][0];
+      corner(1) = corners[vertex][1];
+    }
+    
+    template <>
+    size_t side_face<fem_2d_square_types>(size_t side)
+    {
+      static const size_t faces[4] = {3, 1, 0, 2};
+      
+      return faces[side];
+    }
+    
+    template <>
+    void element_corner<fem_3d_cube_types>(size_t vertex, ublas::fixed_vector<size_t, 3> & corner)
+    {
+      corner(0) = vertex & 1;
+      corner(1) = (vertex >> 1) & 1;
+      corner(2) = (vertex >> 2) & 1;
+    }
+    
+    template <>
+    size_t side_face<fem_3d_cube_types>(size_t side)
+    {
+      static const size_t faces[6] = {2, 3, 4, 5, 0, 1};
+      
+      return faces[side];
+    }
+  }
+}
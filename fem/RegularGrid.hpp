@@ -0,0 +1,296 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FEM_REGULARGRID_H
+#define FEM_REGULARGRID_H
+
+#include <fem/fem_2d_square_types.hpp>
+#include <fem/fem_3d_cube_types.hpp>
+
+
+namespace imaging
+{
+  /** \cond */
+  namespace regular_grid_impl
+  {
+    // the corner of the element vertex 'vertex' on the reference element, 0 for the lower and 1 for the upper bound along each axis
+    template <class fem_types>
+    void element_corner(size_t vertex, ublas::fixed_vector<size_t, fem_types::data_dimension> & corner)
+    {
+      throw Exception("Exception: RegularGrid is not implemented for this element type in RegularGrid::RegularGrid().");
+    }
+    
+    // the index of the element face which lies on the side 2 * axis (lower bound) or 2 * axis + 1 (upper bound) of the element
+    template <class fem_types>
+    size_t side_face(size_t side)
+    {
+      throw Exception("Exception: RegularGrid is not implemented for this element type in RegularGrid::parent_element_face().");
+    }
+    
+    template <>
+    void element_corner<fem_2d_square_types>(size_t vertex, ublas::fixed_vector<size_t, 2> & corner);
+    
+    template <>
+    size_t side_face<fem_2d_square_types>(size_t side);
+    
+    template <>
+    void element_corner<fem_3d_cube_types>(size_t vertex, ublas::fixed_vector<size_t, 3> & corner);
+    
+    template <>
+    size_t side_face<fem_3d_cube_types>(size_t side);
+  }
+  /** \endcond */
+
+  /** \ingroup fem
+      \brief Computes the vertices, the connectivity and the boundary of a grid of pixels or voxels from their indices.
+      
+      The grids constructed by Image2Grid::construct_grid() store the coordinates of each vertex and the global vertex and node indices of each element explicitly, although for an undisplaced pixel or voxel grid all of these can be computed from the indices of the elements. RegularGrid implements this computation for the dimensions of an image. The elements and vertices are numbered as in Image2Grid::construct_grid(), i.e. the vertex with image index (\em i, \em j, \em k) has the global index <tt>i + j * n_x + k * n_x * n_y</tt> and the same holds for the elements with the numbers of elements along each axis. The boundary elements are numbered side by side, i.e. first the elements with the element face at the lower bound of the \em x axis, then the upper bound of the \em x axis, then the lower bound of the \em y axis and so forth.
+      
+      A RegularGrid object only stores the dimensions of the grid. Pass it to Grid::set_implicit() (or call Image2Grid::construct_implicit_grid()) to obtain a Grid which does not store any vertex, element or boundary tables. RegularGrid is implemented for fem_2d_square_types and fem_3d_cube_types.
+  */
+  template <class fem_types>
+  class RegularGrid
+  {
+  public:
+    /** \brief The number of coordinates of the element vertices (determined by the template parameter \em fem_types).*/
+    static const size_t data_dimension = fem_types::data_dimension;
+    
+    /** \brief The number of vertices per element (determined by the template parameter \em fem_types). */
+    static const size_t n_element_vertices = fem_types::transform_t::n_element_vertices;
+    
+    /** \brief The data type of the element coordinates (determined by the template parameter \em fem_types). */
+    typedef ublas::fixed_vector<float_t, data_dimension> vertex_t;
+    
+  private:
+    static const size_t N_SIDES = 2 * data_dimension;
+    
+    ublas::fixed_vector<size_t, data_dimension> _size;
+    ublas::fixed_vector<size_t, n_element_vertices> _vertex_offsets;
+    ublas::fixed_vector<size_t, N_SIDES + 1> _side_begin;
+    size_t _n_vertices;
+    size_t _n_elements;
+    
+  public:
+    /** Constructs an empty RegularGrid. */
+    RegularGrid() : _size(0), _vertex_offsets(0), _side_begin(0), _n_vertices(0), _n_elements(0) {}
+    
+    /** Constructs a RegularGrid with \em size vertices along each axis, i.e. the grid of an image of size \em size as constructed by Image2Grid. Throws an Exception if \em size is less than 2 along any axis. */
+    explicit RegularGrid(const ublas::fixed_vector<size_t, data_dimension> & size);
+    
+    /** Returns the number of vertices along each axis. */
+    const ublas::fixed_vector<size_t, data_dimension> & size() const { return _size; }
+    
+    /** Returns the number of vertices. This is also the number of nodes. */
+    size_t n_vertices() const { return _n_vertices; }
+    
+    /** Returns the number of elements. */
+    size_t n_elements() const { return _n_elements; }
+    
+    /** Returns the number of boundary elements. */
+    size_t n_boundary_elements() const { return _side_begin(N_SIDES); }
+    
+    /** Returns the number of vertices at the boundary of the grid. */
+    size_t n_boundary_vertices() const
+    {
+      size_t n_inner_vertices = 1;
+      
+      for(size_t i = 0; i < data_dimension; ++i)
+        n_inner_vertices *= _size(i) - 2;
+        
+      return _n_vertices - n_inner_vertices;
+    }
+    
+    /** Returns the global index of the vertex \em vertex_index of the element \em element_index. */
+    size_t global_vertex_index(size_t element_index, size_t vertex_index) const
+    {
+      size_t lower_vertex = 0;
+      size_t stride = 1;
+      
+      for(size_t i = 0; i < data_dimension; ++i)
+      {
+        lower_vertex += (element_index % (_size(i) - 1)) * stride;
+        element_index /= _size(i) - 1;
+        stride *= _size(i);
+      }
+      
+      return lower_vertex + _vertex_offsets(vertex_index);
+    }
+    
+    /** Returns the coordinates of the vertex \em global_vertex_index. As in Image2Grid the vertex with image index \em index lies at <tt>index + 0.5</tt>. */
+    vertex_t vertex(size_t global_vertex_index) const
+    {
+      vertex_t vertex;
+      
+      for(size_t i = 0; i < data_dimension; ++i)
+      {
+        vertex(i) = 0.5 + float_t(global_vertex_index % _size(i));
+        global_vertex_index /= _size(i);
+      }
+      
+      return vertex;
+    }
+    
+    /** Returns the index of the parent element of the boundary element \em boundary_element_index. */
+    size_t parent_element(size_t boundary_element_index) const;
+    
+    /** Returns the index of the face of the parent element of the boundary element \em boundary_element_index. */
+    size_t parent_element_face(size_t boundary_element_index) const
+    { 
+      return regular_grid_impl::side_face<fem_types>(side(boundary_element_index));
+    }
+    
+    /** Returns true if the vertex \em global_vertex_index lies at the boundary of the grid. */
+    bool is_boundary_vertex(size_t global_vertex_index) const
+    {
+      for(size_t i = 0; i < data_dimension; ++i)
+      {
+        size_t index = global_vertex_index % _size(i);
+        
+        if(index == 0 || index == _size(i) - 1)
+          return true;
+          
+        global_vertex_index /= _size(i);
+      }
+      
+      return false;
+    }
+    
+    /** Returns the unit outer normal of the grid boundary at the vertex \em global_vertex_index. At edges and corners this is the normalized sum of the normals of the adjacent sides. Throws an Exception if the vertex is not at the boundary. */
+    vertex_t boundary_normal(size_t global_vertex_index) const;
+    
+  private:
+    size_t side(size_t boundary_element_index) const
+    {
+      size_t side = 0;
+      
+      while(boundary_element_index >= _side_begin(side + 1))
+        ++side;
+        
+      return side;
+    }
+  }
+  ;
+  
+  template <class fem_types>
+  const size_t RegularGrid<fem_types>::N_SIDES;
+  
+  template <class fem_types>
+  RegularGrid<fem_types>::RegularGrid(const ublas::fixed_vector<size_t, data_dimension> & size) :
+    _size(size)
+  {
+    _n_vertices = 1;
+    _n_elements = 1;
+    
+    for(size_t i = 0; i < data_dimension; ++i)
+    {
+      if(_size(i) < 2)
+        throw Exception("Exception: Grid must have at least 2 vertices along each axis in RegularGrid::RegularGrid().");
+        
+      _n_vertices *= _size(i);
+      _n_elements *= _size(i) - 1;
+    }
+    
+    for(size_t vertex = 0; vertex < n_element_vertices; ++vertex)
+    {
+      ublas::fixed_vector<size_t, data_dimension> corner;
+      regular_grid_impl::element_corner<fem_types>(vertex, corner);
+      
+      size_t offset = 0;
+      size_t stride = 1;
+      
+      for(size_t i = 0; i < data_dimension; ++i)
+      {
+        offset += corner(i) * stride;
+        stride *= _size(i);
+      }
+      
+      _vertex_offsets(vertex) = offset;
+    }
+    
+    _side_begin(0) = 0;
+    
+    for(size_t side = 0; side < N_SIDES; ++side)
+      _side_begin(side + 1) = _side_begin(side) + _n_elements / (_size(side / 2) - 1);
+  }
+  
+  template <class fem_types>
+  size_t RegularGrid<fem_types>::parent_element(size_t boundary_element_index) const
+  {
+    const size_t side = this->side(boundary_element_index);
+    const size_t axis = side / 2;
+    
+    size_t index = boundary_element_index - _side_begin(side);
+    size_t element = 0;
+    size_t stride = 1;
+    
+    for(size_t i = 0; i < data_dimension; ++i)
+    {
+      const size_t n_elements = _size(i) - 1;
+      
+      if(i == axis)
+      {
+        if(side % 2)
+          element += (n_elements - 1) * stride;
+      }
+      else
+      {
+        element += (index % n_elements) * stride;
+        index /= n_elements;
+      }
+      
+      stride *= n_elements;
+    }
+    
+    return element;
+  }
+  
+  template <class fem_types>
+  typename RegularGrid<fem_types>::vertex_t RegularGrid<fem_types>::boundary_normal(size_t global_vertex_index) const
+  {
+    vertex_t normal(0.0);
+    float_t n_sides = 0.0;
+    
+    for(size_t i = 0; i < data_dimension; ++i)
+    {
+      size_t index = global_vertex_index % _size(i);
+      
+      if(index == 0)
+      {
+        normal(i) = -1.0;
+        n_sides += 1.0;
+      }
+      else if(index == _size(i) - 1)
+      {
+        normal(i) = 1.0;
+        n_sides += 1.0;
+      }
+        
+      global_vertex_index /= _size(i);
+    }
+    
+    if(n_sides == 0.0)
+      throw Exception("Exception: Invalid argument 'global_vertex_index' in RegularGrid::boundary_normal().");
+      
+    return normal / sqrt(n_sides);
+  }
+}
+
+
+#endif
@@ -38,6 +38,14 @@ namespace imaging
     Assembler _assembler;
     
   public:
+    /** Constructs a SimpleAssembler which computes the element contributions with \em n_threads threads (cf. Assembler::Assembler()). */
+    SimpleAssembler(size_t n_threads = 1) : _assembler(n_threads) {}
+    
+    /** Returns the number of threads used for the assembly. */
+    size_t n_threads() const { return _assembler.n_threads(); }
+    
+    /** Sets the number of threads used for the assembly. */
+    void set_n_threads(size_t n_threads) { _assembler.set_n_threads(n_threads); }
 
     /** Assembles the stiffness matrix and the force vector for \em simple_equation on \em grid. This is done in one big loop and thus faster than calling assemble_stiffness_matrix() and assemble_force_vector() separately. For performance reasons the type of \em simple_equation is a template parameter.
     
@@ -76,6 +84,74 @@ namespace imaging
     void assemble_force_vector(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
                   ublas::vector<float_t> & force_vector) const;
 
+    /** Assembles the stiffness matrix and the force vector for \em simple_equation on \em grid using the precomputed matrix positions in \em assembly_map (cf. Assembler::assemble()).
+    
+        \sa AssemblyMap
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix,
+                  ublas::vector<float_t> & force_vector) const;
+                  
+    /** Assembles the stiffness matrix for \em simple_equation on \em grid using the precomputed matrix positions in \em assembly_map (cf. Assembler::assemble_stiffness_matrix()).
+    
+        \sa AssemblyMap
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble_stiffness_matrix(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+
+    /** Assembles the stiffness matrix and the force vector for \em simple_equation on \em grid using the element geometry in \em geometry_cache (cf. Assembler::assemble()).
+    
+        \sa GridGeometryCache
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix,
+                  ublas::vector<float_t> & force_vector) const;
+                  
+    /** Assembles the stiffness matrix for \em simple_equation on \em grid using the element geometry in \em geometry_cache (cf. Assembler::assemble_stiffness_matrix()).
+    
+        \sa GridGeometryCache
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble_stiffness_matrix(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+                  
+    /** Assembles the force vector for \em simple_equation on \em grid using the element geometry in \em geometry_cache (cf. Assembler::assemble_force_vector()).
+    
+        \sa GridGeometryCache
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble_force_vector(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  ublas::vector<float_t> & force_vector) const;
+
+    /** Assembles the stiffness matrix and the force vector for \em simple_equation on \em grid using the element geometry in \em geometry_cache and the precomputed matrix positions in \em assembly_map (cf. Assembler::assemble()).
+    
+        \sa GridGeometryCache, AssemblyMap
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix,
+                  ublas::vector<float_t> & force_vector) const;
+                  
+    /** Assembles the stiffness matrix for \em simple_equation on \em grid using the element geometry in \em geometry_cache and the precomputed matrix positions in \em assembly_map (cf. Assembler::assemble_stiffness_matrix()).
+    
+        \sa GridGeometryCache, AssemblyMap
+    */
+    template<class fem_types, class simple_equation_t>
+    void assemble_stiffness_matrix(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                  const GridGeometryCache<fem_types> & geometry_cache,
+                  const AssemblyMap & assembly_map,
+                  ublas::compressed_matrix<float_t> & stiffness_matrix) const;
+
   }
   ;
 
@@ -105,6 +181,78 @@ namespace imaging
     SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
     _assembler.assemble_force_vector(adaptor, grid, force_vector);
   }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                                 const AssemblyMap & assembly_map,
+                                 ublas::compressed_matrix<float_t> & stiffness_matrix,
+                                 ublas::vector<float_t> & force_vector) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble(adaptor, grid, assembly_map, stiffness_matrix, force_vector);
+  }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble_stiffness_matrix(const simple_equation_t & simple_equation,
+                                      const Grid<fem_types> & grid,
+                                      const AssemblyMap & assembly_map,
+                                      ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble_stiffness_matrix(adaptor, grid, assembly_map, stiffness_matrix);
+  }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                                 const GridGeometryCache<fem_types> & geometry_cache,
+                                 ublas::compressed_matrix<float_t> & stiffness_matrix,
+                                 ublas::vector<float_t> & force_vector) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble(adaptor, grid, geometry_cache, stiffness_matrix, force_vector);
+  }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble_stiffness_matrix(const simple_equation_t & simple_equation,
+                                      const Grid<fem_types> & grid,
+                                      const GridGeometryCache<fem_types> & geometry_cache,
+                                      ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble_stiffness_matrix(adaptor, grid, geometry_cache, stiffness_matrix);
+  }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble_force_vector(const simple_equation_t & simple_equation,
+                                      const Grid<fem_types> & grid,
+                                      const GridGeometryCache<fem_types> & geometry_cache,
+                                      ublas::vector<float_t> & force_vector) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble_force_vector(adaptor, grid, geometry_cache, force_vector);
+  }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble(const simple_equation_t & simple_equation, const Grid<fem_types> & grid,
+                                 const GridGeometryCache<fem_types> & geometry_cache,
+                                 const AssemblyMap & assembly_map,
+                                 ublas::compressed_matrix<float_t> & stiffness_matrix,
+                                 ublas::vector<float_t> & force_vector) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble(adaptor, grid, geometry_cache, assembly_map, stiffness_matrix, force_vector);
+  }
+
+  template<class fem_types, class simple_equation_t>
+  void SimpleAssembler::assemble_stiffness_matrix(const simple_equation_t & simple_equation,
+                                      const Grid<fem_types> & grid,
+                                      const GridGeometryCache<fem_types> & geometry_cache,
+                                      const AssemblyMap & assembly_map,
+                                      ublas::compressed_matrix<float_t> & stiffness_matrix) const
+  {
+    SimpleEquationAdaptor<simple_equation_t> adaptor(simple_equation);
+    _assembler.assemble_stiffness_matrix(adaptor, grid, geometry_cache, assembly_map, stiffness_matrix);
+  }
 }
 
 
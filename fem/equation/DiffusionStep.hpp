@@ -82,7 +82,7 @@ namespace imaging
                           float_t & c) const
     { 
       float_t local_diffusion;
-      kernel.grid().interpolate_value(integrator_node, *_diffusion_ptr, kernel, local_diffusion);
+      local_diffusion = kernel.interpolated_value(integrator_node, *_diffusion_ptr, SECOND_GATHER_SLOT);
       A = _step_size * local_diffusion * ublas::identity_matrix<float_t>(fem_types::data_dimension);
       c = 1.0;
     }
@@ -92,7 +92,7 @@ namespace imaging
                       float_t & f,
                       ublas::fixed_vector<float_t, fem_types::data_dimension> & g) const
     {
-      kernel.grid().interpolate_value(integrator_node, *_input_ptr, kernel, f);
+      f = kernel.interpolated_value(integrator_node, *_input_ptr, FIRST_GATHER_SLOT);
     }
     
     bool sanity_check_stiffness_matrix(const FemKernel<fem_types> & kernel, std::string & error_message) const
@@ -121,8 +121,8 @@ namespace imaging
       float_t local_edge;
       ublas::fixed_vector<float_t, fem_types::data_dimension > local_gradient;
       
-      kernel.grid().interpolate_value(integrator_node, *_edges_ptr, kernel, local_edge);
-      kernel.grid().interpolate_gradient(integrator_node, *_initial_function_ptr, kernel, local_gradient);
+      local_edge = kernel.interpolated_value(integrator_node, *_edges_ptr, FIRST_GATHER_SLOT);
+      local_gradient = kernel.interpolated_gradient(integrator_node, *_initial_function_ptr, SECOND_GATHER_SLOT);
       
       A = _step_size * exp(- _edge_parameter * square(local_edge)) / regularized_abs(local_gradient) *
                 ublas::identity_matrix<float_t>(fem_types::data_dimension);
@@ -140,9 +140,9 @@ namespace imaging
       float_t local_edge, local_value;
       ublas::fixed_vector<float_t, fem_types::data_dimension > local_gradient;
       
-      kernel.grid().interpolate_value(integrator_node, *_edges_ptr, kernel, local_edge);
-      kernel.grid().interpolate_value(integrator_node, *_initial_function_ptr, kernel, local_value);
-      kernel.grid().interpolate_gradient(integrator_node, *_initial_function_ptr, kernel, local_gradient);
+      local_edge = kernel.interpolated_value(integrator_node, *_edges_ptr, FIRST_GATHER_SLOT);
+      local_value = kernel.interpolated_value(integrator_node, *_initial_function_ptr, SECOND_GATHER_SLOT);
+      local_gradient = kernel.interpolated_gradient(integrator_node, *_initial_function_ptr, SECOND_GATHER_SLOT);
       
       f =  local_value / regularized_abs(local_gradient) + _step_size * exp(- _edge_parameter * square(local_edge)) * _balloon_force;
     }
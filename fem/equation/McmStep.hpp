@@ -86,7 +86,7 @@ namespace imaging
                           float_t & c) const
     {
       ublas::fixed_vector <float_t, fem_types::data_dimension> local_gradient;
-      kernel.grid().interpolate_gradient(integrator_node, *_input_ptr, kernel, local_gradient);
+      local_gradient = kernel.interpolated_gradient(integrator_node, *_input_ptr, FIRST_GATHER_SLOT);
       
       float_t regularized_abs_gradient = regularized_abs(local_gradient);
       A = _step_size / regularized_abs_gradient * ublas::identity_matrix<float_t>(fem_types::data_dimension);
@@ -99,10 +99,10 @@ namespace imaging
                       ublas::fixed_vector<float_t, fem_types::data_dimension> & g) const
     { 
       float_t local_input;
-      kernel.grid().interpolate_value(integrator_node, *_input_ptr, kernel, local_input);
+      local_input = kernel.interpolated_value(integrator_node, *_input_ptr, FIRST_GATHER_SLOT);
 
       ublas::fixed_vector <float_t, fem_types::data_dimension> local_gradient;
-      kernel.grid().interpolate_gradient(integrator_node, *_input_ptr, kernel, local_gradient);
+      local_gradient = kernel.interpolated_gradient(integrator_node, *_input_ptr, FIRST_GATHER_SLOT);
 
       f = local_input / regularized_abs(local_gradient);
     }
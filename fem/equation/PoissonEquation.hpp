@@ -78,7 +78,7 @@ namespace imaging
                       float_t & f,
                       ublas::fixed_vector<float_t, fem_types::data_dimension> & g) const
     {
-      kernel.grid().interpolate_value(integrator_node, * _rhs_ptr, kernel, f);
+      f = kernel.interpolated_value(integrator_node, *_rhs_ptr, FIRST_GATHER_SLOT);
     }
     
     void force_vector_at_boundary (std::size_t integrator_node,
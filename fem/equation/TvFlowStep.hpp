@@ -81,7 +81,7 @@ namespace imaging
                           float_t & c) const
     {
       ublas::fixed_vector<float_t, fem_types::data_dimension> local_gradient;
-      kernel.grid().interpolate_gradient(integrator_node, *_input_ptr, kernel, local_gradient);
+      local_gradient = kernel.interpolated_gradient(integrator_node, *_input_ptr, FIRST_GATHER_SLOT);
       A = _step_size / sqrt(inner_prod(local_gradient, local_gradient) + square(_epsilon)) *
               ublas::identity_matrix<float_t>(fem_types::data_dimension);
       c = 1.0;
@@ -92,7 +92,7 @@ namespace imaging
                       float_t & f,
                       ublas::fixed_vector<float_t, fem_types::data_dimension> & g) const
     {
-      kernel.grid().interpolate_value(integrator_node, *_input_ptr, kernel, f);
+      f = kernel.interpolated_value(integrator_node, *_input_ptr, FIRST_GATHER_SLOT);
     }
     
     bool sanity_check_stiffness_matrix(const FemKernel<fem_types> & kernel, std::string & error_message) const
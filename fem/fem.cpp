@@ -15,7 +15,8 @@
 #include <fem/equation/SimpleEquationAdaptor.hpp>
 #include <fem/Image2Grid.hpp>
 #include <fem/SimpleAssembler.hpp>
-#include <solver/CgSolver.hpp>
+#include <fem/AssemblyMap.hpp>
+#include <solver/PcgSolver.hpp>
 
 #include <graphics/OpenGlViewer.hpp>
 #include <image/gio.hpp>
@@ -43,7 +44,12 @@ void filter(std::string file_name, img::float_t diffusion_step_size, img::float_
 
     Image2Grid<fem_types> image2grid(input_image.size());
     image2grid.construct_grid(grid);
-    image2grid.stiffness_matrix_prototype(stiffness_matrix);
+    
+    //The sparsity pattern of the stiffness matrix and the positions of the
+    //element entries do not change during the iteration
+    AssemblyMap assembly_map;
+    assembly_map.construct(grid, stiffness_matrix);
+    
     image2grid.image2vector(input_accessor, *input_1);
     image2grid.image2vector(input_accessor, *input_2);
     image2grid.image2vector(input_accessor, *input_3);
@@ -76,7 +82,7 @@ void filter(std::string file_name, img::float_t diffusion_step_size, img::float_
     //force vector -> right hand side of the equation
     ublas::vector<float_t> force_vector;
     //solver -> type of solver 
-    CgSolver solver;
+    PcgSolver solver(10000, 1e-8, PcgSolver::IC0_PRECONDITIONER);
 
 
     //Creating output accessors 
@@ -98,15 +104,15 @@ void filter(std::string file_name, img::float_t diffusion_step_size, img::float_
       /*Assembling of stiffness matrix, force vector of the corresponding 
         equation and solving the system of equations*/
       //mean curvature motion
-      assembler.assemble(mcm_equation, grid, stiffness_matrix, force_vector);
+      assembler.assemble(mcm_equation, grid, assembly_map, stiffness_matrix, force_vector);
       solver.solve(stiffness_matrix, force_vector, *input_1);
 
       //total variation flow 
-      assembler.assemble(tvf_equation, grid, stiffness_matrix, force_vector);
+      assembler.assemble(tvf_equation, grid, assembly_map, stiffness_matrix, force_vector);
       solver.solve(stiffness_matrix, force_vector, *input_2);
 
       //diffusion equation
-      assembler.assemble(diffusion_equation, grid, stiffness_matrix, force_vector);
+      assembler.assemble(diffusion_equation, grid, assembly_map, stiffness_matrix, force_vector);
       solver.solve(stiffness_matrix, force_vector, *input_3);
 
 
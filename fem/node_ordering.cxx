@@ -0,0 +1,127 @@
+#include <fem/node_ordering.hpp>
+
+namespace imaging
+{
+  /** \cond */
+  namespace node_ordering_impl
+  {
+    struct degree_order
+    {
+      const std::vector<std::size_t> & _offsets;
+      
+      degree_order(const std::vector<std::size_t> & offsets) : _offsets(offsets) {}
+      
+      std::size_t degree(std::size_t node) const { return _offsets[node + 1] - _offsets[node]; }
+      
+      bool operator()(std::size_t a, std::size_t b) const
+      {
+        return degree(a) < degree(b) || (degree(a) == degree(b) && a < b);
+      }
+    };
+    
+    // writes the nodes of the component of 'root' in breadth-first order to 'order' starting at position 'begin'
+    // the neighbours of each node are visited in the order of increasing degree
+    // returns the end of the component in 'order', the number of levels and the beginning of the last level
+    std::size_t breadth_first_search(const std::vector<std::size_t> & offsets, const std::vector<std::size_t> & neighbours, std::size_t root, std::size_t search,
+                                     std::vector<std::size_t> & searches, std::vector<std::size_t> & order, std::size_t begin, std::size_t & n_levels, std::size_t & last_level)
+    {
+      degree_order compare(offsets);
+      std::size_t end = begin;
+      
+      order[end++] = root;
+      searches[root] = search;
+      n_levels = 0;
+      
+      for(std::size_t level_begin = begin; level_begin < end; )
+      {
+        std::size_t level_end = end;
+        last_level = level_begin;
+        ++n_levels;
+        
+        for(std::size_t i = level_begin; i < level_end; ++i)
+        {
+          std::size_t node = order[i];
+          std::size_t first_child = end;
+          
+          for(std::size_t j = offsets[node]; j < offsets[node + 1]; ++j)
+          {
+            if(searches[neighbours[j]] != search)
+            {
+              searches[neighbours[j]] = search;
+              order[end++] = neighbours[j];
+            }
+          }
+          
+          std::sort(order.begin() + first_child, order.begin() + end, compare);
+        }
+        
+        level_begin = level_end;
+      }
+      
+      return end;
+    }
+  }
+  /** \endcond */
+  
+  void reverse_cuthill_mckee_ordering(const std::vector<std::size_t> & offsets, const std::vector<std::size_t> & neighbours, std::vector<std::size_t> & permutation)
+  {
+    if(offsets.size() == 0)
+      throw Exception("Exception: Empty argument 'offsets' in reverse_cuthill_mckee_ordering().");
+    
+    const std::size_t n_nodes = offsets.size() - 1;
+    
+    node_ordering_impl::degree_order compare(offsets);
+    
+    // the nodes in the order of increasing degree are the candidates for the roots of the components
+    std::vector<std::size_t> candidates(n_nodes);
+    for(std::size_t i = 0; i < n_nodes; ++i)
+      candidates[i] = i;
+    std::sort(candidates.begin(), candidates.end(), compare);
+    
+    std::vector<std::size_t> order(n_nodes);
+    std::vector<std::size_t> searches(n_nodes, 0);
+    std::vector<bool> is_ordered(n_nodes, false);
+    std::size_t n_ordered = 0;
+    std::size_t search = 0;
+    
+    for(std::size_t c = 0; c < n_nodes; ++c)
+    {
+      if(is_ordered[candidates[c]])
+        continue;
+      
+      // find a pseudo-peripheral node of the component by repeated breadth-first search (George and Liu)
+      std::size_t root = candidates[c];
+      std::size_t n_levels, last_level;
+      std::size_t end = node_ordering_impl::breadth_first_search(offsets, neighbours, root, ++search, searches, order, n_ordered, n_levels, last_level);
+      
+      while(true)
+      {
+        std::size_t candidate = *std::min_element(order.begin() + last_level, order.begin() + end, compare);
+        std::size_t candidate_n_levels, candidate_last_level;
+        node_ordering_impl::breadth_first_search(offsets, neighbours, candidate, ++search, searches, order, n_ordered, candidate_n_levels, candidate_last_level);
+        
+        if(candidate_n_levels <= n_levels)
+        {
+          // 'order' holds the search from 'candidate', restore the one from 'root'
+          node_ordering_impl::breadth_first_search(offsets, neighbours, root, ++search, searches, order, n_ordered, n_levels, last_level);
+          break;
+        }
+        
+        root = candidate;
+        n_levels = candidate_n_levels;
+        last_level = candidate_last_level;
+      }
+      
+      for(std::size_t i = n_ordered; i < end; ++i)
+        is_ordered[order[i]] = true;
+      
+      n_ordered = end;
+    }
+    
+    // reverse the Cuthill-McKee order
+    permutation.resize(n_nodes);
+    
+    for(std::size_t i = 0; i < n_nodes; ++i)
+      permutation[order[i]] = n_nodes - 1 - i;
+  }
+}
@@ -0,0 +1,109 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FEM_NODE_ORDERING_H
+#define FEM_NODE_ORDERING_H
+
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+
+#include <core/imaging2.hpp>
+
+namespace imaging
+{
+  /** \ingroup fem
+      <tt>\#include <fem/node_ordering.hpp></tt>
+      
+      Computes the reverse Cuthill-McKee ordering of an undirected graph with \em n nodes which is given in compressed row storage. The neighbours of the node \em i are stored in \em neighbours at the positions <tt>offsets[i]</tt> to <tt>offsets[i + 1] - 1</tt>, i.e. \em offsets has <em>n + 1</em> entries. On return, <tt>permutation[i]</tt> is the new index of the node \em i. Each connected component is traversed breadth-first starting from a pseudo-peripheral node, visiting the neighbours of a node in the order of increasing degree. Reversing the resulting order minimizes the profile of the adjacency matrix and thus the fill-in of its LU factorization.
+  */
+  void reverse_cuthill_mckee_ordering(const std::vector<std::size_t> & offsets, const std::vector<std::size_t> & neighbours, std::vector<std::size_t> & permutation);
+
+  /** \cond */
+  namespace node_ordering_impl
+  {
+    struct MortonKey
+    {
+      boost::uint64_t _key;
+      std::size_t _index;
+      
+      bool operator<(const MortonKey & key) const { return _key < key._key || (_key == key._key && _index < key._index); }
+    };
+  }
+  /** \endcond */
+
+  /** \ingroup fem
+      <tt>\#include <fem/node_ordering.hpp></tt>
+      
+      Orders \em points along the Morton (Z-order) space-filling curve. The coordinates are quantized on the bounding box of \em points and their bits are interleaved to obtain the position of each point on the curve. On return, <tt>permutation[i]</tt> is the new index of <tt>points[i]</tt>. Points which are close in space will be close in the new order, which increases the cache locality of algorithms which access the points of a neighbourhood.
+  */
+  template <std::size_t N>
+  void morton_ordering(const std::vector< ublas::fixed_vector<float_t, N> > & points, std::vector<std::size_t> & permutation)
+  {
+    const std::size_t n_bits = std::min(std::size_t(32), std::size_t(64 / N));
+    const float_t n_cells = float_t(boost::uint64_t(1) << n_bits);
+    
+    permutation.resize(points.size());
+    
+    if(points.size() == 0)
+      return;
+    
+    ublas::fixed_vector<float_t, N> lower_bound(points[0]);
+    ublas::fixed_vector<float_t, N> upper_bound(points[0]);
+    
+    for(std::size_t i = 0; i < points.size(); ++i)
+      for(std::size_t d = 0; d < N; ++d)
+      {
+        lower_bound(d) = std::min(lower_bound(d), points[i](d));
+        upper_bound(d) = std::max(upper_bound(d), points[i](d));
+      }
+    
+    std::vector<node_ordering_impl::MortonKey> keys(points.size());
+    
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+      boost::uint64_t cells[N];
+      
+      for(std::size_t d = 0; d < N; ++d)
+      {
+        float_t extent = upper_bound(d) - lower_bound(d);
+        float_t cell = extent > 0.0 ? (points[i](d) - lower_bound(d)) / extent * n_cells : 0.0;
+        cells[d] = std::min(boost::uint64_t(cell), (boost::uint64_t(1) << n_bits) - 1);
+      }
+      
+      boost::uint64_t key = 0;
+      
+      for(std::size_t b = n_bits; b > 0; --b)
+        for(std::size_t d = 0; d < N; ++d)
+          key = (key << 1) | ((cells[d] >> (b - 1)) & 1);
+      
+      keys[i]._key = key;
+      keys[i]._index = i;
+    }
+    
+    std::sort(keys.begin(), keys.end());
+    
+    for(std::size_t i = 0; i < keys.size(); ++i)
+      permutation[keys[i]._index] = i;
+  }
+}
+
+
+#endif
@@ -0,0 +1,108 @@
+#include <image/BsplineInterpolationAdaptor.hpp>
+
+
+namespace imaging
+{
+  namespace bspline_interpolation_adaptor_impl
+  {
+    void prefilter_lines(float_t * lines, size_t length, size_t width, size_t stride)
+    {
+      if(width > BLOCK_WIDTH)
+      {
+        for(size_t begin = 0; begin < width; begin += BLOCK_WIDTH)
+          prefilter_lines(lines + begin, length, std::min(BLOCK_WIDTH, width - begin), stride);
+          
+        return;
+      }
+      
+      if(length < 2)
+        return;
+        
+      // the pole of the cubic B-spline filter and the number of terms after which its powers are negligible
+      const float_t z = sqrt(3.0) - 2.0;
+      const float_t gain = (1.0 - z) * (1.0 - 1.0 / z);
+      const size_t horizon = size_t(ceil(log(1e-15) / log(fabs(z))));
+      
+      float_t sum[BLOCK_WIDTH];
+      
+      for(size_t n = 0; n < length; ++n)
+      {
+        float_t * line = lines + n * stride;
+        
+        for(size_t j = 0; j < width; ++j)
+          line[j] *= gain;
+      }
+      
+      // initial value of the causal pass for the line mirrored at its first sample
+      if(horizon < length)
+      {
+        float_t z_k = 1.0;
+        std::fill(sum, sum + width, 0.0);
+        
+        for(size_t k = 0; k < horizon; ++k)
+        {
+          const float_t * line = lines + k * stride;
+          
+          for(size_t j = 0; j < width; ++j)
+            sum[j] += z_k * line[j];
+            
+          z_k *= z;
+        }
+      }
+      else
+      {
+        // the mirrored line is periodic with period 2 * length - 2, sum over one period exactly
+        const float_t z_n = pow(z, float_t(length - 1));
+        float_t z_k = z;
+        float_t z_2n_k = z_n * z_n / z;
+        
+        for(size_t j = 0; j < width; ++j)
+          sum[j] = lines[j] + z_n * lines[(length - 1) * stride + j];
+          
+        for(size_t k = 1; k < length - 1; ++k)
+        {
+          const float_t * line = lines + k * stride;
+          
+          for(size_t j = 0; j < width; ++j)
+            sum[j] += (z_k + z_2n_k) * line[j];
+            
+          z_k *= z;
+          z_2n_k /= z;
+        }
+        
+        for(size_t j = 0; j < width; ++j)
+          sum[j] /= 1.0 - z_n * z_n;
+      }
+      
+      for(size_t j = 0; j < width; ++j)
+        lines[j] = sum[j];
+        
+      // causal pass
+      for(size_t n = 1; n < length; ++n)
+      {
+        float_t * line = lines + n * stride;
+        const float_t * previous = line - stride;
+        
+        for(size_t j = 0; j < width; ++j)
+          line[j] += z * previous[j];
+      }
+      
+      // initial value of the anti-causal pass for the line mirrored at its last sample
+      float_t * last = lines + (length - 1) * stride;
+      const float_t * before_last = last - stride;
+      
+      for(size_t j = 0; j < width; ++j)
+        last[j] = z / (z * z - 1.0) * (last[j] + z * before_last[j]);
+        
+      // anti-causal pass
+      for(size_t n = length - 1; n > 0; --n)
+      {
+        float_t * line = lines + (n - 1) * stride;
+        const float_t * next = line + stride;
+        
+        for(size_t j = 0; j < width; ++j)
+          line[j] = z * (next[j] - line[j]);
+      }
+    }
+  }
+}
@@ -0,0 +1,418 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef IMAGE_BSPLINEINTERPOLATIONADAPTOR_H
+#define IMAGE_BSPLINEINTERPOLATIONADAPTOR_H
+
+#include <image/InterpolationAdaptorInterface.hpp>
+#include <image/Image.hpp>
+
+#include <vector>
+#include <algorithm>
+
+
+namespace imaging
+{
+  /** \cond */
+  namespace bspline_interpolation_adaptor_impl
+  {
+    const size_t BLOCK_WIDTH = 32;
+    
+    // computes the cubic B-spline coefficients of width lines of length samples, the n-th sample of the j-th line is stored at lines[n * stride + j]
+    void prefilter_lines(float_t * lines, size_t length, size_t width, size_t stride);
+    
+    // computes the cubic B-spline coefficients of all lines of image parallel to axis (cf. RecursiveGaussianFilter::apply())
+    template <size_t N>
+    void prefilter(Image<N, float_t> & image, size_t axis, size_t n_threads)
+    {
+      const size_t length = image.size()(axis);
+      
+      if(image.n_pixels() == 0 || length < 2)
+        return;
+        
+      size_t inner = 1;
+      for(size_t i = axis + 1; i < N; ++i)
+        inner *= image.size()(i);
+        
+      const size_t outer = image.n_pixels() / (length * inner);
+      float_t * data = image.data();
+      
+      if(inner > 1)
+      {
+        const size_t n_inner_blocks = (inner + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+        const long n_blocks = long(outer * n_inner_blocks);
+        
+        #pragma omp parallel for num_threads(n_threads) schedule(static)
+        for(long block = 0; block < n_blocks; ++block)
+        {
+          size_t o = size_t(block) / n_inner_blocks;
+          size_t begin = (size_t(block) % n_inner_blocks) * BLOCK_WIDTH;
+          size_t width = std::min(BLOCK_WIDTH, inner - begin);
+          
+          prefilter_lines(data + o * length * inner + begin, length, width, inner);
+        }
+      }
+      else
+      {
+        const long n_blocks = long((outer + BLOCK_WIDTH - 1) / BLOCK_WIDTH);
+        
+        #pragma omp parallel num_threads(n_threads)
+        {
+          std::vector<float_t> buffer(length * BLOCK_WIDTH);
+          
+          #pragma omp for schedule(static)
+          for(long block = 0; block < n_blocks; ++block)
+          {
+            size_t begin = size_t(block) * BLOCK_WIDTH;
+            size_t width = std::min(BLOCK_WIDTH, outer - begin);
+            float_t * lines = data + begin * length;
+            
+            for(size_t j = 0; j < width; ++j)
+              for(size_t n = 0; n < length; ++n)
+                buffer[n * BLOCK_WIDTH + j] = lines[j * length + n];
+                
+            prefilter_lines(&buffer[0], length, width, BLOCK_WIDTH);
+            
+            for(size_t j = 0; j < width; ++j)
+              for(size_t n = 0; n < length; ++n)
+                lines[j * length + n] = buffer[n * BLOCK_WIDTH + j];
+          }
+        }
+      }
+    }
+    
+    // index of the coefficient k in a line of length samples which is mirrored at its first and its last sample
+    inline long mirror_index(long k, long length)
+    {
+      if(length == 1)
+        return 0;
+        
+      const long period = 2 * length - 2;
+      
+      k = k < 0 ? -k : k;
+      k %= period;
+      
+      return k < length ? k : period - k;
+    }
+    
+    // the 4^N coefficients and the 1-dimensional weights of the cubic B-spline around a position
+    template <size_t N>
+    class spline_cell
+    {
+    public:
+      static const size_t N_SUPPORT = size_t(1) << (2 * N);
+      
+    private:
+      float_t _coefficients[N_SUPPORT];
+      // _weights[d][i][m] is the d-th derivative of the weight of the m-th coefficient along the axis i
+      float_t _weights[3][N][4];
+      
+    public:
+      // gathers the coefficients for position, returns false if position is outside of the image
+      template <class coordinate_t>
+      bool set(const coordinate_t * position, const size_t * size, const size_t * strides, const float_t * data)
+      {
+        size_t offsets[N][4];
+        bool interior = true;
+        long first[N];
+        
+        for(size_t i = 0; i < N; ++i)
+        {
+          const float_t p = float_t(position[i]);
+          
+          if(p < 0.0 || p >= float_t(size[i]))
+            return false;
+            
+          // pixel centres are at integer coordinates plus 0.5
+          const float_t x = p - 0.5;
+          const float_t floor_x = floor(x);
+          const float_t t = x - floor_x;
+          const float_t s = 1.0 - t;
+          
+          _weights[0][i][0] = s * s * s / 6.0;
+          _weights[0][i][1] = (4.0 - 6.0 * t * t + 3.0 * t * t * t) / 6.0;
+          _weights[0][i][2] = (1.0 + 3.0 * t + 3.0 * t * t - 3.0 * t * t * t) / 6.0;
+          _weights[0][i][3] = t * t * t / 6.0;
+          
+          _weights[1][i][0] = -0.5 * s * s;
+          _weights[1][i][1] = (1.5 * t - 2.0) * t;
+          _weights[1][i][2] = 0.5 + t - 1.5 * t * t;
+          _weights[1][i][3] = 0.5 * t * t;
+          
+          _weights[2][i][0] = s;
+          _weights[2][i][1] = 3.0 * t - 2.0;
+          _weights[2][i][2] = 1.0 - 3.0 * t;
+          _weights[2][i][3] = t;
+          
+          first[i] = long(floor_x) - 1;
+          
+          if(first[i] < 0 || first[i] + 3 >= long(size[i]))
+            interior = false;
+        }
+        
+        for(size_t i = 0; i < N; ++i)
+          for(size_t m = 0; m < 4; ++m)
+          {
+            long k = first[i] + long(m);
+            
+            if(! interior)
+              k = mirror_index(k, long(size[i]));
+              
+            offsets[i][m] = size_t(k) * strides[i];
+          }
+          
+        // the coefficient of the multi-index (m_0, ..., m_{N-1}) is stored at position m_0 * 4^{N-1} + ... + m_{N-1}
+        size_t cell_offsets[N_SUPPORT];
+        size_t n = 1;
+        cell_offsets[0] = 0;
+        
+        for(size_t i = 0; i < N; ++i)
+        {
+          for(size_t c = n; c > 0; --c)
+            for(size_t m = 4; m > 0; --m)
+              cell_offsets[4 * (c - 1) + m - 1] = cell_offsets[c - 1] + offsets[i][m - 1];
+              
+          n *= 4;
+        }
+        
+        for(size_t c = 0; c < N_SUPPORT; ++c)
+          _coefficients[c] = data[cell_offsets[c]];
+        
+        return true;
+      }
+      
+      // evaluates the derivative of the spline of order orders[i] along the axis i
+      float_t evaluate(const size_t * orders) const
+      {
+        float_t values[N_SUPPORT];
+        const float_t * source = _coefficients;
+        size_t n = N_SUPPORT;
+        
+        // collapse the cell along the last axis first, because its coefficients are neighbours
+        for(size_t i = N; i > 0; --i)
+        {
+          const float_t * w = _weights[orders[i - 1]][i - 1];
+          n /= 4;
+          
+          for(size_t c = 0; c < n; ++c)
+            values[c] = w[0] * source[4 * c] + w[1] * source[4 * c + 1] + w[2] * source[4 * c + 2] + w[3] * source[4 * c + 3];
+            
+          source = values;
+        }
+        
+        return values[0];
+      }
+      
+      float_t value() const
+      {
+        size_t orders[N];
+        std::fill(orders, orders + N, 0);
+        
+        return evaluate(orders);
+      }
+      
+      template <class result_t>
+      void gradient(result_t * gradient) const
+      {
+        size_t orders[N];
+        
+        for(size_t j = 0; j < N; ++j)
+        {
+          std::fill(orders, orders + N, 0);
+          orders[j] = 1;
+          gradient[j] = result_t(evaluate(orders));
+        }
+      }
+      
+      template <class result_t>
+      void hessian(result_t * hessian) const
+      {
+        size_t orders[N];
+        
+        for(size_t j = 0; j < N; ++j)
+          for(size_t k = j; k < N; ++k)
+          {
+            std::fill(orders, orders + N, 0);
+            ++orders[j];
+            ++orders[k];
+            hessian[j * N + k] = hessian[k * N + j] = result_t(evaluate(orders));
+          }
+      }
+    };
+  }
+  /** \endcond */
+  
+  
+  /** \ingroup image
+      \brief Cubic B-spline interpolation of image values at floating point coordinates.
+      
+      This class provides a pixel accessor [] for real valued pixel coordinates via cubic B-spline interpolation. In contrast to PolynomialInterpolationAdaptor the interpolating function is twice continuously differentiable, i.e. its gradient() is continuous and its hessian() exists everywhere. Energies which sample images at shape dependent positions become smooth functions of the shape parameters if they are computed by this class, and minimizers which rely on gradients such as Lbfgs converge in fewer steps.
+      
+      Upon construction the image is copied and converted to the coefficients of the interpolating spline by a recursive causal and anti-causal filter along each axis (Unser, Aldroubi and Eden). The image is extended beyond its boundary by mirroring it at its first and last pixels. The filter is applied in parallel if \em n_threads is greater than 1. Each evaluation reads 4^N coefficients, where \em N is the dimension of the image. The adaptor does not observe the image after its construction. Call update() if the image changes.
+      
+      As for PolynomialInterpolationAdaptor, the centre of the pixel \em i is located at \em i + 0.5 and positions outside of the image are interpolated as 0. All evaluations are const and can be performed by several threads at the same time. interpolate(), interpolate_gradients() and interpolate_hessians() evaluate arrays of positions at once. The type \em image_t::data_t must be convertible to \em float_t.
+      
+  \code
+  img::Image<2, img::float_t> image("image.pgm");
+  img::BsplineInterpolationAdaptor< img::Image<2, img::float_t> > interpolator(image);
+  
+  img::ublas::fixed_vector<img::float_t, 2> position(10.3, 20.7);
+  img::ublas::fixed_vector<img::float_t, 2> gradient;
+  img::ublas::fixed_matrix<img::float_t, 2, 2> hessian;
+  
+  img::float_t value = interpolator[position];
+  interpolator.gradient(position, gradient);
+  interpolator.hessian(position, hessian);
+  \endcode
+  */
+  template <class image_t>
+  class BsplineInterpolationAdaptor : public InterpolationAdaptorInterface<image_t>
+  {
+    static const size_t N = image_t::dimension;
+    
+    typedef bspline_interpolation_adaptor_impl::spline_cell<N> cell_t;
+    
+    Image<N, float_t> _coefficients;
+    size_t _size[N];
+    size_t _strides[N];
+    size_t _n_threads;
+    
+    bool set_cell(const float_t * position, cell_t & cell) const
+    {
+      return cell.set(position, _size, _strides, _coefficients.data());
+    }
+    
+  public:
+    /** The data type which is returned by the interpolation adaptor. */
+    typedef typename InterpolationAdaptorInterface<image_t>::data_t data_t;
+    
+    /** Constructs a BsplineInterpolationAdaptor object from \em image_reference and computes the spline coefficients using \em n_threads threads. The class \em image_t must implement ImageInterface. */
+    explicit BsplineInterpolationAdaptor(const image_t & image_reference, size_t n_threads = 1) :
+      InterpolationAdaptorInterface<image_t>(image_reference), _n_threads(n_threads > 0 ? n_threads : 1)
+    {
+      update();
+    }
+    
+    /** Returns the number of threads which are used to compute the spline coefficients. */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads which are used to compute the spline coefficients. If the library was compiled without OpenMP support, \em n_threads is ignored. */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    /** Recomputes the spline coefficients from the image. Call this function if the image has been modified after the construction of the adaptor. */
+    void update()
+    {
+      _coefficients = InterpolationAdaptorInterface<image_t>::_image_reference;
+      
+      for(size_t i = 0; i < N; ++i)
+      {
+        _size[i] = _coefficients.size()(i);
+        _strides[i] = _coefficients.strides()[i];
+        bspline_interpolation_adaptor_impl::prefilter(_coefficients, i, _n_threads);
+      }
+    }
+    
+    /** Returns the coefficients of the spline. The spline is the sum of the coefficients times the tensor product B-splines centred at the pixels. */
+    const Image<N, float_t> & coefficients() const { return _coefficients; }
+    
+    /** Returns the interpolation at the position \em index. */
+    data_t operator[](const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index) const
+    {
+      cell_t cell;
+      
+      if(! set_cell(&index(0), cell))
+        return data_t(0);
+        
+      return data_t(cell.value());
+    }
+    
+    /** Computes the gradient of the interpolation at the position \em index and stores it in \em value. */
+    void gradient(const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index, ublas::fixed_vector<data_t, InterpolationAdaptorInterface<image_t>::dimension> & value) const
+    {
+      cell_t cell;
+      
+      if(! set_cell(&index(0), cell))
+      {
+        value = ublas::fixed_vector<data_t, N>(data_t(0));
+        return;
+      }
+      
+      cell.gradient(&value(0));
+    }
+    
+    /** Computes the Hessian matrix of the interpolation at the position \em index and stores it in \em value. */
+    void hessian(const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index, ublas::fixed_matrix<data_t, InterpolationAdaptorInterface<image_t>::dimension, InterpolationAdaptorInterface<image_t>::dimension> & value) const
+    {
+      cell_t cell;
+      data_t hessian[N * N];
+      
+      if(set_cell(&index(0), cell))
+        cell.hessian(hessian);
+      else
+        std::fill(hessian, hessian + N * N, data_t(0));
+        
+      for(size_t j = 0; j < N; ++j)
+        for(size_t k = 0; k < N; ++k)
+          value(j, k) = hessian[j * N + k];
+    }
+    
+    /** Interpolates the image at \em n_points positions and stores the results in \em values. The coordinates of the <em>i</em>-th position are stored at <tt>positions[i * N]</tt> to <tt>positions[i * N + N - 1]</tt>, where \em N is the dimension of the image. The results equal those of operator[](). */
+    template <class coordinate_t, class result_t>
+    void interpolate(const coordinate_t * positions, size_t n_points, result_t * values) const
+    {
+      cell_t cell;
+      
+      for(size_t p = 0; p < n_points; ++p)
+        values[p] = cell.set(positions + p * N, _size, _strides, _coefficients.data()) ? result_t(cell.value()) : result_t(0);
+    }
+    
+    /** Computes the gradients of the interpolation at \em n_points positions (cf. interpolate()). The gradient at the <em>i</em>-th position is stored at <tt>gradients[i * N]</tt> to <tt>gradients[i * N + N - 1]</tt>. */
+    template <class coordinate_t, class result_t>
+    void interpolate_gradients(const coordinate_t * positions, size_t n_points, result_t * gradients) const
+    {
+      cell_t cell;
+      
+      for(size_t p = 0; p < n_points; ++p)
+      {
+        if(cell.set(positions + p * N, _size, _strides, _coefficients.data()))
+          cell.gradient(gradients + p * N);
+        else
+          std::fill(gradients + p * N, gradients + (p + 1) * N, result_t(0));
+      }
+    }
+    
+    /** Computes the Hessian matrices of the interpolation at \em n_points positions (cf. interpolate()). The entry (\em j, \em k) of the Hessian at the <em>i</em>-th position is stored at <tt>hessians[(i * N + j) * N + k]</tt>. */
+    template <class coordinate_t, class result_t>
+    void interpolate_hessians(const coordinate_t * positions, size_t n_points, result_t * hessians) const
+    {
+      cell_t cell;
+      
+      for(size_t p = 0; p < n_points; ++p)
+      {
+        if(cell.set(positions + p * N, _size, _strides, _coefficients.data()))
+          cell.hessian(hessians + p * N * N);
+        else
+          std::fill(hessians + p * N * N, hessians + (p + 1) * N * N, result_t(0));
+      }
+    }
+  };
+}
+
+#endif
@@ -20,6 +20,12 @@ namespace imaging
   template<>
   void ColorImage2d::read_image(const std::string & file_name)
   {
+    if(ImageFileReader::is_supported(file_name))
+    {
+      image_file_impl::read_image(file_name, *this);
+      return;
+    }
+    
     Magick::Image magick_image;
     
     try
@@ -45,6 +51,12 @@ namespace imaging
   template<>
   void ColorImage2d::write_image(const std::string & file_name) const
   {
+    if(ImageFileReader::is_supported(file_name))
+    {
+      image_file_impl::write_image(file_name, *this);
+      return;
+    }
+    
     ColorImage2d rotated_image(ublas::fixed_vector<size_t, 2>(this->size()(1), this->size()(0)));
     
     for(size_t i = 0; i < rotated_image.size()(0); ++i)
@@ -81,6 +81,38 @@ namespace imaging
     operator float_t() const { return float_t(GrayValue(*this)); }
   };
   
+  /** \cond */
+  namespace image_file_impl
+  {
+    template <>
+    class pixel_traits<Color>
+    {
+    public:
+      static const size_t n_channels = 3;
+      
+      static ImageFileReader::sample_types sample_type() { return ImageFileReader::UINT8_SAMPLE; }
+      
+      static void read(const float_t * samples, size_t n_samples, float_t max_value, Color & pixel)
+      {
+        for(size_t i = 0; i < 3; ++i)
+        {
+          float_t value = floor(samples[n_samples == 3 ? i : 0] / max_value * 255.0 + 0.5);
+          pixel(i) = GrayValue((unsigned char)(value < 0.0 ? 0.0 : (value > 255.0 ? 255.0 : value)));
+        }
+      }
+      
+      static void write(const Color & pixel, size_t n_samples, float_t max_value, float_t * samples)
+      {
+        if(n_samples == 3)
+          for(size_t i = 0; i < 3; ++i)
+            samples[i] = float_t((unsigned char)(pixel(i))) / 255.0 * max_value;
+        else
+          samples[0] = float_t((unsigned char)(GrayValue(pixel))) / 255.0 * max_value;
+      }
+    };
+  }
+  /** \endcond */
+  
   /** \ingroup image
       \brief 2-dimensional color image.
       
@@ -92,9 +124,11 @@ namespace imaging
   */
   typedef Image<2, Color> ColorImage2d;
   
+  /** Reads the image from the file \em file_name. Formats which are supported by ImageFileReader are decoded natively, all other formats are read by ImageMagick. */
   template<>
   void ColorImage2d::read_image(const std::string & file_name);
   
+  /** Writes the image to the file \em file_name. Formats which are supported by ImageFileWriter are encoded natively, all other formats are written by ImageMagick. */
   template<>
   void ColorImage2d::write_image(const std::string & file_name) const;
   
@@ -0,0 +1,81 @@
+#include <image/Convolution.hpp>
+
+
+namespace imaging
+{
+  namespace convolution_impl
+  {
+    size_t fft_size(size_t n)
+    {
+      size_t size = 1;
+      
+      while(size < n)
+        size *= 2;
+        
+      return size;
+    }
+    
+    fft_plan::fft_plan(size_t size) :
+      _size(size), _cosines(size / 2), _sines(size / 2), _reversed(size)
+    {
+      if(size == 0 || fft_size(size) != size)
+        throw Exception("Exception: FFT size must be a power of 2 in fft_plan::fft_plan().");
+        
+      // PI in core/utilities.hpp is not accurate enough for large transforms
+      const float_t pi = 4.0 * atan(1.0);
+      
+      for(size_t k = 0; k < size / 2; ++k)
+      {
+        _cosines[k] = cos(2.0 * pi * float_t(k) / float_t(size));
+        _sines[k] = -sin(2.0 * pi * float_t(k) / float_t(size));
+      }
+      
+      size_t n_bits = 0;
+      while((size_t(1) << n_bits) < size)
+        ++n_bits;
+        
+      for(size_t i = 0; i < size; ++i)
+      {
+        size_t reversed = 0;
+        
+        for(size_t b = 0; b < n_bits; ++b)
+          if(i & (size_t(1) << b))
+            reversed |= size_t(1) << (n_bits - 1 - b);
+            
+        _reversed[i] = reversed;
+      }
+    }
+    
+    void fft_plan::transform(std::complex<float_t> * data, bool inverse) const
+    {
+      for(size_t i = 0; i < _size; ++i)
+        if(i < _reversed[i])
+          std::swap(data[i], data[_reversed[i]]);
+          
+      const float_t sign = inverse ? -1.0 : 1.0;
+      float_t * values = reinterpret_cast<float_t *>(data);
+      
+      for(size_t length = 2; length <= _size; length *= 2)
+      {
+        const size_t half = length / 2;
+        const size_t step = _size / length;
+        
+        for(size_t begin = 0; begin < _size; begin += length)
+          for(size_t k = 0; k < half; ++k)
+          {
+            const float_t w_re = _cosines[k * step];
+            const float_t w_im = sign * _sines[k * step];
+            float_t * u = values + 2 * (begin + k);
+            float_t * v = values + 2 * (begin + k + half);
+            const float_t t_re = v[0] * w_re - v[1] * w_im;
+            const float_t t_im = v[0] * w_im + v[1] * w_re;
+            
+            v[0] = u[0] - t_re;
+            v[1] = u[1] - t_im;
+            u[0] += t_re;
+            u[1] += t_im;
+          }
+      }
+    }
+  }
+}
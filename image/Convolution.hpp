@@ -0,0 +1,658 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGE_CONVOLUTION_H
+#define IMAGE_CONVOLUTION_H
+
+#include <image/Image.hpp>
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+
+namespace imaging
+{
+  /** \cond */
+  namespace convolution_impl
+  {
+    // radix-2 fast Fourier transform of a fixed length
+    class fft_plan
+    {
+      size_t _size;
+      std::vector<float_t> _cosines;
+      std::vector<float_t> _sines;
+      std::vector<size_t> _reversed;
+      
+    public:
+      explicit fft_plan(size_t size);
+      
+      size_t size() const { return _size; }
+      
+      // in place transform of size() values, the inverse transform is not scaled
+      void transform(std::complex<float_t> * data, bool inverse) const;
+    };
+    
+    // smallest power of 2 which is not smaller than n
+    size_t fft_size(size_t n);
+    
+    // run time of the FFT convolution per pixel and binary digit of the padded size relative to a multiply-add
+    const float_t FFT_COST_FACTOR = 25.0;
+    
+    template <size_t N>
+    size_t n_elements(const ublas::fixed_vector<size_t, N> & size)
+    {
+      size_t result = 1;
+      for(size_t i = 0; i < N; ++i)
+        result *= size(i);
+      return result;
+    }
+    
+    // decodes the index of a line parallel to the last axis into its coordinates in the first N - 1 axes
+    template <size_t N>
+    void line_coordinates(size_t line, const ublas::fixed_vector<size_t, N> & size, size_t * coordinates)
+    {
+      for(size_t i = N - 1; i > 0; --i)
+      {
+        coordinates[i - 1] = line % size(i - 1);
+        line /= size(i - 1);
+      }
+    }
+    
+    // offset of the first pixel of a line in an array of the given size stored in C order
+    template <size_t N>
+    size_t line_offset(const size_t * coordinates, const ublas::fixed_vector<size_t, N> & size)
+    {
+      size_t offset = 0;
+      for(size_t i = 0; i + 1 < N; ++i)
+        offset = offset * size(i) + coordinates[i];
+      return offset * size(N - 1);
+    }
+  }
+  /** \endcond */
+  
+  /** \ingroup image
+      \brief Convolution of images with arbitrary kernels.
+      
+      This class convolves images of the type <em>Image<N, float_t></em> with the kernel passed to the constructor, i.e. it computes
+      \f[
+        g(x) = \sum_k h(k) f(x + c - k)\,,
+      \f]
+      where \f$h\f$ denotes the kernel and \f$c\f$ the center of the kernel, which is the pixel <tt>kernel.size() / 2</tt> (componentwise integer division). Pixels outside the image are either 0 (ZERO_BOUNDARY, the convention of BoundaryDiscretizer and the segmentation energies, which ignore points outside the image) or take the value of the nearest boundary pixel (REPLICATE_BOUNDARY).
+      
+      Three implementations are available:
+        - DIRECT: Evaluates the sum above. The innermost loop runs over the contiguous last axis of the image and is vectorized by the compiler. The cost is proportional to the number of kernel entries.
+        - SEPARABLE: If the kernel is the outer product of 1-dimensional kernels (e.g. Gaussians or box filters) the image is convolved with each of them in turn. The cost is proportional to the sum of the kernel extents. The factors are computed upon construction by the higher-order power method (for 2-dimensional kernels this is the dominant singular value decomposition) and the kernel is considered separable if the factorization reproduces it up to round-off.
+        - FFT: Multiplies the Fourier transforms of the image and the kernel. The cost is proportional to <em>M</em> log <em>M</em>, where \em M is the number of pixels of the image padded by the kernel size and rounded up to powers of 2 along each axis. It does not depend on the number of kernel entries otherwise.
+      
+      By default apply() estimates the cost of each implementation and uses the cheapest one (cf. method()). The following table lists run times (in ms, single thread) which have been measured for a 512 x 512 image and a 64 x 64 x 64 volume with square and cubic kernels of the given width. Separable times are for Gaussian kernels, the other times for random kernels (-: not measured):
+      
+      <table>
+      <tr><th>width</th><th>2D direct</th><th>2D separable</th><th>2D FFT</th><th>3D direct</th><th>3D separable</th><th>3D FFT</th></tr>
+      <tr><td>3</td><td>4</td><td>4</td><td>149</td><td>6</td><td>4</td><td>379</td></tr>
+      <tr><td>5</td><td>4</td><td>4</td><td>163</td><td>28</td><td>7</td><td>378</td></tr>
+      <tr><td>9</td><td>15</td><td>4</td><td>144</td><td>103</td><td>10</td><td>349</td></tr>
+      <tr><td>17</td><td>42</td><td>7</td><td>152</td><td>745</td><td>20</td><td>447</td></tr>
+      <tr><td>33</td><td>231</td><td>22</td><td>186</td><td>-</td><td>50</td><td>440</td></tr>
+      <tr><td>65</td><td>775</td><td>31</td><td>175</td><td>-</td><td>120</td><td>403</td></tr>
+      </table>
+      
+      For non-separable kernels FFT convolution takes over from direct convolution at a width of about 30 for 2-dimensional and about 13 for 3-dimensional kernels. The cost of FFT convolution barely depends on the kernel width because the padded image is rounded up to the next power of 2. Separable kernels are convolved fastest by SEPARABLE in the whole measured range. method() chooses the fastest implementation in all cases of the table.
+  */
+  template <size_t N>
+  class Convolution
+  {
+  public:
+    /** The values of the image outside its domain. */
+    enum boundary_modes { ZERO_BOUNDARY, REPLICATE_BOUNDARY };
+    
+    /** The implementations of the convolution. */
+    enum methods { AUTOMATIC, DIRECT, SEPARABLE, FFT };
+    
+  private:
+    Image<N, float_t> _kernel;
+    boundary_modes _boundary_mode;
+    size_t _n_threads;
+    bool _is_separable;
+    std::vector< std::vector<float_t> > _factors;
+    
+    void factorize();
+    void pad(const Image<N, float_t> & image, Image<N, float_t> & padded) const;
+    void convolve_direct(const Image<N, float_t> & padded, Image<N, float_t> & out) const;
+    void convolve_separable(const Image<N, float_t> & padded, Image<N, float_t> & out) const;
+    void convolve_fft(const Image<N, float_t> & padded, Image<N, float_t> & out) const;
+    void transform(std::vector< std::complex<float_t> > & data, const ublas::fixed_vector<size_t, N> & size, bool inverse) const;
+    
+  public:
+    /** Constructs a convolution with \em kernel. Throws an Exception if \em kernel is empty. */
+    explicit Convolution(const Image<N, float_t> & kernel, boundary_modes boundary_mode = ZERO_BOUNDARY, size_t n_threads = 1);
+    
+    /** Returns the kernel of the convolution. */
+    const Image<N, float_t> & kernel() const { return _kernel; }
+    
+    /** Returns the boundary mode. */
+    boundary_modes boundary_mode() const { return _boundary_mode; }
+    
+    /** Returns true if the kernel is the outer product of 1-dimensional kernels. */
+    bool is_separable() const { return _is_separable; }
+    
+    /** Returns the 1-dimensional factor of the kernel along the axis \em axis. The kernel is the outer product of the factors along all axes. Throws an Exception if the kernel is not separable. */
+    const std::vector<float_t> & factor(size_t axis) const;
+    
+    /** Returns the number of threads which are used to convolve an image. */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads which are used to convolve an image. If the library was compiled without OpenMP support, \em n_threads is ignored. */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    /** Returns the implementation which apply() uses by default for an image of size \em image_size. */
+    methods method(const ublas::fixed_vector<size_t, N> & image_size) const;
+    
+    /** Convolves \em image with the kernel and stores the result in \em out, which is resized to the size of \em image. \em image and \em out may be the same object. If \em method is AUTOMATIC the implementation is chosen by method(). Throws an Exception if \em method is SEPARABLE and the kernel is not separable. */
+    void apply(const Image<N, float_t> & image, Image<N, float_t> & out, methods method = AUTOMATIC) const;
+  };
+  
+  template <size_t N>
+  Convolution<N>::Convolution(const Image<N, float_t> & kernel, boundary_modes boundary_mode, size_t n_threads) :
+    _kernel(kernel), _boundary_mode(boundary_mode), _n_threads(n_threads > 0 ? n_threads : 1), _is_separable(false)
+  {
+    if(kernel.empty())
+      throw Exception("Exception: Empty kernel in Convolution::Convolution().");
+      
+    factorize();
+  }
+  
+  template <size_t N>
+  const std::vector<float_t> & Convolution<N>::factor(size_t axis) const
+  {
+    if(! _is_separable)
+      throw Exception("Exception: Kernel is not separable in Convolution::factor().");
+      
+    if(axis >= N)
+      throw Exception("Exception: Invalid axis in Convolution::factor().");
+      
+    return _factors[axis];
+  }
+  
+  template <size_t N>
+  void Convolution<N>::factorize()
+  {
+    const size_t n_entries = _kernel.n_pixels();
+    const float_t * kernel = _kernel.data();
+    ublas::fixed_vector<size_t, N> strides;
+    
+    strides(N - 1) = 1;
+    for(size_t i = N - 1; i > 0; --i)
+      strides(i - 1) = strides(i) * _kernel.size()(i);
+    
+    float_t squared_norm = 0.0;
+    size_t max_entry = 0;
+    
+    for(size_t i = 0; i < n_entries; ++i)
+    {
+      squared_norm += kernel[i] * kernel[i];
+      if(fabs(kernel[i]) > fabs(kernel[max_entry]))
+        max_entry = i;
+    }
+    
+    _factors.resize(N);
+    
+    // initialize the factors with the lines through the largest entry
+    for(size_t a = 0; a < N; ++a)
+    {
+      size_t max_coordinate = (max_entry / strides(a)) % _kernel.size()(a);
+      
+      _factors[a].resize(_kernel.size()(a));
+      
+      for(size_t i = 0; i < _kernel.size()(a); ++i)
+        _factors[a][i] = squared_norm == 0.0 ? 0.0 : kernel[max_entry + i * strides(a) - max_coordinate * strides(a)];
+    }
+    
+    if(squared_norm == 0.0)
+    {
+      _is_separable = true;
+      return;
+    }
+    
+    // higher-order power method: each factor is the contraction of the kernel with all other factors
+    float_t scale = 0.0;
+    std::vector<float_t> contraction;
+    
+    for(size_t iteration = 0; iteration < 100; ++iteration)
+    {
+      float_t old_scale = scale;
+      
+      for(size_t a = 0; a < N; ++a)
+      {
+        contraction.assign(_kernel.size()(a), 0.0);
+        
+        for(size_t i = 0; i < n_entries; ++i)
+        {
+          float_t product = kernel[i];
+          
+          for(size_t b = 0; b < N; ++b)
+            if(b != a)
+              product *= _factors[b][(i / strides(b)) % _kernel.size()(b)];
+              
+          contraction[(i / strides(a)) % _kernel.size()(a)] += product;
+        }
+        
+        scale = 0.0;
+        for(size_t i = 0; i < contraction.size(); ++i)
+          scale += contraction[i] * contraction[i];
+        scale = sqrt(scale);
+        
+        if(scale == 0.0)
+          return;
+          
+        for(size_t i = 0; i < contraction.size(); ++i)
+          _factors[a][i] = contraction[i] / scale;
+      }
+      
+      if(fabs(scale - old_scale) <= 1e-15 * scale)
+        break;
+    }
+    
+    // the last factor carries the scale
+    for(size_t i = 0; i < _factors[N - 1].size(); ++i)
+      _factors[N - 1][i] *= scale;
+      
+    float_t squared_residual = 0.0;
+    
+    for(size_t i = 0; i < n_entries; ++i)
+    {
+      float_t product = 1.0;
+      
+      for(size_t b = 0; b < N; ++b)
+        product *= _factors[b][(i / strides(b)) % _kernel.size()(b)];
+        
+      squared_residual += (kernel[i] - product) * (kernel[i] - product);
+    }
+    
+    _is_separable = squared_residual <= 1e-20 * squared_norm;
+  }
+  
+  template <size_t N>
+  typename Convolution<N>::methods Convolution<N>::method(const ublas::fixed_vector<size_t, N> & image_size) const
+  {
+    // estimated number of floating point operations of each implementation
+    float_t n_pixels = float_t(convolution_impl::n_elements(image_size));
+    float_t n_padded_pixels = 1.0;
+    float_t n_fft_pixels = 1.0;
+    float_t sum_of_widths = 0.0;
+    
+    for(size_t i = 0; i < N; ++i)
+    {
+      n_padded_pixels *= float_t(image_size(i) + _kernel.size()(i) - 1);
+      n_fft_pixels *= float_t(convolution_impl::fft_size(image_size(i) + _kernel.size()(i) - 1));
+      sum_of_widths += float_t(_kernel.size()(i));
+    }
+    
+    float_t direct_cost = 2.0 * n_pixels * float_t(_kernel.n_pixels());
+    float_t separable_cost = 2.0 * n_padded_pixels * sum_of_widths;
+    float_t fft_cost = convolution_impl::FFT_COST_FACTOR * n_fft_pixels * (log(n_fft_pixels) / log(2.0) + 1.0);
+    
+    if(_is_separable && separable_cost <= direct_cost && separable_cost <= fft_cost)
+      return SEPARABLE;
+      
+    return fft_cost < direct_cost ? FFT : DIRECT;
+  }
+  
+  template <size_t N>
+  void Convolution<N>::apply(const Image<N, float_t> & image, Image<N, float_t> & out, methods method) const
+  {
+    if(method == AUTOMATIC)
+      method = this->method(image.size());
+      
+    if(method == SEPARABLE && ! _is_separable)
+      throw Exception("Exception: Kernel is not separable in Convolution::apply().");
+      
+    ublas::fixed_vector<size_t, N> padded_size;
+    for(size_t i = 0; i < N; ++i)
+      padded_size(i) = image.size()(i) + _kernel.size()(i) - 1;
+      
+    Image<N, float_t> padded(padded_size);
+    pad(image, padded);
+    
+    out.resize(image.size());
+    
+    if(out.n_pixels() == 0)
+      return;
+    
+    switch(method)
+    {
+    case SEPARABLE:
+      convolve_separable(padded, out);
+      break;
+    case FFT:
+      convolve_fft(padded, out);
+      break;
+    default:
+      convolve_direct(padded, out);
+    }
+  }
+  
+  template <size_t N>
+  void Convolution<N>::pad(const Image<N, float_t> & image, Image<N, float_t> & padded) const
+  {
+    const ublas::fixed_vector<size_t, N> & size = image.size();
+    const ublas::fixed_vector<size_t, N> & padded_size = padded.size();
+    const long n_lines = long(padded.n_pixels() / padded_size(N - 1));
+    const bool is_empty = image.n_pixels() == 0;
+    const float_t * data = image.data();
+    float_t * padded_data = padded.data();
+    
+    // the kernel center is at kernel.size() / 2, the image is shifted by the number of entries below it
+    ublas::fixed_vector<long, N> lower;
+    for(size_t i = 0; i < N; ++i)
+      lower(i) = long(_kernel.size()(i) - 1 - _kernel.size()(i) / 2);
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long line = 0; line < n_lines; ++line)
+    {
+      size_t coordinates[N];
+      bool is_outside = is_empty;
+      
+      convolution_impl::line_coordinates(size_t(line), padded_size, coordinates);
+      
+      for(size_t i = 0; i + 1 < N; ++i)
+      {
+        long c = long(coordinates[i]) - lower(i);
+        
+        if(c < 0 || c >= long(size(i)))
+        {
+          is_outside = true;
+          c = c < 0 ? 0 : long(size(i)) - 1;
+        }
+        
+        coordinates[i] = size_t(c);
+      }
+      
+      float_t * target = padded_data + size_t(line) * padded_size(N - 1);
+      
+      if(is_outside && (_boundary_mode == ZERO_BOUNDARY || is_empty))
+      {
+        std::fill(target, target + padded_size(N - 1), 0.0);
+        continue;
+      }
+      
+      const float_t * source = data + convolution_impl::line_offset(coordinates, size);
+      const long width = long(size(N - 1));
+      
+      for(long x = 0; x < long(padded_size(N - 1)); ++x)
+      {
+        long c = x - lower(N - 1);
+        
+        if(c >= 0 && c < width)
+          target[x] = source[c];
+        else if(_boundary_mode == ZERO_BOUNDARY)
+          target[x] = 0.0;
+        else
+          target[x] = source[c < 0 ? 0 : width - 1];
+      }
+    }
+  }
+  
+  template <size_t N>
+  void Convolution<N>::convolve_direct(const Image<N, float_t> & padded, Image<N, float_t> & out) const
+  {
+    const ublas::fixed_vector<size_t, N> & size = out.size();
+    const ublas::fixed_vector<size_t, N> & kernel_size = _kernel.size();
+    const ublas::fixed_vector<size_t, N> & padded_size = padded.size();
+    const size_t width = size(N - 1);
+    const size_t kernel_width = kernel_size(N - 1);
+    const long n_lines = long(out.n_pixels() / width);
+    const size_t n_kernel_lines = _kernel.n_pixels() / kernel_width;
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long line = 0; line < n_lines; ++line)
+    {
+      size_t coordinates[N], kernel_coordinates[N], padded_coordinates[N];
+      float_t * target = out.data() + size_t(line) * width;
+      
+      convolution_impl::line_coordinates(size_t(line), size, coordinates);
+      std::fill(target, target + width, 0.0);
+      
+      for(size_t kernel_line = 0; kernel_line < n_kernel_lines; ++kernel_line)
+      {
+        convolution_impl::line_coordinates(kernel_line, kernel_size, kernel_coordinates);
+        
+        for(size_t i = 0; i + 1 < N; ++i)
+          padded_coordinates[i] = coordinates[i] + kernel_size(i) - 1 - kernel_coordinates[i];
+          
+        const float_t * source = padded.data() + convolution_impl::line_offset(padded_coordinates, padded_size);
+        const float_t * kernel = _kernel.data() + kernel_line * kernel_width;
+        
+        for(size_t k = 0; k < kernel_width; ++k)
+        {
+          const float_t weight = kernel[k];
+          const float_t * shifted_source = source + kernel_width - 1 - k;
+          
+          if(weight == 0.0)
+            continue;
+          
+          for(size_t x = 0; x < width; ++x)
+            target[x] += weight * shifted_source[x];
+        }
+      }
+    }
+  }
+  
+  template <size_t N>
+  void Convolution<N>::convolve_separable(const Image<N, float_t> & padded, Image<N, float_t> & out) const
+  {
+    // the padded image is convolved along one axis after the other, each pass shrinks this axis to the image size
+    ublas::fixed_vector<size_t, N> size = padded.size();
+    std::vector<float_t> current(padded.data(), padded.data() + padded.n_pixels());
+    std::vector<float_t> next;
+    
+    for(size_t a = 0; a < N; ++a)
+    {
+      const std::vector<float_t> & factor = _factors[a];
+      const size_t kernel_width = factor.size();
+      const size_t length = size(a);
+      const size_t new_length = out.size()(a);
+      size_t inner = 1;
+      
+      for(size_t i = a + 1; i < N; ++i)
+        inner *= size(i);
+        
+      const long outer = long(convolution_impl::n_elements(size) / (length * inner));
+      
+      next.resize(size_t(outer) * new_length * inner);
+      
+      #pragma omp parallel for num_threads(_n_threads) schedule(static)
+      for(long o = 0; o < outer; ++o)
+      {
+        const float_t * source = & current[size_t(o) * length * inner];
+        float_t * target = & next[size_t(o) * new_length * inner];
+        
+        if(inner == 1)
+        {
+          // the lines are contiguous, vectorize along them
+          std::fill(target, target + new_length, 0.0);
+          
+          for(size_t k = 0; k < kernel_width; ++k)
+          {
+            const float_t weight = factor[k];
+            const float_t * shifted_source = source + kernel_width - 1 - k;
+            
+            for(size_t x = 0; x < new_length; ++x)
+              target[x] += weight * shifted_source[x];
+          }
+          
+          continue;
+        }
+        
+        for(size_t x = 0; x < new_length; ++x)
+        {
+          float_t * target_line = target + x * inner;
+          
+          std::fill(target_line, target_line + inner, 0.0);
+          
+          for(size_t k = 0; k < kernel_width; ++k)
+          {
+            const float_t weight = factor[k];
+            const float_t * source_line = source + (x + kernel_width - 1 - k) * inner;
+            
+            for(size_t i = 0; i < inner; ++i)
+              target_line[i] += weight * source_line[i];
+          }
+        }
+      }
+      
+      size(a) = new_length;
+      current.swap(next);
+    }
+    
+    std::copy(current.begin(), current.end(), out.data());
+  }
+  
+  template <size_t N>
+  void Convolution<N>::transform(std::vector< std::complex<float_t> > & data, const ublas::fixed_vector<size_t, N> & size, bool inverse) const
+  {
+    const size_t BLOCK_WIDTH = 16;
+    
+    for(size_t a = 0; a < N; ++a)
+    {
+      const size_t length = size(a);
+      size_t inner = 1;
+      
+      for(size_t i = a + 1; i < N; ++i)
+        inner *= size(i);
+        
+      // blocks of neighbouring lines are gathered into a buffer such that the memory is read contiguously
+      const size_t n_inner_blocks = (inner + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+      const long n_blocks = long(data.size() / (length * inner) * n_inner_blocks);
+      convolution_impl::fft_plan plan(length);
+      
+      #pragma omp parallel num_threads(_n_threads)
+      {
+        std::vector< std::complex<float_t> > buffer(length * BLOCK_WIDTH);
+        
+        #pragma omp for schedule(static)
+        for(long block = 0; block < n_blocks; ++block)
+        {
+          size_t o = size_t(block) / n_inner_blocks;
+          size_t begin = (size_t(block) % n_inner_blocks) * BLOCK_WIDTH;
+          size_t width = std::min(BLOCK_WIDTH, inner - begin);
+          std::complex<float_t> * first = & data[o * length * inner + begin];
+          
+          for(size_t n = 0; n < length; ++n)
+            for(size_t j = 0; j < width; ++j)
+              buffer[j * length + n] = first[n * inner + j];
+              
+          for(size_t j = 0; j < width; ++j)
+            plan.transform(& buffer[j * length], inverse);
+          
+          for(size_t n = 0; n < length; ++n)
+            for(size_t j = 0; j < width; ++j)
+              first[n * inner + j] = buffer[j * length + n];
+        }
+      }
+    }
+  }
+  
+  template <size_t N>
+  void Convolution<N>::convolve_fft(const Image<N, float_t> & padded, Image<N, float_t> & out) const
+  {
+    // circular convolution of the padded image and the kernel, the result is not affected by the wrap around
+    // beyond the first kernel.size() - 1 pixels along each axis
+    ublas::fixed_vector<size_t, N> size;
+    
+    for(size_t i = 0; i < N; ++i)
+      size(i) = convolution_impl::fft_size(padded.size()(i));
+      
+    const size_t n_elements = convolution_impl::n_elements(size);
+    size_t coordinates[N];
+    
+    // the padded image and the kernel are transformed at once as real and imaginary part of one array
+    std::vector< std::complex<float_t> > data(n_elements);
+    
+    for(size_t line = 0; line < padded.n_pixels() / padded.size()(N - 1); ++line)
+    {
+      convolution_impl::line_coordinates(line, padded.size(), coordinates);
+      
+      const float_t * source = padded.data() + line * padded.size()(N - 1);
+      std::complex<float_t> * target = & data[convolution_impl::line_offset(coordinates, size)];
+      
+      for(size_t x = 0; x < padded.size()(N - 1); ++x)
+        target[x] = std::complex<float_t>(source[x], 0.0);
+    }
+    
+    for(size_t line = 0; line < _kernel.n_pixels() / _kernel.size()(N - 1); ++line)
+    {
+      convolution_impl::line_coordinates(line, _kernel.size(), coordinates);
+      
+      const float_t * source = _kernel.data() + line * _kernel.size()(N - 1);
+      std::complex<float_t> * target = & data[convolution_impl::line_offset(coordinates, size)];
+      
+      for(size_t x = 0; x < _kernel.size()(N - 1); ++x)
+        target[x] = std::complex<float_t>(target[x].real(), source[x]);
+    }
+    
+    transform(data, size, false);
+    
+    // with Z = F(image + i kernel) the transforms are F(image) = (Z(f) + conj Z(-f)) / 2 and F(kernel) = (Z(f) - conj Z(-f)) / 2i
+    std::vector< std::complex<float_t> > product(n_elements);
+    const float_t scale = 0.25 / float_t(n_elements);
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long i = 0; i < long(n_elements); ++i)
+    {
+      size_t remainder = size_t(i);
+      size_t negative = 0;
+      size_t stride = 1;
+      
+      for(size_t a = N; a > 0; --a)
+      {
+        size_t c = remainder % size(a - 1);
+        remainder /= size(a - 1);
+        negative += ((size(a - 1) - c) % size(a - 1)) * stride;
+        stride *= size(a - 1);
+      }
+      
+      const float_t z_re = data[i].real(), z_im = data[i].imag();
+      const float_t w_re = data[negative].real(), w_im = -data[negative].imag();
+      
+      // (z + w) * (z - w) / i = (z^2 - w^2) / i
+      const float_t d_re = z_re * z_re - z_im * z_im - w_re * w_re + w_im * w_im;
+      const float_t d_im = 2.0 * (z_re * z_im - w_re * w_im);
+      
+      product[i] = std::complex<float_t>(d_im * scale, -d_re * scale);
+    }
+    
+    transform(product, size, true);
+    
+    for(size_t line = 0; line < out.n_pixels() / out.size()(N - 1); ++line)
+    {
+      convolution_impl::line_coordinates(line, out.size(), coordinates);
+      
+      for(size_t i = 0; i + 1 < N; ++i)
+        coordinates[i] += _kernel.size()(i) - 1;
+        
+      const std::complex<float_t> * source = & product[convolution_impl::line_offset(coordinates, size) + _kernel.size()(N - 1) - 1];
+      float_t * target = out.data() + line * out.size()(N - 1);
+      
+      for(size_t x = 0; x < out.size()(N - 1); ++x)
+        target[x] = source[x].real();
+    }
+  }
+}
+
+#endif
@@ -69,6 +69,34 @@ namespace imaging
     operator float_t() const { return float_t(_value) / 255.0; }
   };
   
+  /** \cond */
+  namespace image_file_impl
+  {
+    template <>
+    class pixel_traits<GrayValue>
+    {
+    public:
+      static const size_t n_channels = 1;
+      
+      static ImageFileReader::sample_types sample_type() { return ImageFileReader::UINT8_SAMPLE; }
+      
+      static void read(const float_t * samples, size_t n_samples, float_t max_value, GrayValue & pixel)
+      {
+        float_t value = n_samples == 3 ? (samples[0] + samples[1] + samples[2]) / 3.0 : samples[0];
+        value = floor(value / max_value * 255.0 + 0.5);
+        
+        pixel = GrayValue((unsigned char)(value < 0.0 ? 0.0 : (value > 255.0 ? 255.0 : value)));
+      }
+      
+      static void write(const GrayValue & pixel, size_t n_samples, float_t max_value, float_t * samples)
+      {
+        for(size_t i = 0; i < n_samples; ++i)
+          samples[i] = float_t((unsigned char)(pixel)) / 255.0 * max_value;
+      }
+    };
+  }
+  /** \endcond */
+  
   /** \ingroup image
       \brief 2-dimensional grayscale image.
       
@@ -80,9 +108,11 @@ namespace imaging
   */
   typedef Image<2, GrayValue> GrayImage2d;
   
+  /** Reads the image from the file \em file_name. Formats which are supported by ImageFileReader are decoded natively, all other formats are read by ImageMagick. */
   template<>
   void GrayImage2d::read_image(const std::string & file_name);
   
+  /** Writes the image to the file \em file_name. Formats which are supported by ImageFileWriter are encoded natively, all other formats are written by ImageMagick. */
   template<>
   void GrayImage2d::write_image(const std::string & file_name) const;
   
@@ -97,9 +127,11 @@ namespace imaging
   */
   typedef Image<3, GrayValue> GrayImage3d;
   
+  /** Reads the image from the file \em file_name. Formats which are supported by ImageFileReader are decoded according to the suffix of \em file_name. Files with any other suffix are read as 8-bit raw volumes (cf. ImageFileReader). */
   template<>
   void GrayImage3d::read_image(const std::string & file_name);
   
+  /** Writes the image to the file \em file_name. Formats which are supported by ImageFileWriter are encoded according to the suffix of \em file_name. If the suffix is unknown, the image is written as 8-bit raw volume (cf. ImageFileWriter). */
   template<>
   void GrayImage3d::write_image(const std::string & file_name) const;
 }
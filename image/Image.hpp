@@ -21,6 +21,7 @@
 #define IMAGE_H
 
 #include "ImageInterface.hpp"
+#include <image/ImageFile.hpp>
 #include <boost/multi_array.hpp>
 
 namespace imaging
@@ -95,6 +96,8 @@ namespace imaging
       \brief Stores image data of arbitrary dimension and pixel type.
       
       Use this class template to store image data of dimension \em N with pixel data of type \em DATA_t. Objects of this class can be resized by calling set_size(). This is not generally true for implementations of ImageInterface.
+      
+      The pixels are stored contiguously in the storage of the base class \em boost::multi_array with the last index component running fastest. Algorithms which visit every pixel regardless of its position can traverse the image linearly from <em>data()</em> to <tt>data() + n_pixels()</tt>, which is much faster than incrementing an index by increment_index() and accessing the pixels by operator[](). copy_image(), min() and max() do this automatically for objects of this class.
   */
   template <std::size_t N, class DATA_t>
   class Image : public ImageInterface<N, DATA_t>, public boost::multi_array<DATA_t, N>
@@ -114,13 +117,13 @@ namespace imaging
     explicit Image(const ublas::fixed_vector<size_t, dimension> & size) : boost::multi_array<DATA_t, dimension>(size), _size(size)
     { }
     
-    /** Construct an image from the file \em file_name. The type of the file is determined from the suffix of \em file_name. Currently only 2-dimensional images are supported. */
+    /** Construct an image from the file \em file_name. The type of the file is determined from the suffix of \em file_name (cf. read_image()). */
     explicit Image(const std::string & file_name)
     { 
       read_image(file_name);
     }
     
-    /** Construct an image from the file \em file_name. The type of the file is determined from the suffix of \em file_name. Currently only 2-dimensional images are supported. */
+    /** Construct an image from the file \em file_name. The type of the file is determined from the suffix of \em file_name (cf. read_image()). */
     explicit Image(const char * file_name)
     { 
       read_image(file_name);
@@ -158,6 +161,9 @@ namespace imaging
 
     const ublas::fixed_vector<size_t, dimension> & size() const { return _size; }
     
+    /** Returns the number of pixels of the image, i.e. the length of the linear pixel storage starting at <em>data()</em>. */
+    size_t n_pixels() const { return this->num_elements(); }
+    
     /** Sets the size of the image. */
     void resize(const ublas::fixed_vector<size_t, dimension> & size)
     {
@@ -175,11 +181,11 @@ namespace imaging
       return false;
     }
     
-    /** Reads the image from the file \em file_name. The type of the file is determined from the suffix of \em file_name. Currently only 2-dimensional images are supported. */
-    void read_image(const std::string & file_name) { }
+    /** Reads the image from the file \em file_name. The type of the file is determined from the suffix of \em file_name. 2- and 3-dimensional images can be read from portable graymaps and pixmaps (<tt>.pgm, .ppm, .pnm</tt>), portable float maps (<tt>.pfm</tt>) and raw volumes (<tt>.raw</tt>), cf. ImageFileReader. The file is decoded row by row directly into the storage of the image. Floating point pixels are scaled to the interval [0, 1], integer pixels hold the sample values of the file. */
+    void read_image(const std::string & file_name) { image_file_impl::read_image(file_name, *this); }
 
-    /** Writes the image to the file \em file_name. The type of the file is determined from the suffix of \em file_name. Currently only 2-dimensional images are supported. */
-    void write_image(const std::string & file_name) const { }
+    /** Writes the image to the file \em file_name. The type of the file is determined from the suffix of \em file_name. The supported formats are the same as for read_image(), cf. ImageFileWriter. Floating point pixels are expected in the interval [0, 1] and are written as 16-bit samples to portable any maps. */
+    void write_image(const std::string & file_name) const { image_file_impl::write_image(file_name, *this); }
   };
 
   template <class source_accessor_t, class target_accessor_t>
@@ -206,6 +212,30 @@ namespace imaging
     while(increment_index(source.size(), index));
   }
   
+  /** \cond */
+  namespace image_impl
+  {
+    // linear traversals of images with at least this number of pixels are parallelized
+    const long PARALLEL_TRAVERSAL_SIZE = 1 << 16;
+  }
+  /** \endcond */
+  
+  /** Copies \em source to \em target. This overload is chosen if both images are of type Image. Because the pixels of both images are stored in the same order, the pixel data is copied in a single linear loop (in parallel for large images). */
+  template <std::size_t N, class SOURCE_DATA_t, class TARGET_DATA_t>
+  void copy_image(const Image<N, SOURCE_DATA_t> & source, Image<N, TARGET_DATA_t> & target)
+  {
+    if(source.size() != target.size())
+      throw Exception("Exception: Dimensions in copy_image() do not agree.");
+      
+    const SOURCE_DATA_t * source_data = source.data();
+    TARGET_DATA_t * target_data = target.data();
+    const long n_pixels = long(source.n_pixels());
+    
+    #pragma omp parallel for if(n_pixels >= image_impl::PARALLEL_TRAVERSAL_SIZE)
+    for(long i = 0; i < n_pixels; ++i)
+      target_data[i] = (TARGET_DATA_t)(source_data[i]);
+  }
+  
   namespace image_impl
   {
     template <size_t N>
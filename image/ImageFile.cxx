@@ -0,0 +1,587 @@
+#include <image/ImageFile.hpp>
+
+#include <stdint.h>
+#include <string.h>
+#include <boost/lexical_cast.hpp>
+
+
+namespace imaging
+{
+  /** \cond */
+  namespace image_file_impl
+  {
+    std::string suffix(const std::string & file_name)
+    {
+      size_t dot = file_name.rfind('.');
+      
+      if(dot == std::string::npos)
+        return std::string();
+        
+      std::string result = file_name.substr(dot + 1);
+      
+      for(size_t i = 0; i < result.size(); ++i)
+        result[i] = tolower(result[i]);
+        
+      return result;
+    }
+    
+    // determines the format from the suffix of file_name; returns false for unknown suffixes
+    bool file_format(const std::string & file_name, ImageFileReader::file_formats & format)
+    {
+      std::string s = suffix(file_name);
+      
+      if(s == "pgm" || s == "ppm" || s == "pnm")
+        format = ImageFileReader::PNM_FORMAT;
+      else if(s == "pfm")
+        format = ImageFileReader::PFM_FORMAT;
+      else if(s == "raw")
+        format = ImageFileReader::RAW_FORMAT;
+      else
+        return false;
+        
+      return true;
+    }
+    
+    bool is_little_endian_host()
+    {
+      const uint16_t one = 1;
+      return *reinterpret_cast<const unsigned char *>(&one) == 1;
+    }
+    
+    size_t sample_size(ImageFileReader::sample_types sample_type)
+    {
+      switch(sample_type)
+      {
+      case ImageFileReader::UINT8_SAMPLE:
+        return 1;
+      case ImageFileReader::UINT16_SAMPLE:
+        return 2;
+      default:
+        return 4;
+      }
+    }
+    
+    // skips white space and comments in the header of portable any maps
+    int skip_white_space(FILE * file)
+    {
+      int c = fgetc(file);
+      
+      while(c != EOF)
+      {
+        if(c == '#')
+        {
+          while(c != EOF && c != '\n' && c != '\r')
+            c = fgetc(file);
+        }
+        else if(! isspace(c))
+          break;
+          
+        c = fgetc(file);
+      }
+      
+      return c;
+    }
+    
+    bool read_header_value(FILE * file, std::string & value)
+    {
+      int c = skip_white_space(file);
+      
+      value.clear();
+      
+      while(c != EOF && ! isspace(c) && c != '#')
+      {
+        value += char(c);
+        c = fgetc(file);
+      }
+      
+      if(c == '#')
+        ungetc(c, file);
+      
+      return ! value.empty();
+    }
+    
+    template <class value_t>
+    value_t header_value(FILE * file, const std::string & file_name)
+    {
+      std::string value;
+      
+      if(! read_header_value(file, value))
+        throw FileIoException("FileIoException: Unexpected end of header in file '" + file_name + "' in ImageFileReader::ImageFileReader().");
+      
+      try
+      {
+        return boost::lexical_cast<value_t>(value);
+      }
+      catch(boost::bad_lexical_cast &)
+      {
+        throw FileIoException("FileIoException: Invalid header entry '" + value + "' in file '" + file_name + "' in ImageFileReader::ImageFileReader().");
+      }
+    }
+    
+    void decode_samples(const unsigned char * buffer, size_t n_samples, ImageFileReader::sample_types sample_type, bool is_big_endian, float_t * samples)
+    {
+      const bool swap = is_big_endian == is_little_endian_host();
+      
+      switch(sample_type)
+      {
+      case ImageFileReader::UINT8_SAMPLE:
+        for(size_t i = 0; i < n_samples; ++i)
+          samples[i] = float_t(buffer[i]);
+        break;
+        
+      case ImageFileReader::UINT16_SAMPLE:
+        for(size_t i = 0; i < n_samples; ++i, buffer += 2)
+        {
+          if(is_big_endian)
+            samples[i] = float_t((uint16_t(buffer[0]) << 8) | uint16_t(buffer[1]));
+          else
+            samples[i] = float_t((uint16_t(buffer[1]) << 8) | uint16_t(buffer[0]));
+        }
+        break;
+        
+      case ImageFileReader::FLOAT_SAMPLE:
+        for(size_t i = 0; i < n_samples; ++i, buffer += 4)
+        {
+          unsigned char bytes[4];
+          float value;
+          
+          if(swap)
+          {
+            bytes[0] = buffer[3];
+            bytes[1] = buffer[2];
+            bytes[2] = buffer[1];
+            bytes[3] = buffer[0];
+          }
+          else
+            memcpy(bytes, buffer, 4);
+            
+          memcpy(&value, bytes, 4);
+          samples[i] = float_t(value);
+        }
+        break;
+      }
+    }
+    
+    void encode_samples(const float_t * samples, size_t n_samples, ImageFileReader::sample_types sample_type, float_t max_value, bool is_big_endian, unsigned char * buffer)
+    {
+      const bool swap = is_big_endian == is_little_endian_host();
+      
+      switch(sample_type)
+      {
+      case ImageFileReader::UINT8_SAMPLE:
+      case ImageFileReader::UINT16_SAMPLE:
+        for(size_t i = 0; i < n_samples; ++i)
+        {
+          float_t value = floor(samples[i] + 0.5);
+          uint16_t sample = value <= 0.0 ? 0 : (value >= max_value ? uint16_t(max_value) : uint16_t(value));
+          
+          if(sample_type == ImageFileReader::UINT8_SAMPLE)
+            *(buffer++) = (unsigned char)(sample);
+          else if(is_big_endian)
+          {
+            *(buffer++) = (unsigned char)(sample >> 8);
+            *(buffer++) = (unsigned char)(sample & 0xff);
+          }
+          else
+          {
+            *(buffer++) = (unsigned char)(sample & 0xff);
+            *(buffer++) = (unsigned char)(sample >> 8);
+          }
+        }
+        break;
+        
+      case ImageFileReader::FLOAT_SAMPLE:
+        for(size_t i = 0; i < n_samples; ++i, buffer += 4)
+        {
+          float value = float(samples[i]);
+          unsigned char bytes[4];
+          
+          memcpy(bytes, &value, 4);
+          
+          if(swap)
+          {
+            buffer[0] = bytes[3];
+            buffer[1] = bytes[2];
+            buffer[2] = bytes[1];
+            buffer[3] = bytes[0];
+          }
+          else
+            memcpy(buffer, bytes, 4);
+        }
+        break;
+      }
+    }
+  }
+  /** \endcond */
+  
+  bool ImageFileReader::is_supported(const std::string & file_name)
+  {
+    file_formats format;
+    return image_file_impl::file_format(file_name, format);
+  }
+  
+  ImageFileReader::ImageFileReader(const std::string & file_name) :
+    _file(0), _file_name(file_name), _is_ascii(false), _is_big_endian(true), _is_bottom_up(false),
+    _size(1, 1, 1), _n_channels(1), _sample_type(UINT8_SAMPLE), _max_value(255.0), _current_row(0)
+  {
+    file_formats format;
+    
+    if(! image_file_impl::file_format(file_name, format))
+      throw FileIoException("FileIoException: Unsupported file format of '" + file_name + "' in ImageFileReader::ImageFileReader().");
+      
+    open(format);
+  }
+  
+  ImageFileReader::ImageFileReader(const std::string & file_name, file_formats format) :
+    _file(0), _file_name(file_name), _is_ascii(false), _is_big_endian(true), _is_bottom_up(false),
+    _size(1, 1, 1), _n_channels(1), _sample_type(UINT8_SAMPLE), _max_value(255.0), _current_row(0)
+  {
+    open(format);
+  }
+  
+  void ImageFileReader::open(file_formats format)
+  {
+    const std::string & file_name = _file_name;
+    
+    _file = fopen(file_name.c_str(), "rb");
+    
+    if(_file == 0)
+      throw FileIoException("FileIoException: Could not open file '" + file_name + "' in ImageFileReader::ImageFileReader().");
+      
+    try
+    {
+      _format = format;
+      
+      if(format == RAW_FORMAT)
+      {
+        read_raw_header();
+      }
+      else
+      {
+        int p = fgetc(_file);
+        int magic = fgetc(_file);
+        
+        if(p != 'P')
+          throw FileIoException("FileIoException: Invalid header of file '" + file_name + "' in ImageFileReader::ImageFileReader().");
+          
+        if(format == PFM_FORMAT)
+          read_pfm_header(char(magic));
+        else
+          read_pnm_header(char(magic));
+      }
+    }
+    catch(Exception &)
+    {
+      fclose(_file);
+      throw;
+    }
+    
+    if(! _is_ascii)
+      _buffer.resize(_size(0) * _n_channels * image_file_impl::sample_size(_sample_type));
+  }
+  
+  ImageFileReader::~ImageFileReader()
+  {
+    fclose(_file);
+  }
+  
+  void ImageFileReader::read_pnm_header(char magic)
+  {
+    switch(magic)
+    {
+    case '2':
+      _is_ascii = true;
+      // fall through
+    case '5':
+      _n_channels = 1;
+      break;
+    case '3':
+      _is_ascii = true;
+      // fall through
+    case '6':
+      _n_channels = 3;
+      break;
+    default:
+      throw FileIoException("FileIoException: Unsupported portable any map type 'P" + std::string(1, magic) + "' of file '" + _file_name + "' in ImageFileReader::ImageFileReader().");
+    }
+    
+    _size(0) = image_file_impl::header_value<size_t>(_file, _file_name);
+    _size(1) = image_file_impl::header_value<size_t>(_file, _file_name);
+    _max_value = image_file_impl::header_value<size_t>(_file, _file_name);
+    
+    if(_max_value < 1.0 || _max_value > 65535.0)
+      throw FileIoException("FileIoException: Invalid maximal value in file '" + _file_name + "' in ImageFileReader::ImageFileReader().");
+    
+    _sample_type = _max_value > 255.0 ? UINT16_SAMPLE : UINT8_SAMPLE;
+    _is_big_endian = true;
+    _is_bottom_up = false;
+  }
+  
+  void ImageFileReader::read_pfm_header(char magic)
+  {
+    switch(magic)
+    {
+    case 'f':
+      _n_channels = 1;
+      break;
+    case 'F':
+      _n_channels = 3;
+      break;
+    default:
+      throw FileIoException("FileIoException: Unsupported portable float map type 'P" + std::string(1, magic) + "' of file '" + _file_name + "' in ImageFileReader::ImageFileReader().");
+    }
+    
+    _size(0) = image_file_impl::header_value<size_t>(_file, _file_name);
+    _size(1) = image_file_impl::header_value<size_t>(_file, _file_name);
+    
+    // the sign of the scale determines the byte order
+    float_t scale = image_file_impl::header_value<float_t>(_file, _file_name);
+    
+    _sample_type = FLOAT_SAMPLE;
+    _max_value = 1.0;
+    _is_big_endian = scale > 0.0;
+    _is_bottom_up = true;
+  }
+  
+  void ImageFileReader::read_raw_header()
+  {
+    unsigned char size_buffer[3 * sizeof(uint32_t)];
+    
+    if(fread(size_buffer, 1, sizeof(size_buffer), _file) != sizeof(size_buffer))
+      throw FileIoException("FileIoException: File '" + _file_name + "' too short in ImageFileReader::ImageFileReader().");
+      
+    for(size_t i = 0; i < 3; ++i)
+      _size(i) = size_t(size_buffer[4 * i]) | (size_t(size_buffer[4 * i + 1]) << 8) | (size_t(size_buffer[4 * i + 2]) << 16) | (size_t(size_buffer[4 * i + 3]) << 24);
+      
+    long header_end = ftell(_file);
+    fseek(_file, 0, SEEK_END);
+    long file_size = ftell(_file);
+    fseek(_file, header_end, SEEK_SET);
+    
+    size_t n_pixels = _size(0) * _size(1) * _size(2);
+    size_t n_bytes = size_t(file_size - header_end);
+    
+    _is_big_endian = false;
+    _is_bottom_up = true;
+    _max_value = 1.0;
+    
+    if(n_pixels == 0)
+      return;
+    
+    // the type of the samples is determined by the number of bytes per pixel
+    if(n_bytes % n_pixels != 0)
+      throw FileIoException("FileIoException: Size of file '" + _file_name + "' does not match its dimensions in ImageFileReader::ImageFileReader().");
+      
+    switch(n_bytes / n_pixels)
+    {
+    case 1:
+    case 3:
+      _sample_type = UINT8_SAMPLE;
+      _max_value = 255.0;
+      break;
+    case 2:
+    case 6:
+      _sample_type = UINT16_SAMPLE;
+      _max_value = 65535.0;
+      break;
+    case 4:
+    case 12:
+      _sample_type = FLOAT_SAMPLE;
+      break;
+    default:
+      throw FileIoException("FileIoException: Size of file '" + _file_name + "' does not match its dimensions in ImageFileReader::ImageFileReader().");
+    }
+    
+    _n_channels = (n_bytes / n_pixels) % 3 == 0 ? 3 : 1;
+  }
+  
+  void ImageFileReader::row_position(size_t row, size_t & y, size_t & z) const
+  {
+    y = row % _size(1);
+    z = row / _size(1);
+    
+    if(! _is_bottom_up)
+      y = _size(1) - y - 1;
+  }
+  
+  void ImageFileReader::read_row(float_t * samples)
+  {
+    const size_t n_samples = _size(0) * _n_channels;
+    
+    if(_current_row >= n_rows())
+      throw FileIoException("FileIoException: Read beyond the last row of file '" + _file_name + "' in ImageFileReader::read_row().");
+      
+    if(_is_ascii)
+    {
+      for(size_t i = 0; i < n_samples; ++i)
+      {
+        std::string value;
+        
+        if(! image_file_impl::read_header_value(_file, value))
+          throw FileIoException("FileIoException: File '" + _file_name + "' too short in ImageFileReader::read_row().");
+          
+        try
+        {
+          samples[i] = float_t(boost::lexical_cast<size_t>(value));
+        }
+        catch(boost::bad_lexical_cast &)
+        {
+          throw FileIoException("FileIoException: Invalid sample '" + value + "' in file '" + _file_name + "' in ImageFileReader::read_row().");
+        }
+      }
+    }
+    else
+    {
+      if(fread(&_buffer[0], 1, _buffer.size(), _file) != _buffer.size())
+        throw FileIoException("FileIoException: File '" + _file_name + "' too short in ImageFileReader::read_row().");
+        
+      image_file_impl::decode_samples(&_buffer[0], n_samples, _sample_type, _is_big_endian, samples);
+    }
+    
+    ++_current_row;
+  }
+  
+  ImageFileWriter::ImageFileWriter(const std::string & file_name, const ublas::fixed_vector<size_t, 3> & size, size_t n_channels, sample_types sample_type) :
+    _file(0), _file_name(file_name), _size(size), _n_channels(n_channels == 3 ? 3 : 1), _sample_type(sample_type), _current_row(0)
+  {
+    file_formats format;
+    
+    if(! image_file_impl::file_format(file_name, format))
+      throw FileIoException("FileIoException: Unsupported file format of '" + file_name + "' in ImageFileWriter::ImageFileWriter().");
+      
+    open(format);
+  }
+  
+  ImageFileWriter::ImageFileWriter(const std::string & file_name, file_formats format, const ublas::fixed_vector<size_t, 3> & size, size_t n_channels, sample_types sample_type) :
+    _file(0), _file_name(file_name), _size(size), _n_channels(n_channels == 3 ? 3 : 1), _sample_type(sample_type), _current_row(0)
+  {
+    open(format);
+  }
+  
+  void ImageFileWriter::open(file_formats format)
+  {
+    const std::string & file_name = _file_name;
+    std::string s = image_file_impl::suffix(file_name);
+    
+    _format = format;
+    
+    switch(format)
+    {
+    case ImageFileReader::PNM_FORMAT:
+      if(s == "pgm")
+        _n_channels = 1;
+      else if(s == "ppm")
+        _n_channels = 3;
+        
+      if(_sample_type == ImageFileReader::FLOAT_SAMPLE)
+        _sample_type = ImageFileReader::UINT16_SAMPLE;
+        
+      _max_value = _sample_type == ImageFileReader::UINT8_SAMPLE ? 255.0 : 65535.0;
+      break;
+      
+    case ImageFileReader::PFM_FORMAT:
+      _sample_type = ImageFileReader::FLOAT_SAMPLE;
+      _max_value = 1.0;
+      break;
+      
+    case ImageFileReader::RAW_FORMAT:
+      _max_value = _sample_type == ImageFileReader::UINT8_SAMPLE ? 255.0 : (_sample_type == ImageFileReader::UINT16_SAMPLE ? 65535.0 : 1.0);
+      break;
+    }
+    
+    if(_format != ImageFileReader::RAW_FORMAT && _size(2) != 1)
+      throw FileIoException("FileIoException: The format of '" + file_name + "' does not support 3-dimensional images in ImageFileWriter::ImageFileWriter().");
+      
+    if(_format == ImageFileReader::RAW_FORMAT)
+      for(size_t i = 0; i < 3; ++i)
+        if(_size(i) > size_t(uint32_t(-1)))
+          throw FileIoException("FileIoException: Image too large for file '" + file_name + "' in ImageFileWriter::ImageFileWriter().");
+    
+    _file = fopen(file_name.c_str(), "wb");
+    
+    if(_file == 0)
+      throw FileIoException("FileIoException: Could not open file '" + file_name + "' in ImageFileWriter::ImageFileWriter().");
+      
+    bool header_written = true;
+      
+    if(_format == ImageFileReader::PNM_FORMAT)
+    {
+      header_written = fprintf(_file, "P%c\n%lu %lu\n%lu\n", _n_channels == 3 ? '6' : '5',
+                               (unsigned long)(_size(0)), (unsigned long)(_size(1)), (unsigned long)(_max_value)) > 0;
+    }
+    else if(_format == ImageFileReader::PFM_FORMAT)
+    {
+      header_written = fprintf(_file, "P%c\n%lu %lu\n%s\n", _n_channels == 3 ? 'F' : 'f',
+                               (unsigned long)(_size(0)), (unsigned long)(_size(1)), image_file_impl::is_little_endian_host() ? "-1.0" : "1.0") > 0;
+    }
+    else
+    {
+      unsigned char size_buffer[3 * sizeof(uint32_t)];
+      
+      for(size_t i = 0; i < 3; ++i)
+        for(size_t j = 0; j < 4; ++j)
+          size_buffer[4 * i + j] = (unsigned char)((_size(i) >> (8 * j)) & 0xff);
+          
+      header_written = fwrite(size_buffer, 1, sizeof(size_buffer), _file) == sizeof(size_buffer);
+    }
+    
+    if(! header_written)
+    {
+      fclose(_file);
+      _file = 0;
+      throw FileIoException("FileIoException: Write error in file '" + file_name + "' in ImageFileWriter::ImageFileWriter().");
+    }
+    
+    _buffer.resize(_size(0) * _n_channels * image_file_impl::sample_size(_sample_type));
+  }
+  
+  ImageFileWriter::~ImageFileWriter()
+  {
+    if(_file)
+      fclose(_file);
+  }
+  
+  void ImageFileWriter::close()
+  {
+    if(_file == 0)
+      return;
+      
+    // buffered data is written by fclose(), which is the last chance to detect a full disk
+    int result = fclose(_file);
+    _file = 0;
+    
+    if(result != 0)
+      throw FileIoException("FileIoException: Write error when closing file '" + _file_name + "' in ImageFileWriter::close().");
+      
+    if(_size(0) > 0 && _current_row < n_rows())
+      throw FileIoException("FileIoException: Not all rows of file '" + _file_name + "' have been written in ImageFileWriter::close().");
+  }
+  
+  void ImageFileWriter::row_position(size_t row, size_t & y, size_t & z) const
+  {
+    y = row % _size(1);
+    z = row / _size(1);
+    
+    if(_format == ImageFileReader::PNM_FORMAT)
+      y = _size(1) - y - 1;
+  }
+  
+  void ImageFileWriter::write_row(const float_t * samples)
+  {
+    if(_file == 0)
+      throw FileIoException("FileIoException: File '" + _file_name + "' has already been closed in ImageFileWriter::write_row().");
+      
+    if(_current_row >= n_rows())
+      throw FileIoException("FileIoException: Write beyond the last row of file '" + _file_name + "' in ImageFileWriter::write_row().");
+      
+    // portable any maps are big endian, raw volumes little endian and portable float maps are written in the byte order of the host
+    bool is_big_endian = _format == ImageFileReader::PNM_FORMAT || (_format == ImageFileReader::PFM_FORMAT && ! image_file_impl::is_little_endian_host());
+      
+    image_file_impl::encode_samples(samples, _size(0) * _n_channels, _sample_type, _max_value, is_big_endian, &_buffer[0]);
+    
+    if(fwrite(&_buffer[0], 1, _buffer.size(), _file) != _buffer.size())
+      throw FileIoException("FileIoException: Write error in file '" + _file_name + "' in ImageFileWriter::write_row().");
+      
+    ++_current_row;
+  }
+}
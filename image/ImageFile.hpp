@@ -0,0 +1,446 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGE_IMAGEFILE_H
+#define IMAGE_IMAGEFILE_H
+
+#include <core/imaging2.hpp>
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <boost/type_traits/is_floating_point.hpp>
+
+namespace imaging
+{
+  /** \ingroup image
+      \brief Reads image files row by row.
+      
+      This class decodes image files without any external library. The format is determined from the suffix of the file name:
+        - <tt>.pgm, .ppm, .pnm</tt>: Portable graymap/pixmap in binary (P5, P6) or ASCII (P2, P3) encoding with 8 or 16 bits per sample.
+        - <tt>.pfm</tt>: Portable float map with 1 (Pf) or 3 (PF) channels.
+        - <tt>.raw</tt>: Raw volume. The file starts with the width, height and depth of the volume as 32-bit unsigned integers, followed by the samples with the <em>x</em>-coordinate running fastest. The sample type is determined from the size of the file: 1, 2 or 4 bytes per pixel correspond to 8-bit, 16-bit (little endian) and 32-bit floating point (little endian) grayscale samples, 3, 6 or 12 bytes to color samples of the same types. The 8-bit grayscale variant is the format of GrayImage3d files (see GrayImage3d::read_image()).
+        
+      The rows of an image are the sets of pixels with equal <em>y</em>- and <em>z</em>-coordinates. Each call of read_row() decodes the next row of the file; its position in the image is given by row_position(). The <em>y</em>-axis of the image points upwards, i.e. the first row of a PGM file (the top row) has the <em>y</em>-coordinate <tt>size()(1) - 1</tt>.
+      
+      Usually this class is not used directly but through Image::read_image().
+  */
+  class ImageFileReader
+  {
+  public:
+    /** Sample types of image files. */
+    enum sample_types { UINT8_SAMPLE, UINT16_SAMPLE, FLOAT_SAMPLE };
+    
+    /** Formats of image files. */
+    enum file_formats { PNM_FORMAT, PFM_FORMAT, RAW_FORMAT };
+    
+  private:
+    FILE * _file;
+    std::string _file_name;
+    file_formats _format;
+    bool _is_ascii;
+    bool _is_big_endian;
+    bool _is_bottom_up;
+    ublas::fixed_vector<size_t, 3> _size;
+    size_t _n_channels;
+    sample_types _sample_type;
+    float_t _max_value;
+    size_t _current_row;
+    std::vector<unsigned char> _buffer;
+    
+    ImageFileReader(const ImageFileReader &);
+    ImageFileReader & operator=(const ImageFileReader &);
+    
+    void open(file_formats format);
+    void read_pnm_header(char magic);
+    void read_pfm_header(char magic);
+    void read_raw_header();
+    
+  public:
+    /** Opens \em file_name and reads its header. Throws a FileIoException if the file can not be opened or its format is not supported. */
+    explicit ImageFileReader(const std::string & file_name);
+    
+    /** Opens \em file_name, which is expected to be of the given \em format regardless of its suffix, and reads its header. Throws a FileIoException if the file can not be opened or its header is invalid. */
+    ImageFileReader(const std::string & file_name, file_formats format);
+    
+    ~ImageFileReader();
+    
+    /** Returns true if the format of \em file_name (determined from its suffix) is supported by ImageFileReader and ImageFileWriter. */
+    static bool is_supported(const std::string & file_name);
+    
+    /** Returns the width, height and depth of the image. The depth of 2-dimensional images is 1. */
+    const ublas::fixed_vector<size_t, 3> & size() const { return _size; }
+    
+    /** Returns the number of channels, i.e. 1 for grayscale and 3 for color images. */
+    size_t n_channels() const { return _n_channels; }
+    
+    /** Returns the type of the samples stored in the file. */
+    sample_types sample_type() const { return _sample_type; }
+    
+    /** Returns the value which corresponds to full intensity, e.g. 255 for 8-bit samples. For floating point samples this is 1. */
+    float_t max_value() const { return _max_value; }
+    
+    /** Returns the number of rows of the image, i.e. the product of its height and depth. */
+    size_t n_rows() const { return _size(1) * _size(2); }
+    
+    /** Computes the <em>y</em>- and <em>z</em>-coordinate of the <em>row</em>-th row in the file. */
+    void row_position(size_t row, size_t & y, size_t & z) const;
+    
+    /** Decodes the next row of the file and stores its samples in \em samples, which must point to <tt>size()(0) * n_channels()</tt> values. The channels of a pixel are stored consecutively. The samples are not scaled, i.e. they range from 0 to max_value(). */
+    void read_row(float_t * samples);
+  };
+  
+  /** \ingroup image
+      \brief Writes image files row by row.
+      
+      This class is the counterpart of ImageFileReader and supports the same formats. Portable graymaps (<tt>.pgm</tt>) are always written with 1 channel and portable pixmaps (<tt>.ppm</tt>) with 3 channels. The rows must be written in the order given by row_position().
+      
+      Usually this class is not used directly but through Image::write_image().
+  */
+  class ImageFileWriter
+  {
+  public:
+    typedef ImageFileReader::sample_types sample_types;
+    typedef ImageFileReader::file_formats file_formats;
+    
+  private:
+    FILE * _file;
+    std::string _file_name;
+    file_formats _format;
+    ublas::fixed_vector<size_t, 3> _size;
+    size_t _n_channels;
+    sample_types _sample_type;
+    float_t _max_value;
+    size_t _current_row;
+    std::vector<unsigned char> _buffer;
+    
+    ImageFileWriter(const ImageFileWriter &);
+    ImageFileWriter & operator=(const ImageFileWriter &);
+    
+    void open(file_formats format);
+  public:
+    /** Creates \em file_name and writes the header for an image of the given \em size (width, height and depth). The number of channels and the sample type are chosen according to the file format. If the format supports several choices (e.g. 8 or 16 bits per sample), \em n_channels and \em sample_type are used. Throws a FileIoException if the file can not be created or the format does not support the image (e.g. 3-dimensional portable graymaps). */
+    ImageFileWriter(const std::string & file_name, const ublas::fixed_vector<size_t, 3> & size, size_t n_channels, sample_types sample_type);
+    
+    /** Creates \em file_name in the given \em format regardless of its suffix and writes the header (cf. ImageFileWriter(const std::string &, const ublas::fixed_vector<size_t, 3> &, size_t, sample_types)). */
+    ImageFileWriter(const std::string & file_name, file_formats format, const ublas::fixed_vector<size_t, 3> & size, size_t n_channels, sample_types sample_type);
+    
+    /** Closes the file if close() has not been called. Errors are not reported. */
+    ~ImageFileWriter();
+    
+    /** Closes the file. Throws a FileIoException if not all rows have been written or the file could not be flushed to disk (e.g. because the disk is full). */
+    void close();
+    
+    /** Returns the width, height and depth of the image. */
+    const ublas::fixed_vector<size_t, 3> & size() const { return _size; }
+    
+    /** Returns the number of channels stored in the file. */
+    size_t n_channels() const { return _n_channels; }
+    
+    /** Returns the type of the samples stored in the file. */
+    sample_types sample_type() const { return _sample_type; }
+    
+    /** Returns the value which corresponds to full intensity (cf. ImageFileReader::max_value()). */
+    float_t max_value() const { return _max_value; }
+    
+    /** Returns the number of rows of the image. */
+    size_t n_rows() const { return _size(1) * _size(2); }
+    
+    /** Computes the <em>y</em>- and <em>z</em>-coordinate of the <em>row</em>-th row in the file. */
+    void row_position(size_t row, size_t & y, size_t & z) const;
+    
+    /** Encodes the next row of the file from \em samples, which must point to <tt>size()(0) * n_channels()</tt> values ranging from 0 to max_value(). Integer samples are rounded and clamped. */
+    void write_row(const float_t * samples);
+  };
+  
+  /** \cond */
+  namespace image_file_impl
+  {
+    // conversion between pixels and file samples; specialized for GrayValue and Color
+    template <class DATA_t>
+    class pixel_traits
+    {
+    public:
+      static const size_t n_channels = 1;
+      
+      static ImageFileReader::sample_types sample_type()
+      {
+        if(boost::is_floating_point<DATA_t>::value)
+          return ImageFileReader::FLOAT_SAMPLE;
+        else if(sizeof(DATA_t) == 1)
+          return ImageFileReader::UINT8_SAMPLE;
+        else
+          return ImageFileReader::UINT16_SAMPLE;
+      }
+      
+      // floating point pixels are scaled to [0, 1], integer pixels store the sample values
+      static void read(const float_t * samples, size_t n_samples, float_t max_value, DATA_t & pixel)
+      {
+        float_t value = n_samples == 3 ? (samples[0] + samples[1] + samples[2]) / 3.0 : samples[0];
+        
+        if(boost::is_floating_point<DATA_t>::value)
+          pixel = DATA_t(value / max_value);
+        else
+          pixel = DATA_t(floor(value + 0.5));
+      }
+      
+      static void write(const DATA_t & pixel, size_t n_samples, float_t max_value, float_t * samples)
+      {
+        float_t value = boost::is_floating_point<DATA_t>::value ? float_t(pixel) * max_value : float_t(pixel);
+        
+        for(size_t i = 0; i < n_samples; ++i)
+          samples[i] = value;
+      }
+    };
+    
+    template <class image_t>
+    void resize_image(const ublas::fixed_vector<size_t, 3> & size, image_t & image)
+    {
+      const size_t N = image_t::dimension;
+      ublas::fixed_vector<size_t, N> image_size;
+      
+      if(N != 2 && N != 3)
+        throw Exception("Exception: Only 2- and 3-dimensional images can be read in Image::read_image().");
+        
+      if(N == 2 && size(2) != 1)
+        throw FileIoException("FileIoException: Can not read a volume into a 2-dimensional image in Image::read_image().");
+        
+      for(size_t i = 0; i < N; ++i)
+        image_size(i) = size(i);
+        
+      image.resize(image_size);
+    }
+    
+    // the number of samples which are decoded or encoded before they are transposed
+    const size_t BLOCK_SAMPLES = 1 << 18;
+    
+    // the number of x-coordinates of a block which are transposed at once
+    const size_t TILE_WIDTH = 16;
+    
+    // the offsets of the file rows in the storage of an image; the last image axis runs fastest
+    // in memory (y for 2-dimensional, z for 3-dimensional images) while the file rows run along x
+    template <size_t N>
+    class file_rows
+    {
+    public:
+      static long offset(const long *, size_t, size_t)
+      {
+        throw Exception("Exception: Only 2- and 3-dimensional images can be read or written in file_rows::offset().");
+      }
+      
+      static size_t n_block_rows(const ublas::fixed_vector<size_t, 3> &, size_t) { return 1; }
+    };
+    
+    template <>
+    class file_rows<2>
+    {
+    public:
+      static long offset(const long * strides, size_t y, size_t) { return long(y) * strides[1]; }
+      
+      // a block of consecutive rows covers consecutive y-coordinates
+      static size_t n_block_rows(const ublas::fixed_vector<size_t, 3> & size, size_t n_row_samples)
+      {
+        return std::max(size_t(1), std::min(size(1), BLOCK_SAMPLES / std::max(size_t(1), n_row_samples)));
+      }
+    };
+    
+    template <>
+    class file_rows<3>
+    {
+    public:
+      static long offset(const long * strides, size_t y, size_t z) { return long(y) * strides[1] + long(z) * strides[2]; }
+      
+      // a block consists of whole slices such that it covers consecutive z-coordinates
+      static size_t n_block_rows(const ublas::fixed_vector<size_t, 3> & size, size_t n_row_samples)
+      {
+        const size_t n_slice_samples = std::max(size_t(1), n_row_samples * size(1));
+        
+        if(n_slice_samples > BLOCK_SAMPLES)
+          return file_rows<2>::n_block_rows(size, n_row_samples);
+          
+        return std::max(size_t(1), size(1) * std::min(size(2), BLOCK_SAMPLES / n_slice_samples));
+      }
+    };
+    
+    // the rows of a block sorted by their offsets in the image, such that the pixels
+    // of the block are visited in the order of the storage of the image for each x
+    template <class image_t, class file_t>
+    void sorted_block_rows(const file_t & file, const image_t & image, size_t first_row, size_t n_rows,
+                           std::vector< std::pair<long, size_t> > & rows)
+    {
+      rows.resize(n_rows);
+      
+      for(size_t i = 0; i < n_rows; ++i)
+      {
+        size_t y, z;
+        file.row_position(first_row + i, y, z);
+        rows[i] = std::make_pair(file_rows<image_t::dimension>::offset(image.strides(), y, z), i);
+      }
+      
+      std::sort(rows.begin(), rows.end());
+    }
+    
+    // decodes blocks of rows and transposes them into the storage of image
+    template <class image_t>
+    void read_image(ImageFileReader & reader, image_t & image)
+    {
+      typedef typename image_t::data_t data_t;
+      
+      resize_image(reader.size(), image);
+      
+      const size_t width = reader.size()(0);
+      const size_t n_channels = reader.n_channels();
+      const size_t n_row_samples = width * n_channels;
+      
+      if(n_row_samples == 0)
+        return;
+        
+      const size_t n_block_rows = std::min(reader.n_rows(), file_rows<image_t::dimension>::n_block_rows(reader.size(), n_row_samples));
+      std::vector<float_t> samples(n_block_rows * n_row_samples);
+      std::vector< std::pair<long, size_t> > rows;
+      data_t * data = image.data();
+      const long x_stride = image.strides()[0];
+      
+      for(size_t first_row = 0; first_row < reader.n_rows(); first_row += n_block_rows)
+      {
+        const size_t n_rows = std::min(n_block_rows, reader.n_rows() - first_row);
+        
+        for(size_t i = 0; i < n_rows; ++i)
+          reader.read_row(&samples[i * n_row_samples]);
+          
+        sorted_block_rows(reader, image, first_row, n_rows, rows);
+        
+        // the samples of a tile are read row by row while the pixels are written to TILE_WIDTH consecutive positions of the x-axis
+        for(size_t first_x = 0; first_x < width; first_x += TILE_WIDTH)
+        {
+          const size_t last_x = std::min(width, first_x + TILE_WIDTH);
+          
+          for(size_t i = 0; i < n_rows; ++i)
+          {
+            data_t * pixels = data + rows[i].first;
+            const float_t * row_samples = &samples[rows[i].second * n_row_samples];
+            
+            for(size_t x = first_x; x < last_x; ++x)
+              pixel_traits<data_t>::read(row_samples + x * n_channels, n_channels, reader.max_value(), pixels[long(x) * x_stride]);
+          }
+        }
+      }
+    }
+    
+    template <class image_t>
+    void read_image(const std::string & file_name, image_t & image)
+    {
+      ImageFileReader reader(file_name);
+      read_image(reader, image);
+    }
+    
+    template <class image_t>
+    void read_image(const std::string & file_name, ImageFileReader::file_formats format, image_t & image)
+    {
+      ImageFileReader reader(file_name, format);
+      read_image(reader, image);
+    }
+    
+    template <class image_t>
+    ublas::fixed_vector<size_t, 3> file_size(const image_t & image)
+    {
+      const size_t N = image_t::dimension;
+      
+      if(N != 2 && N != 3)
+        throw Exception("Exception: Only 2- and 3-dimensional images can be written in Image::write_image().");
+        
+      ublas::fixed_vector<size_t, 3> size(1, 1, 1);
+      for(size_t i = 0; i < N; ++i)
+        size(i) = image.size()(i);
+        
+      return size;
+    }
+    
+    // transposes blocks of rows from the storage of image and encodes them
+    template <class image_t>
+    void write_image(ImageFileWriter & writer, const image_t & image)
+    {
+      typedef typename image_t::data_t data_t;
+      
+      const size_t width = writer.size()(0);
+      const size_t n_channels = writer.n_channels();
+      const size_t n_row_samples = width * n_channels;
+      
+      if(n_row_samples == 0)
+      {
+        writer.close();
+        return;
+      }
+      
+      const size_t n_block_rows = std::min(writer.n_rows(), file_rows<image_t::dimension>::n_block_rows(writer.size(), n_row_samples));
+      std::vector<float_t> samples(n_block_rows * n_row_samples);
+      std::vector< std::pair<long, size_t> > rows;
+      const data_t * data = image.data();
+      const long x_stride = image.strides()[0];
+      
+      for(size_t first_row = 0; first_row < writer.n_rows(); first_row += n_block_rows)
+      {
+        const size_t n_rows = std::min(n_block_rows, writer.n_rows() - first_row);
+        
+        sorted_block_rows(writer, image, first_row, n_rows, rows);
+        
+        // cf. read_image(ImageFileReader &, image_t &)
+        for(size_t first_x = 0; first_x < width; first_x += TILE_WIDTH)
+        {
+          const size_t last_x = std::min(width, first_x + TILE_WIDTH);
+          
+          for(size_t i = 0; i < n_rows; ++i)
+          {
+            const data_t * pixels = data + rows[i].first;
+            float_t * row_samples = &samples[rows[i].second * n_row_samples];
+            
+            for(size_t x = first_x; x < last_x; ++x)
+              pixel_traits<data_t>::write(pixels[long(x) * x_stride], n_channels, writer.max_value(), row_samples + x * n_channels);
+          }
+        }
+        
+        for(size_t i = 0; i < n_rows; ++i)
+          writer.write_row(&samples[i * n_row_samples]);
+      }
+      
+      writer.close();
+    }
+    
+    template <class image_t>
+    void write_image(const std::string & file_name, const image_t & image)
+    {
+      typedef typename image_t::data_t data_t;
+      
+      ImageFileWriter writer(file_name, file_size(image), pixel_traits<data_t>::n_channels, pixel_traits<data_t>::sample_type());
+      write_image(writer, image);
+    }
+    
+    template <class image_t>
+    void write_image(const std::string & file_name, ImageFileReader::file_formats format, const image_t & image)
+    {
+      typedef typename image_t::data_t data_t;
+      
+      ImageFileWriter writer(file_name, format, file_size(image), pixel_traits<data_t>::n_channels, pixel_traits<data_t>::sample_type());
+      write_image(writer, image);
+    }
+  }
+  /** \endcond */
+}
+
+#endif
@@ -0,0 +1,406 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef IMAGE_INTEGRALIMAGE_H
+#define IMAGE_INTEGRALIMAGE_H
+
+#include <image/Image.hpp>
+#include <shape/Box.hpp>
+
+#include <vector>
+#include <algorithm>
+
+namespace imaging
+{
+  /** \ingroup image
+      \brief Summed-area table of one or several image channels.
+      
+      This class stores for each pixel \em x and each channel the sum of the channel over all pixels whose coordinates are not greater than those of \em x. Once the table has been built, the sum of a channel over any axis aligned box of pixels is obtained from the 2^N corners of the box, independently of the size of the box. Several channels can be stacked in one table, e.g. the image \em f, its square and the constant 1. The values of all channels at a pixel are stored next to each other, such that the sums of all channels over a box are read from the same cache lines (cf. sums()). compute_moments() sets up these three channels for an image:
+      
+  \code
+  img::Image<3, img::float_t> volume("volume.raw");
+  img::IntegralImage<3> table;
+  table.compute_moments(volume);
+  
+  img::float_t moments[3];
+  table.sums(img::ublas::fixed_vector<size_t, 3>(10, 10, 10), img::ublas::fixed_vector<size_t, 3>(50, 60, 70), moments);
+  img::float_t mean = moments[img::IntegralImage<3>::FIRST_MOMENT] / moments[img::IntegralImage<3>::VOLUME_MOMENT];
+  \endcode
+      
+      The table is built by one pass along each axis. The passes are parallelized if the table is configured for more than one thread (cf. set_n_threads()). Within each pass the values are accumulated by compensated (Kahan) summation, such that the rounding error of the table does not grow with the size of the image. Note that sums over small boxes in large images are computed as differences of large values and lose relative accuracy, which is more pronounced if \em T is \em float.
+      
+      The table has one more entry than the image along each axis. The additional entries are located at the lower boundary and are 0, such that no case distinctions are necessary for boxes at the boundary of the image.
+  */
+  template <std::size_t N, class T = float_t>
+  class IntegralImage
+  {
+    static const size_t BLOCK_WIDTH = 1024;
+    static const size_t GROUP_WIDTH = 32;
+    
+    std::vector<T> _table;
+    ublas::fixed_vector<size_t, N> _size;
+    size_t _n_channels;
+    // strides of the table in units of T
+    size_t _strides[N];
+    size_t _n_threads;
+    
+    void integrate(size_t axis);
+    
+  public:
+    /** The channels which are computed by compute_moments(). */
+    enum moments { VOLUME_MOMENT, FIRST_MOMENT, SECOND_MOMENT };
+    
+    /** The dimension of the table. */
+    static const std::size_t dimension = N;
+    
+    /** Constructs an empty table. */
+    explicit IntegralImage(size_t n_threads = 1) : _n_channels(0), _n_threads(n_threads > 0 ? n_threads : 1)
+    {
+      set_size(ublas::fixed_vector<size_t, N>(ublas::scalar_vector<size_t>(N, 0)), 0);
+    }
+    
+    /** Constructs a table for images of size \em size with \em n_channels channels. All entries are 0. */
+    IntegralImage(const ublas::fixed_vector<size_t, N> & size, size_t n_channels, size_t n_threads = 1) : _n_channels(0), _n_threads(n_threads > 0 ? n_threads : 1)
+    {
+      set_size(size, n_channels);
+    }
+    
+    /** Resizes the table to images of size \em size with \em n_channels channels and sets all entries to 0. */
+    void set_size(const ublas::fixed_vector<size_t, N> & size, size_t n_channels)
+    {
+      _size = size;
+      _n_channels = n_channels;
+      
+      size_t stride = n_channels;
+      
+      for(size_t i = N; i > 0; --i)
+      {
+        _strides[i - 1] = stride;
+        stride *= size(i - 1) + 1;
+      }
+      
+      _table.assign(stride, T(0));
+    }
+    
+    /** Returns the size of the image the table was computed for. */
+    const ublas::fixed_vector<size_t, N> & size() const { return _size; }
+    
+    /** Returns the number of channels. */
+    size_t n_channels() const { return _n_channels; }
+    
+    /** Returns the number of threads which are used to build the table. */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads which are used to build the table. If the library was compiled without OpenMP support, \em n_threads is ignored. */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    /** Copies the pixel values of \em image to the channel \em channel. The class \em image_t must implement ImageInterface and its size must equal size(). Call integrate() after all channels have been set. */
+    template <class image_t>
+    void set_channel(size_t channel, const image_t & image);
+    
+    /** Copies the pixel values of \em image to the channel \em channel. This overload reads the pixels of Image objects row by row from their storage. */
+    template <class DATA_t>
+    void set_channel(size_t channel, const Image<N, DATA_t> & image);
+    
+    /** Replaces the pixel values of all channels by their sums as described above. */
+    void integrate()
+    {
+      for(size_t i = 0; i < N; ++i)
+        integrate(i);
+    }
+    
+    /** Computes a table with a single channel which contains the sums of \em image. */
+    template <class image_t>
+    void compute(const image_t & image)
+    {
+      set_size(image.size(), 1);
+      set_channel(0, image);
+      integrate();
+    }
+    
+    /** Computes a table with the channels VOLUME_MOMENT, FIRST_MOMENT and SECOND_MOMENT which contain the sums of 1, \em image and the square of \em image, respectively. */
+    template <class image_t>
+    void compute_moments(const image_t & image);
+    
+    /** Returns the sum of the channel \em channel over the pixels \em x with <tt>lower(i) <= x(i) < upper(i)</tt>. Throws an Exception if the box is not contained in the image. */
+    float_t sum(const ublas::fixed_vector<size_t, N> & lower, const ublas::fixed_vector<size_t, N> & upper, size_t channel) const
+    {
+      if(channel >= _n_channels)
+        throw Exception("Exception: Invalid channel in IntegralImage::sum().");
+        
+      float_t result;
+      sums(lower, upper, &result, channel, channel + 1);
+      
+      return result;
+    }
+    
+    /** Computes the sums of all channels over the pixels \em x with <tt>lower(i) <= x(i) < upper(i)</tt> and stores them in \em results, which must provide space for n_channels() values. */
+    void sums(const ublas::fixed_vector<size_t, N> & lower, const ublas::fixed_vector<size_t, N> & upper, float_t * results) const
+    {
+      sums(lower, upper, results, 0, _n_channels);
+    }
+    
+    /** Computes the sums of the channels \em first_channel to <em>last_channel - 1</em> over the pixels \em x with <tt>lower(i) <= x(i) < upper(i)</tt> and stores them in \em results. */
+    void sums(const ublas::fixed_vector<size_t, N> & lower, const ublas::fixed_vector<size_t, N> & upper, float_t * results, size_t first_channel, size_t last_channel) const;
+    
+    /** Computes the range of pixels whose centres lie in \em box and stores it in \em lower and \em upper (cf. sums()). Pixel \em x covers the area between \em x and \em x + 1, i.e. its centre is located at \em x + 0.5. The range is clipped to the image. */
+    void pixel_range(const Box<N> & box, ublas::fixed_vector<size_t, N> & lower, ublas::fixed_vector<size_t, N> & upper) const
+    {
+      for(size_t i = 0; i < N; ++i)
+      {
+        float_t l = ceil(box.lower_corner()(i) - 0.5);
+        float_t u = ceil(box.upper_corner()(i) - 0.5);
+        float_t extent = float_t(_size(i));
+        
+        lower(i) = size_t(std::max(0.0, std::min(extent, l)));
+        upper(i) = size_t(std::max(float_t(lower(i)), std::min(extent, u)));
+      }
+    }
+    
+    /** Returns the sum of the channel \em channel over the pixels whose centres lie in \em box (cf. pixel_range()). */
+    float_t sum(const Box<N> & box, size_t channel) const
+    {
+      ublas::fixed_vector<size_t, N> lower, upper;
+      pixel_range(box, lower, upper);
+      
+      return sum(lower, upper, channel);
+    }
+    
+    /** Computes the sums of all channels over the pixels whose centres lie in \em box (cf. pixel_range()) and stores them in \em results. */
+    void sums(const Box<N> & box, float_t * results) const
+    {
+      ublas::fixed_vector<size_t, N> lower, upper;
+      pixel_range(box, lower, upper);
+      
+      sums(lower, upper, results);
+    }
+  };
+  
+  template <std::size_t N, class T>
+  const size_t IntegralImage<N, T>::BLOCK_WIDTH;
+  
+  template <std::size_t N, class T>
+  const size_t IntegralImage<N, T>::GROUP_WIDTH;
+  
+  template <std::size_t N, class T>
+  const std::size_t IntegralImage<N, T>::dimension;
+  
+  template <std::size_t N, class T>
+  template <class image_t>
+  void IntegralImage<N, T>::set_channel(size_t channel, const image_t & image)
+  {
+    if(image.size() != _size)
+      throw Exception("Exception: Dimensions in IntegralImage::set_channel() do not agree.");
+      
+    if(channel >= _n_channels)
+      throw Exception("Exception: Invalid channel in IntegralImage::set_channel().");
+      
+    for(size_t i = 0; i < N; ++i)
+      if(_size(i) == 0)
+        return;
+        
+    ublas::fixed_vector<size_t, N> index;
+    index.assign(0);
+    
+    do
+    {
+      size_t offset = channel;
+      
+      for(size_t i = 0; i < N; ++i)
+        offset += (index(i) + 1) * _strides[i];
+        
+      _table[offset] = T(image[index]);
+    }
+    while(increment_index(_size, index));
+  }
+  
+  template <std::size_t N, class T>
+  template <class DATA_t>
+  void IntegralImage<N, T>::set_channel(size_t channel, const Image<N, DATA_t> & image)
+  {
+    if(image.size() != _size)
+      throw Exception("Exception: Dimensions in IntegralImage::set_channel() do not agree.");
+      
+    if(channel >= _n_channels)
+      throw Exception("Exception: Invalid channel in IntegralImage::set_channel().");
+      
+    const size_t length = _size(N - 1);
+    
+    if(image.n_pixels() == 0)
+      return;
+      
+    const long n_rows = long(image.n_pixels() / length);
+    const DATA_t * data = image.data();
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long row = 0; row < n_rows; ++row)
+    {
+      // the offset of the second entry of the row in the table, the first one belongs to the lower boundary
+      size_t offset = channel + _strides[N - 1];
+      size_t r = size_t(row);
+      
+      for(size_t i = N - 1; i > 0; --i)
+      {
+        offset += (r % _size(i - 1) + 1) * _strides[i - 1];
+        r /= _size(i - 1);
+      }
+      
+      const DATA_t * source = data + size_t(row) * length;
+      T * target = &_table[offset];
+      
+      for(size_t n = 0; n < length; ++n)
+        target[n * _n_channels] = T(source[n]);
+    }
+  }
+  
+  template <std::size_t N, class T>
+  template <class image_t>
+  void IntegralImage<N, T>::compute_moments(const image_t & image)
+  {
+    set_size(image.size(), 3);
+    set_channel(FIRST_MOMENT, image);
+    
+    const long n_entries = long(_table.size() / 3);
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long i = 0; i < n_entries; ++i)
+    {
+      T * entry = &_table[3 * size_t(i)];
+      entry[SECOND_MOMENT] = entry[FIRST_MOMENT] * entry[FIRST_MOMENT];
+    }
+    
+    integrate();
+    
+    // the sum of 1 over the pixels below an entry is the product of its coordinates, which is stored exactly
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long i = 0; i < n_entries; ++i)
+    {
+      size_t e = size_t(i);
+      float_t volume = 1.0;
+      
+      for(size_t k = N; k > 0; --k)
+      {
+        volume *= float_t(e % (_size(k - 1) + 1));
+        e /= _size(k - 1) + 1;
+      }
+      
+      _table[3 * size_t(i) + VOLUME_MOMENT] = T(volume);
+    }
+  }
+  
+  template <std::size_t N, class T>
+  void IntegralImage<N, T>::integrate(size_t axis)
+  {
+    const size_t length = _size(axis) + 1;
+    // entries which belong to lines along axis are inner entries apart
+    const size_t inner = _strides[axis];
+    
+    if(inner == 0 || length < 2)
+      return;
+      
+    const size_t outer = _table.size() / (length * inner);
+    
+    // a block consists of up to BLOCK_WIDTH neighbouring lines which are summed row by row, if inner is small the
+    // lines of several outer indices are combined such that the latency of the compensated summation is hidden
+    const size_t n_inner_blocks = (inner + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+    const size_t n_outer_per_block = std::max(size_t(1), GROUP_WIDTH / inner);
+    const size_t n_outer_blocks = (outer + n_outer_per_block - 1) / n_outer_per_block;
+    const long n_blocks = long(n_outer_blocks * n_inner_blocks);
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long block = 0; block < n_blocks; ++block)
+    {
+      size_t o_begin = (size_t(block) / n_inner_blocks) * n_outer_per_block;
+      size_t o_end = std::min(outer, o_begin + n_outer_per_block);
+      size_t begin = (size_t(block) % n_inner_blocks) * BLOCK_WIDTH;
+      size_t inner_width = std::min(BLOCK_WIDTH, inner - begin);
+      T * lines = &_table[o_begin * length * inner + begin];
+      
+      size_t offsets[BLOCK_WIDTH];
+      float_t sum[BLOCK_WIDTH];
+      float_t compensation[BLOCK_WIDTH];
+      size_t width = 0;
+      
+      for(size_t o = 0; o < o_end - o_begin; ++o)
+        for(size_t j = 0; j < inner_width; ++j, ++width)
+        {
+          offsets[width] = o * length * inner + j;
+          sum[width] = float_t(lines[offsets[width]]);
+          compensation[width] = 0.0;
+        }
+      
+      for(size_t n = 1; n < length; ++n)
+      {
+        T * line = lines + n * inner;
+        
+        for(size_t j = 0; j < width; ++j)
+        {
+          float_t y = float_t(line[offsets[j]]) - compensation[j];
+          float_t t = sum[j] + y;
+          compensation[j] = (t - sum[j]) - y;
+          sum[j] = t;
+          line[offsets[j]] = T(t);
+        }
+      }
+    }
+  }
+  
+  template <std::size_t N, class T>
+  void IntegralImage<N, T>::sums(const ublas::fixed_vector<size_t, N> & lower, const ublas::fixed_vector<size_t, N> & upper, float_t * results, size_t first_channel, size_t last_channel) const
+  {
+    for(size_t i = 0; i < N; ++i)
+      if(lower(i) > upper(i) || upper(i) > _size(i))
+        throw Exception("Exception: Invalid box in IntegralImage::sums().");
+        
+    if(last_channel > _n_channels || first_channel > last_channel)
+      throw Exception("Exception: Invalid channels in IntegralImage::sums().");
+      
+    std::fill(results, results + (last_channel - first_channel), 0.0);
+    
+    // inclusion-exclusion over the corners of the box, the corner c takes the upper coordinate along axis i if bit i of c is set
+    for(size_t c = 0; c < (size_t(1) << N); ++c)
+    {
+      size_t offset = 0;
+      size_t n_lower = 0;
+      
+      for(size_t i = 0; i < N; ++i)
+      {
+        if((c >> i) & 1)
+          offset += upper(i) * _strides[i];
+        else
+        {
+          offset += lower(i) * _strides[i];
+          ++n_lower;
+        }
+      }
+      
+      const T * entry = &_table[offset];
+      
+      if(n_lower % 2 == 0)
+        for(size_t k = first_channel; k < last_channel; ++k)
+          results[k - first_channel] += float_t(entry[k]);
+      else
+        for(size_t k = first_channel; k < last_channel; ++k)
+          results[k - first_channel] -= float_t(entry[k]);
+    }
+  }
+}
+
+#endif
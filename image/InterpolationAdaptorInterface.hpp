@@ -20,6 +20,8 @@
 #ifndef IMAGE_INTERPOLATIONADAPTORINTERFACE_H
 #define IMAGE_INTERPOLATIONADAPTORINTERFACE_H
 
+#include <core/imaging2.hpp>
+
 // TODO: fix handling of images of size 1
 namespace imaging
 {
@@ -71,6 +73,9 @@ namespace imaging
   
   template <class image_t>
   class MeanInterpolationAdaptor;
+  
+  template <class image_t>
+  class BsplineInterpolationAdaptor;
 
   /** \ingroup image
       \brief Abstract base class of image interpolation function which provide pixel values in floating point coordinates.
@@ -85,6 +90,7 @@ namespace imaging
     friend class PolynomialInterpolationAdaptor<image_t>;
     friend class LinearInterpolationAdaptor<image_t>;
     friend class MeanInterpolationAdaptor<image_t>;
+    friend class BsplineInterpolationAdaptor<image_t>;
     
     const image_t & _image_reference;
   
@@ -0,0 +1,215 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGE_MAPPEDIMAGE_H
+#define IMAGE_MAPPEDIMAGE_H
+
+#include <image/ImageInterface.hpp>
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/type_traits/alignment_of.hpp>
+
+namespace imaging
+{
+  /** \ingroup image
+      \brief Image whose data is mapped from a file into memory.
+      
+      This class implements ImageInterface for images which are stored in raw volume files (cf. ImageFileReader). The file is mapped into the address space of the process by \em mmap() and the pixels are accessed directly in the mapped memory, i.e. no image data is read or copied upon construction. Pages are loaded by the operating system when they are accessed for the first time and are shared with all other processes which map the same file. This makes MappedImage suitable for large 3-dimensional volumes. Since MappedImage implements ImageInterface it can be passed to accessors such as CastAccessor and to algorithms such as PolynomialInterpolationAdaptor or Image2Grid::image2vector():
+      
+  \code
+  img::MappedImage<3, float> volume("volume.raw");
+  img::CastAccessor<img::MappedImage<3, float>, img::float_t> accessor(volume);
+  img::PolynomialInterpolationAdaptor<img::CastAccessor<img::MappedImage<3, float>, img::float_t> > interpolator(accessor);
+  \endcode
+      
+      The file starts with the width, height and depth of the image as 32-bit unsigned little endian integers, followed by the pixels with the <em>x</em>-coordinate running fastest. 2-dimensional images are stored with depth 1. The pixels are stored in the binary representation of \em DATA_t in the byte order of the host. Files of this format are written by Image::write_image() for the suffix <tt>.raw</tt> if \em DATA_t is <em>unsigned char</em>, <em>unsigned short</em> or \em float (on little endian hosts). Because the pixel data starts 12 bytes after the beginning of the file, the alignment of \em DATA_t must not be larger than 4 bytes.
+      
+      The file can be mapped in two modes:
+        - READ_ONLY: The mapped memory is write protected. Writing to a pixel is an error and terminates the program.
+        - COPY_ON_WRITE: Pixels can be written. The modified pages are copied upon the first write access and the changes are not written back to the file.
+        
+      The dimension \em N must be 2 or 3.
+  */
+  template <std::size_t N, class DATA_t>
+  class MappedImage : public ImageInterface<N, DATA_t>
+  {
+  public:
+    static const std::size_t dimension = N;
+    typedef DATA_t data_t;
+    
+    /** The modes of the memory mapping. */
+    enum map_modes { READ_ONLY, COPY_ON_WRITE };
+    
+  private:
+    static const size_t HEADER_SIZE = 3 * sizeof(uint32_t);
+    
+    int _file_descriptor;
+    void * _mapping;
+    size_t _mapping_size;
+    DATA_t * _data;
+    map_modes _mode;
+    ublas::fixed_vector<size_t, dimension> _size;
+    ublas::fixed_vector<size_t, dimension> _strides;
+    
+    MappedImage(const MappedImage<N, DATA_t> &);
+    MappedImage<N, DATA_t> & operator=(const MappedImage<N, DATA_t> &);
+    
+    void map_file(const std::string & file_name);
+    void unmap_file();
+    
+    size_t offset(const ublas::fixed_vector<size_t, dimension> & index) const
+    {
+      size_t result = index(0);
+      
+      for(size_t i = 1; i < N; ++i)
+        result += index(i) * _strides(i);
+        
+      return result;
+    }
+    
+  public:
+    /** Maps the file \em file_name into memory. Throws a FileIoException if the file can not be opened or mapped or if its size does not agree with the dimensions in its header. */
+    explicit MappedImage(const std::string & file_name, map_modes mode = READ_ONLY);
+    
+    /** Unmaps the file. */
+    ~MappedImage() { unmap_file(); }
+    
+    const DATA_t & operator[](const ublas::fixed_vector<size_t, dimension> & index) const { return _data[offset(index)]; }
+    
+    DATA_t & operator[](const ublas::fixed_vector<size_t, dimension> & index) { return _data[offset(index)]; }
+    
+    const ublas::fixed_vector<size_t, dimension> & size() const { return _size; }
+    
+    /** Returns the number of pixels of the image. */
+    size_t n_pixels() const { return _strides(N - 1) * _size(N - 1); }
+    
+    /** Returns the mode of the memory mapping. */
+    map_modes mode() const { return _mode; }
+    
+    /** Returns a pointer to the first pixel of the image. The pixels are stored with the <em>x</em>-coordinate running fastest. */
+    const DATA_t * data() const { return _data; }
+    
+    /** Returns a pointer to the first pixel of the image. Writing to the image is only allowed if it was mapped in the mode COPY_ON_WRITE. */
+    DATA_t * data() { return _data; }
+    
+    /** Returns the distance (in pixels) between two pixels whose indices differ by 1 in the <em>i</em>-th component. */
+    size_t stride(size_t i) const { return _strides(i); }
+    
+    /** Advises the operating system that the whole image will be accessed soon. The pages of the file are then read ahead in the background. */
+    void prefetch() const
+    {
+      if(_mapping)
+        madvise(_mapping, _mapping_size, MADV_WILLNEED);
+    }
+  };
+  
+  template <std::size_t N, class DATA_t>
+  MappedImage<N, DATA_t>::MappedImage(const std::string & file_name, map_modes mode) :
+    _file_descriptor(-1), _mapping(0), _mapping_size(0), _data(0), _mode(mode)
+  {
+    if(N != 2 && N != 3)
+      throw Exception("Exception: Only 2- and 3-dimensional images can be mapped in MappedImage::MappedImage().");
+      
+    if(HEADER_SIZE % boost::alignment_of<DATA_t>::value != 0)
+      throw Exception("Exception: The alignment of the pixel type is too large in MappedImage::MappedImage().");
+      
+    try
+    {
+      map_file(file_name);
+    }
+    catch(Exception &)
+    {
+      unmap_file();
+      throw;
+    }
+  }
+  
+  template <std::size_t N, class DATA_t>
+  void MappedImage<N, DATA_t>::map_file(const std::string & file_name)
+  {
+    _file_descriptor = open(file_name.c_str(), O_RDONLY);
+    
+    if(_file_descriptor < 0)
+      throw FileIoException("FileIoException: Could not open file '" + file_name + "' in MappedImage::MappedImage().");
+      
+    struct stat file_status;
+    
+    if(fstat(_file_descriptor, &file_status) != 0)
+      throw FileIoException("FileIoException: Could not determine the size of file '" + file_name + "' in MappedImage::MappedImage().");
+      
+    _mapping_size = size_t(file_status.st_size);
+    
+    if(_mapping_size < HEADER_SIZE)
+      throw FileIoException("FileIoException: File '" + file_name + "' too short in MappedImage::MappedImage().");
+    
+    int protection = _mode == READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags = _mode == READ_ONLY ? MAP_SHARED : MAP_PRIVATE;
+    
+    _mapping = mmap(0, _mapping_size, protection, flags, _file_descriptor, 0);
+    
+    if(_mapping == MAP_FAILED)
+    {
+      _mapping = 0;
+      throw FileIoException("FileIoException: Could not map file '" + file_name + "' in MappedImage::MappedImage().");
+    }
+    
+    const unsigned char * header = static_cast<const unsigned char *>(_mapping);
+    ublas::fixed_vector<size_t, 3> file_size;
+    
+    for(size_t i = 0; i < 3; ++i)
+      file_size(i) = size_t(header[4 * i]) | (size_t(header[4 * i + 1]) << 8) | (size_t(header[4 * i + 2]) << 16) | (size_t(header[4 * i + 3]) << 24);
+      
+    if(N == 2 && file_size(2) != 1)
+      throw FileIoException("FileIoException: Can not map the volume '" + file_name + "' to a 2-dimensional image in MappedImage::MappedImage().");
+      
+    size_t n_pixels = 1;
+    
+    for(size_t i = 0; i < N; ++i)
+    {
+      _size(i) = file_size(i);
+      _strides(i) = n_pixels;
+      n_pixels *= _size(i);
+    }
+    
+    if(_mapping_size != HEADER_SIZE + n_pixels * sizeof(DATA_t))
+      throw FileIoException("FileIoException: Size of file '" + file_name + "' does not match its dimensions in MappedImage::MappedImage().");
+      
+    _data = reinterpret_cast<DATA_t *>(static_cast<unsigned char *>(_mapping) + HEADER_SIZE);
+  }
+  
+  template <std::size_t N, class DATA_t>
+  void MappedImage<N, DATA_t>::unmap_file()
+  {
+    if(_mapping)
+      munmap(_mapping, _mapping_size);
+      
+    if(_file_descriptor >= 0)
+      close(_file_descriptor);
+      
+    _mapping = 0;
+    _file_descriptor = -1;
+    _data = 0;
+  }
+}
+
+#endif
@@ -21,17 +21,24 @@
 #define IMAGE_POLYNOMIALINTERPOLATIONADAPTOR_H
 
 #include <image/InterpolationAdaptorInterface.hpp>
+#include <image/Image.hpp>
 #include <core/utilities.hpp>
 
 
 namespace imaging
 {
+  template <std::size_t N, class DATA_t> class MappedImage;
+  
   namespace polynomial_interpolation_adaptor_impl
   {
     template <class image_t>
     typename image_t::data_t interpolate_1d(const image_t & image_reference, const ublas::fixed_vector<size_t, 1> & base_coordinates, const ublas::fixed_vector<float_t, 1> & truncated_coordinates)
     {
-      return typename image_t::data_t(0.0); // TODO: implement function
+      ublas::fixed_vector<size_t, 1> next_coordinates(base_coordinates);
+      next_coordinates(0) += 1;
+      
+      return (1.0 - truncated_coordinates(0)) * image_reference[base_coordinates] +
+             truncated_coordinates(0) * image_reference[next_coordinates];
     }
     
     template <class image_t>
@@ -63,7 +70,12 @@ namespace imaging
     
     template <class image_t, class result_t>
     void interpolate_gradient_1d(const image_t & image_reference, const ublas::fixed_vector<size_t, 1> & base_coordinates, const ublas::fixed_vector<float_t, 1> & truncated_coordinates, result_t & value)
-    {}
+    {
+      ublas::fixed_vector<size_t, 1> next_coordinates(base_coordinates);
+      next_coordinates(0) += 1;
+      
+      value(0) = image_reference[next_coordinates] - image_reference[base_coordinates];
+    }
     
     template <class image_t, class result_t>
     void interpolate_gradient_2d(const image_t & image_reference, const ublas::fixed_vector<size_t, 2> & base_coordinates, const ublas::fixed_vector<float_t, 2> & truncated_coordinates, result_t & value)
@@ -104,6 +116,308 @@ namespace imaging
             image_reference[base_coordinates + ublas::fixed_vector<size_t, 3>(i, j, k)];  
           }
     } 
+    
+    // calls interpolate_Nd() and interpolate_gradient_Nd() for the dimension N
+    template <size_t N>
+    class dimension_dispatch
+    {
+    public:
+      template <class image_t>
+      static typename image_t::data_t interpolate(const image_t &, const ublas::fixed_vector<size_t, N> &, const ublas::fixed_vector<float_t, N> &)
+      {
+        throw Exception("Exception: PolynomialInterpolationAdaptor not implemented for image dimension " + boost::lexical_cast<std::string>(N) + ".");
+      }
+      
+      template <class image_t, class result_t>
+      static void interpolate_gradient(const image_t &, const ublas::fixed_vector<size_t, N> &, const ublas::fixed_vector<float_t, N> &, result_t &)
+      {
+        throw Exception("Exception: PolynomialInterpolationAdaptor not implemented for image dimension " + boost::lexical_cast<std::string>(N) + ".");
+      }
+    };
+    
+    template <>
+    class dimension_dispatch<1>
+    {
+    public:
+      template <class image_t>
+      static typename image_t::data_t interpolate(const image_t & image, const ublas::fixed_vector<size_t, 1> & base, const ublas::fixed_vector<float_t, 1> & truncated)
+      { return interpolate_1d(image, base, truncated); }
+      
+      template <class image_t, class result_t>
+      static void interpolate_gradient(const image_t & image, const ublas::fixed_vector<size_t, 1> & base, const ublas::fixed_vector<float_t, 1> & truncated, result_t & value)
+      { interpolate_gradient_1d(image, base, truncated, value); }
+    };
+    
+    template <>
+    class dimension_dispatch<2>
+    {
+    public:
+      template <class image_t>
+      static typename image_t::data_t interpolate(const image_t & image, const ublas::fixed_vector<size_t, 2> & base, const ublas::fixed_vector<float_t, 2> & truncated)
+      { return interpolate_2d(image, base, truncated); }
+      
+      template <class image_t, class result_t>
+      static void interpolate_gradient(const image_t & image, const ublas::fixed_vector<size_t, 2> & base, const ublas::fixed_vector<float_t, 2> & truncated, result_t & value)
+      { interpolate_gradient_2d(image, base, truncated, value); }
+    };
+    
+    template <>
+    class dimension_dispatch<3>
+    {
+    public:
+      template <class image_t>
+      static typename image_t::data_t interpolate(const image_t & image, const ublas::fixed_vector<size_t, 3> & base, const ublas::fixed_vector<float_t, 3> & truncated)
+      { return interpolate_3d(image, base, truncated); }
+      
+      template <class image_t, class result_t>
+      static void interpolate_gradient(const image_t & image, const ublas::fixed_vector<size_t, 3> & base, const ublas::fixed_vector<float_t, 3> & truncated, result_t & value)
+      { interpolate_gradient_3d(image, base, truncated, value); }
+    };
+    
+    // reads the 2^N corner values of a cell through the pixel accessor of an arbitrary image
+    template <class image_t>
+    class accessor_reader
+    {
+      static const size_t N = image_t::dimension;
+      const image_t & _image;
+      
+    public:
+      accessor_reader(const image_t & image) : _image(image) {}
+      
+      void corners(const size_t * base, float_t * values) const
+      {
+        ublas::fixed_vector<size_t, N> index;
+        
+        for(size_t c = 0; c < (size_t(1) << N); ++c)
+        {
+          for(size_t i = 0; i < N; ++i)
+            index(i) = base[i] + ((c >> i) & 1);
+            
+          values[c] = float_t(_image[index]);
+        }
+      }
+    };
+    
+    // reads the corner values of a cell directly from the linear storage of Image and MappedImage
+    template <size_t N, class DATA_t>
+    class linear_reader
+    {
+      const DATA_t * _data;
+      size_t _strides[N];
+      size_t _corner_offsets[size_t(1) << N];
+      
+    public:
+      linear_reader(const DATA_t * data, const size_t * strides) : _data(data)
+      {
+        for(size_t i = 0; i < N; ++i)
+          _strides[i] = strides[i];
+          
+        for(size_t c = 0; c < (size_t(1) << N); ++c)
+        {
+          _corner_offsets[c] = 0;
+          
+          for(size_t i = 0; i < N; ++i)
+            _corner_offsets[c] += ((c >> i) & 1) * _strides[i];
+        }
+      }
+      
+      void corners(const size_t * base, float_t * values) const
+      {
+        size_t offset = 0;
+        
+        for(size_t i = 0; i < N; ++i)
+          offset += base[i] * _strides[i];
+          
+        const DATA_t * data = _data + offset;
+        
+        for(size_t c = 0; c < (size_t(1) << N); ++c)
+          values[c] = float_t(data[_corner_offsets[c]]);
+      }
+    };
+    
+    // computes the base pixel and the local coordinates of a position, returns false if it is outside of the image
+    // (cf. interpolation_adaptor_impl::offset_position() and interpolation_adaptor_impl::compute_local_coordinates())
+    template <size_t N, class coordinate_t>
+    bool cell_coordinates(const coordinate_t * position, const size_t * size, size_t * base, float_t * truncated)
+    {
+      for(size_t i = 0; i < N; ++i)
+      {
+        float_t p = float_t(position[i]);
+        float_t extent = float_t(size[i]);
+        
+        if(p < 0.0 || p >= extent || size[i] < 2)
+          return false;
+          
+        float_t local = p <= 0.5 ? 0.0 : (p >= extent - 0.5 ? extent - 1.0 : p - 0.5);
+        
+        base[i] = size_t(long(local));
+        truncated[i] = local - float_t(base[i]);
+        
+        if(base[i] == size[i] - 1)
+        {
+          base[i]--;
+          truncated[i] = 1.0;
+        }
+      }
+      
+      return true;
+    }
+    
+    template <size_t N, class reader_t, class coordinate_t, class result_t>
+    void interpolate_batch(const reader_t & reader, const size_t * size, const coordinate_t * positions, size_t n_points, result_t * values)
+    {
+      size_t base[N];
+      float_t truncated[N];
+      float_t corners[size_t(1) << N];
+      
+      for(size_t p = 0; p < n_points; ++p)
+      {
+        if(! cell_coordinates<N>(positions + p * N, size, base, truncated))
+        {
+          values[p] = result_t(0);
+          continue;
+        }
+        
+        reader.corners(base, corners);
+        
+        // collapse the cell along one axis after the other
+        for(size_t i = 0; i < N; ++i)
+        {
+          const size_t half = size_t(1) << (N - 1 - i);
+          
+          for(size_t c = 0; c < half; ++c)
+            corners[c] = (1.0 - truncated[i]) * corners[2 * c] + truncated[i] * corners[2 * c + 1];
+        }
+        
+        values[p] = result_t(corners[0]);
+      }
+    }
+    
+    template <size_t N, class reader_t, class coordinate_t, class result_t>
+    void interpolate_gradient_batch(const reader_t & reader, const size_t * size, const coordinate_t * positions, size_t n_points, result_t * gradients)
+    {
+      size_t base[N];
+      float_t truncated[N];
+      float_t corners[size_t(1) << N];
+      
+      for(size_t p = 0; p < n_points; ++p)
+      {
+        result_t * gradient = gradients + p * N;
+        
+        if(! cell_coordinates<N>(positions + p * N, size, base, truncated))
+        {
+          for(size_t j = 0; j < N; ++j)
+            gradient[j] = result_t(0);
+          continue;
+        }
+        
+        reader.corners(base, corners);
+        
+        // collapse the cell along each axis, the j-th axis by a difference and all others by interpolation
+        for(size_t j = 0; j < N; ++j)
+        {
+          float_t values[size_t(1) << N];
+          
+          for(size_t c = 0; c < (size_t(1) << N); ++c)
+            values[c] = corners[c];
+          
+          for(size_t i = 0; i < N; ++i)
+          {
+            const size_t half = size_t(1) << (N - 1 - i);
+            
+            if(i == j)
+              for(size_t c = 0; c < half; ++c)
+                values[c] = values[2 * c + 1] - values[2 * c];
+            else
+              for(size_t c = 0; c < half; ++c)
+                values[c] = (1.0 - truncated[i]) * values[2 * c] + truncated[i] * values[2 * c + 1];
+          }
+          
+          gradient[j] = result_t(values[0]);
+        }
+      }
+    }
+    
+    // selects the fastest reader for image_t
+    template <class image_t, class coordinate_t, class result_t>
+    void interpolate_batch(const image_t & image, const coordinate_t * positions, size_t n_points, result_t * values)
+    {
+      const size_t N = image_t::dimension;
+      size_t size[N];
+      
+      for(size_t i = 0; i < N; ++i)
+        size[i] = image.size()(i);
+        
+      interpolate_batch<N>(accessor_reader<image_t>(image), size, positions, n_points, values);
+    }
+    
+    template <size_t N, class DATA_t, class coordinate_t, class result_t>
+    void interpolate_batch(const Image<N, DATA_t> & image, const coordinate_t * positions, size_t n_points, result_t * values)
+    {
+      size_t size[N], strides[N];
+      
+      for(size_t i = 0; i < N; ++i)
+      {
+        size[i] = image.size()(i);
+        strides[i] = image.strides()[i];
+      }
+        
+      interpolate_batch<N>(linear_reader<N, DATA_t>(image.data(), strides), size, positions, n_points, values);
+    }
+    
+    template <size_t N, class DATA_t, class coordinate_t, class result_t>
+    void interpolate_batch(const MappedImage<N, DATA_t> & image, const coordinate_t * positions, size_t n_points, result_t * values)
+    {
+      size_t size[N], strides[N];
+      
+      for(size_t i = 0; i < N; ++i)
+      {
+        size[i] = image.size()(i);
+        strides[i] = image.stride(i);
+      }
+        
+      interpolate_batch<N>(linear_reader<N, DATA_t>(image.data(), strides), size, positions, n_points, values);
+    }
+    
+    template <class image_t, class coordinate_t, class result_t>
+    void interpolate_gradient_batch(const image_t & image, const coordinate_t * positions, size_t n_points, result_t * gradients)
+    {
+      const size_t N = image_t::dimension;
+      size_t size[N];
+      
+      for(size_t i = 0; i < N; ++i)
+        size[i] = image.size()(i);
+        
+      interpolate_gradient_batch<N>(accessor_reader<image_t>(image), size, positions, n_points, gradients);
+    }
+    
+    template <size_t N, class DATA_t, class coordinate_t, class result_t>
+    void interpolate_gradient_batch(const Image<N, DATA_t> & image, const coordinate_t * positions, size_t n_points, result_t * gradients)
+    {
+      size_t size[N], strides[N];
+      
+      for(size_t i = 0; i < N; ++i)
+      {
+        size[i] = image.size()(i);
+        strides[i] = image.strides()[i];
+      }
+        
+      interpolate_gradient_batch<N>(linear_reader<N, DATA_t>(image.data(), strides), size, positions, n_points, gradients);
+    }
+    
+    template <size_t N, class DATA_t, class coordinate_t, class result_t>
+    void interpolate_gradient_batch(const MappedImage<N, DATA_t> & image, const coordinate_t * positions, size_t n_points, result_t * gradients)
+    {
+      size_t size[N], strides[N];
+      
+      for(size_t i = 0; i < N; ++i)
+      {
+        size[i] = image.size()(i);
+        strides[i] = image.stride(i);
+      }
+        
+      interpolate_gradient_batch<N>(linear_reader<N, DATA_t>(image.data(), strides), size, positions, n_points, gradients);
+    }
   }
   
   
@@ -111,75 +425,68 @@ namespace imaging
       \brief Polynomial interpolation of image values at floating point coordinates.
       
       This class provides a pixel accessor [] for real valued pixel coordinates via multilinear interpolation of the surrounding pixels.
-      For planar images this mean bilinear interpolation and for volume data trilinear interpolation.
+      For 1-dimensional images this means linear interpolation, for planar images bilinear interpolation and for volume data trilinear interpolation.
+      
+      All member functions are const and do not modify the adaptor. Thus one adaptor can be used by several threads at the same time. To interpolate many points at once use interpolate() and interpolate_gradients(), which process arrays of coordinates. They avoid the construction of temporary index vectors for each point and read the pixels of Image and MappedImage objects directly from their storage. These functions require that \em image_t::data_t can be converted to \em float_t.
   */
   template <class image_t>
   class PolynomialInterpolationAdaptor : public InterpolationAdaptorInterface<image_t>
   {
+    static const size_t N = image_t::dimension;
+    
   public:
     /** Constructs a PolynomialInterpolationAdaptor object from \em image_reference. The class \em image_t must implement ImageInterface. */
     PolynomialInterpolationAdaptor(const image_t & image_reference) : InterpolationAdaptorInterface<image_t>(image_reference)
     {}
     
-    typename InterpolationAdaptorInterface<image_t>::data_t operator[](const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index)
+    typename InterpolationAdaptorInterface<image_t>::data_t operator[](const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index) const
     {
-      ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> local_index;
+      ublas::fixed_vector<float_t, N> local_index;
       if( ! interpolation_adaptor_impl::offset_position(InterpolationAdaptorInterface<image_t>::size(), index, local_index))
       {
         return typename InterpolationAdaptorInterface<image_t>::data_t(0);
       }
       
-      ublas::fixed_vector<size_t, InterpolationAdaptorInterface<image_t>::dimension> base_coordinates;
-      ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> truncated_coordinates;
+      ublas::fixed_vector<size_t, N> base_coordinates;
+      ublas::fixed_vector<float_t, N> truncated_coordinates;
       
       interpolation_adaptor_impl::compute_local_coordinates(local_index, InterpolationAdaptorInterface<image_t>::_image_reference.size(), base_coordinates, truncated_coordinates);
           
-      switch(InterpolationAdaptorInterface<image_t>::dimension)
-      {
-        case 1:
-          return polynomial_interpolation_adaptor_impl::interpolate_1d(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates);
-        case 2:
-          return polynomial_interpolation_adaptor_impl::interpolate_2d(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates);
-        case 3:
-          return polynomial_interpolation_adaptor_impl::interpolate_3d(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates);
-          
-        default:
-          throw Exception("Exception: PolynomialInterpolationAdaptor not implemented for image dimension " + boost::lexical_cast<std::string>(InterpolationAdaptorInterface<image_t>::dimension) + ".");
-      }
+      return polynomial_interpolation_adaptor_impl::dimension_dispatch<N>::interpolate(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates);
     }
     
     /** Computes the gradient of the interpolation at the position \em index of the surrounding pixel values and stores it in \em value. */
-    void gradient (const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index, ublas::fixed_vector<typename InterpolationAdaptorInterface<image_t>::data_t, InterpolationAdaptorInterface<image_t>::dimension> & value)
+    void gradient (const ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> & index, ublas::fixed_vector<typename InterpolationAdaptorInterface<image_t>::data_t, InterpolationAdaptorInterface<image_t>::dimension> & value) const
     {
       typedef ublas::fixed_vector<typename InterpolationAdaptorInterface<image_t>::data_t, InterpolationAdaptorInterface<image_t>::dimension> return_data_t;
       
-      ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> local_index;
+      ublas::fixed_vector<float_t, N> local_index;
       if( ! interpolation_adaptor_impl::offset_position(InterpolationAdaptorInterface<image_t>::size(), index, local_index))
       {
         value = return_data_t(0);
         return;
       }
       
-      ublas::fixed_vector<size_t, InterpolationAdaptorInterface<image_t>::dimension> base_coordinates;
-      ublas::fixed_vector<float_t, InterpolationAdaptorInterface<image_t>::dimension> truncated_coordinates;
+      ublas::fixed_vector<size_t, N> base_coordinates;
+      ublas::fixed_vector<float_t, N> truncated_coordinates;
       
       interpolation_adaptor_impl::compute_local_coordinates(local_index, InterpolationAdaptorInterface<image_t>::_image_reference.size(), base_coordinates, truncated_coordinates);
       
-      switch(InterpolationAdaptorInterface<image_t>::dimension)
-      {
-        case 1:
-          polynomial_interpolation_adaptor_impl::interpolate_gradient_1d(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates, value);
-          break;
-        case 2:
-          polynomial_interpolation_adaptor_impl::interpolate_gradient_2d(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates, value);
-          break;
-        case 3:
-          polynomial_interpolation_adaptor_impl::interpolate_gradient_3d(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates, value);
-          break;
-          
-        default:
-          throw Exception("Exception: LinearInterpolationAdaptor not implemented for image dimension " + boost::lexical_cast<std::string>(InterpolationAdaptorInterface<image_t>::dimension) + ".");
-      }
+      polynomial_interpolation_adaptor_impl::dimension_dispatch<N>::interpolate_gradient(InterpolationAdaptorInterface<image_t>::_image_reference, base_coordinates, truncated_coordinates, value);
+    }
+    
+    /** Interpolates the image at \em n_points positions and stores the results in \em values. The coordinates of the <em>i</em>-th position are stored at <tt>positions[i * N]</tt> to <tt>positions[i * N + N - 1]</tt>, where \em N is the dimension of the image. The array \em values must provide space for \em n_points values. The coordinates can be of any floating point type. The results equal those of operator[](), in particular positions outside the image are interpolated as 0. */
+    template <class coordinate_t, class result_t>
+    void interpolate(const coordinate_t * positions, size_t n_points, result_t * values) const
+    {
+      polynomial_interpolation_adaptor_impl::interpolate_batch(InterpolationAdaptorInterface<image_t>::_image_reference, positions, n_points, values);
+    }
+    
+    /** Computes the gradients of the interpolation at \em n_points positions (cf. interpolate()). The gradient at the <em>i</em>-th position is stored at <tt>gradients[i * N]</tt> to <tt>gradients[i * N + N - 1]</tt>. The results equal those of gradient(). */
+    template <class coordinate_t, class result_t>
+    void interpolate_gradients(const coordinate_t * positions, size_t n_points, result_t * gradients) const
+    {
+      polynomial_interpolation_adaptor_impl::interpolate_gradient_batch(InterpolationAdaptorInterface<image_t>::_image_reference, positions, n_points, gradients);
     }
   };
 }
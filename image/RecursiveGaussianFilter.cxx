@@ -0,0 +1,134 @@
+#include <image/RecursiveGaussianFilter.hpp>
+
+#include <core/utilities.hpp>
+
+
+namespace imaging
+{
+  const size_t RecursiveGaussianFilter::BLOCK_WIDTH;
+  
+  RecursiveGaussianFilter::RecursiveGaussianFilter(float_t sigma, size_t n_threads) :
+    _sigma(sigma), _n_threads(n_threads > 0 ? n_threads : 1)
+  {
+    if(sigma < 0.5)
+      throw Exception("Exception: Standard deviation must be at least 0.5 in RecursiveGaussianFilter::RecursiveGaussianFilter().");
+      
+    // coefficients of Young and van Vliet
+    float_t q;
+    
+    if(sigma >= 2.5)
+      q = 0.98711 * sigma - 0.96330;
+    else
+      q = 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * sigma);
+      
+    float_t b_0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    
+    _a[0] = (2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q) / b_0;
+    _a[1] = -(1.4281 * q * q + 1.26661 * q * q * q) / b_0;
+    _a[2] = 0.422205 * q * q * q / b_0;
+    _b = 1.0 - _a[0] - _a[1] - _a[2];
+    
+    compute_boundary_matrix();
+  }
+  
+  void RecursiveGaussianFilter::compute_boundary_matrix()
+  {
+    // Beyond the end of a line the input equals its last value u. The deviations e of the causal filter from u decay
+    // according to the homogeneous recursion and the deviations d of the anti-causal filter from u are the anti-causal
+    // filter applied to e. The matrix maps the last three deviations of the causal filter to the first three deviations
+    // of the anti-causal filter beyond the end of the line. It is computed by running both recursions until the
+    // deviations have decayed.
+    for(size_t k = 0; k < 3; ++k)
+    {
+      std::vector<float_t> e;
+      float_t e_1 = k == 0 ? 1.0 : 0.0;
+      float_t e_2 = k == 1 ? 1.0 : 0.0;
+      float_t e_3 = k == 2 ? 1.0 : 0.0;
+      
+      while(e.size() < 3 || fabs(e_1) + fabs(e_2) + fabs(e_3) > 1e-18)
+      {
+        float_t e_0 = _a[0] * e_1 + _a[1] * e_2 + _a[2] * e_3;
+        e.push_back(e_0);
+        e_3 = e_2;
+        e_2 = e_1;
+        e_1 = e_0;
+      }
+      
+      float_t d_1 = 0.0, d_2 = 0.0, d_3 = 0.0;
+      
+      for(size_t n = e.size(); n > 0; --n)
+      {
+        float_t d_0 = _b * e[n - 1] + _a[0] * d_1 + _a[1] * d_2 + _a[2] * d_3;
+        d_3 = d_2;
+        d_2 = d_1;
+        d_1 = d_0;
+      }
+      
+      _boundary_matrix[0][k] = d_1;
+      _boundary_matrix[1][k] = d_2;
+      _boundary_matrix[2][k] = d_3;
+    }
+  }
+  
+  void RecursiveGaussianFilter::filter_lines(float_t * lines, size_t length, size_t width, size_t stride) const
+  {
+    if(width > BLOCK_WIDTH)
+    {
+      for(size_t begin = 0; begin < width; begin += BLOCK_WIDTH)
+        filter_lines(lines + begin, length, std::min(BLOCK_WIDTH, width - begin), stride);
+        
+      return;
+    }
+    
+    if(length == 0)
+      return;
+      
+    const float_t b = _b, a_0 = _a[0], a_1 = _a[1], a_2 = _a[2];
+    float_t u[BLOCK_WIDTH], y_1[BLOCK_WIDTH], y_2[BLOCK_WIDTH], y_3[BLOCK_WIDTH];
+    
+    // causal pass, the image is extended by its first value
+    for(size_t j = 0; j < width; ++j)
+    {
+      u[j] = lines[(length - 1) * stride + j];
+      y_1[j] = y_2[j] = y_3[j] = lines[j];
+    }
+    
+    for(size_t n = 0; n < length; ++n)
+    {
+      float_t * line = lines + n * stride;
+      
+      for(size_t j = 0; j < width; ++j)
+      {
+        float_t y_0 = b * line[j] + a_0 * y_1[j] + a_1 * y_2[j] + a_2 * y_3[j];
+        line[j] = y_0;
+        y_3[j] = y_2[j];
+        y_2[j] = y_1[j];
+        y_1[j] = y_0;
+      }
+    }
+    
+    // anti-causal pass, initialized by the response to the image extended by its last value (Triggs and Sdika)
+    for(size_t j = 0; j < width; ++j)
+    {
+      float_t e_1 = y_1[j] - u[j], e_2 = y_2[j] - u[j], e_3 = y_3[j] - u[j];
+      
+      y_1[j] = u[j] + _boundary_matrix[0][0] * e_1 + _boundary_matrix[0][1] * e_2 + _boundary_matrix[0][2] * e_3;
+      y_2[j] = u[j] + _boundary_matrix[1][0] * e_1 + _boundary_matrix[1][1] * e_2 + _boundary_matrix[1][2] * e_3;
+      y_3[j] = u[j] + _boundary_matrix[2][0] * e_1 + _boundary_matrix[2][1] * e_2 + _boundary_matrix[2][2] * e_3;
+    }
+    
+    for(size_t n = length; n > 0; --n)
+    {
+      float_t * line = lines + (n - 1) * stride;
+      
+      for(size_t j = 0; j < width; ++j)
+      {
+        float_t y_0 = b * line[j] + a_0 * y_1[j] + a_1 * y_2[j] + a_2 * y_3[j];
+        line[j] = y_0;
+        y_3[j] = y_2[j];
+        y_2[j] = y_1[j];
+        y_1[j] = y_0;
+      }
+    }
+  }
+}
@@ -0,0 +1,152 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGE_RECURSIVEGAUSSIANFILTER_H
+#define IMAGE_RECURSIVEGAUSSIANFILTER_H
+
+#include <image/Image.hpp>
+
+#include <vector>
+#include <algorithm>
+
+namespace imaging
+{
+  /** \ingroup image
+      \brief Recursive approximation of the convolution with a Gaussian kernel.
+      
+      This class convolves images of arbitrary dimension with a Gaussian kernel of standard deviation sigma() (in pixels). The Gaussian is approximated by the recursive filter of Young and van Vliet, which consists of a causal and an anti-causal third order IIR filter. Each pixel is visited twice per axis and the number of operations per pixel does not depend on sigma(). The image is extended by its boundary values (i.e. the derivative normal to the boundary is zero). The boundary values of the anti-causal pass are initialized as proposed by Triggs and Sdika, such that the result equals the filtered infinitely extended image.
+      
+      The filter is applied separately along each axis. Lines along an axis are filtered in blocks of neighbouring lines, which allows the compiler to vectorize the loops across the lines of a block. Different blocks are processed in parallel if the filter is configured for more than one thread (cf. set_n_threads()).
+      
+  \code
+  img::Image<3, img::float_t> volume("volume.raw");
+  img::RecursiveGaussianFilter filter(2.0);
+  filter.apply(volume);
+  \endcode
+      
+      The deviation from the exact convolution is about 1% of the image contrast for sigma() >= 3 and somewhat larger for smaller standard deviations. sigma() must be at least 0.5.
+  */
+  class RecursiveGaussianFilter
+  {
+    static const size_t BLOCK_WIDTH = 32;
+    
+    float_t _sigma;
+    float_t _b;
+    float_t _a[3];
+    float_t _boundary_matrix[3][3];
+    size_t _n_threads;
+    
+    void compute_boundary_matrix();
+    
+  public:
+    /** Constructs a filter with standard deviation \em sigma. Throws an Exception if \em sigma is smaller than 0.5. */
+    explicit RecursiveGaussianFilter(float_t sigma, size_t n_threads = 1);
+    
+    /** Returns the standard deviation of the filter (in pixels). */
+    float_t sigma() const { return _sigma; }
+    
+    /** Returns the number of threads which are used to filter an image. */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads which are used to filter an image. If the library was compiled without OpenMP support, \em n_threads is ignored. The result does not depend on the number of threads. */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    /** Filters \em image along all of its axes. */
+    template <size_t N>
+    void apply(Image<N, float_t> & image) const
+    {
+      for(size_t i = 0; i < N; ++i)
+        apply(image, i);
+    }
+    
+    /** Filters \em image along the axis \em axis, i.e. convolves each line of pixels parallel to this axis with a 1-dimensional Gaussian. */
+    template <size_t N>
+    void apply(Image<N, float_t> & image, size_t axis) const;
+    
+    /** Filters \em width lines of \em length samples each. The <em>n</em>-th sample of the <em>j</em>-th line is stored at <tt>lines[n * stride + j]</tt>, where \em width must not be greater than \em stride. */
+    void filter_lines(float_t * lines, size_t length, size_t width, size_t stride) const;
+  };
+  
+  template <size_t N>
+  void RecursiveGaussianFilter::apply(Image<N, float_t> & image, size_t axis) const
+  {
+    if(axis >= N)
+      throw Exception("Exception: Invalid axis in RecursiveGaussianFilter::apply().");
+      
+    const size_t length = image.size()(axis);
+    
+    if(image.n_pixels() == 0 || length < 2)
+      return;
+      
+    // lines along axis start at outer * length * inner + i with 0 <= i < inner and are strided by inner
+    size_t inner = 1;
+    for(size_t i = axis + 1; i < N; ++i)
+      inner *= image.size()(i);
+      
+    const size_t outer = image.n_pixels() / (length * inner);
+    float_t * data = image.data();
+    
+    if(inner > 1)
+    {
+      // neighbouring lines are contiguous in memory and can be filtered in place
+      const size_t n_inner_blocks = (inner + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+      const long n_blocks = long(outer * n_inner_blocks);
+      
+      #pragma omp parallel for num_threads(_n_threads) schedule(static)
+      for(long block = 0; block < n_blocks; ++block)
+      {
+        size_t o = size_t(block) / n_inner_blocks;
+        size_t begin = (size_t(block) % n_inner_blocks) * BLOCK_WIDTH;
+        size_t width = std::min(BLOCK_WIDTH, inner - begin);
+        
+        filter_lines(data + o * length * inner + begin, length, width, inner);
+      }
+    }
+    else
+    {
+      // the lines are contiguous in memory, blocks of lines are transposed into a buffer
+      const long n_blocks = long((outer + BLOCK_WIDTH - 1) / BLOCK_WIDTH);
+      
+      #pragma omp parallel num_threads(_n_threads)
+      {
+        std::vector<float_t> buffer(length * BLOCK_WIDTH);
+        
+        #pragma omp for schedule(static)
+        for(long block = 0; block < n_blocks; ++block)
+        {
+          size_t begin = size_t(block) * BLOCK_WIDTH;
+          size_t width = std::min(BLOCK_WIDTH, outer - begin);
+          float_t * lines = data + begin * length;
+          
+          for(size_t j = 0; j < width; ++j)
+            for(size_t n = 0; n < length; ++n)
+              buffer[n * BLOCK_WIDTH + j] = lines[j * length + n];
+              
+          filter_lines(&buffer[0], length, width, BLOCK_WIDTH);
+          
+          for(size_t j = 0; j < width; ++j)
+            for(size_t n = 0; n < length; ++n)
+              lines[j * length + n] = buffer[n * BLOCK_WIDTH + j];
+        }
+      }
+    }
+  }
+}
+
+#endif
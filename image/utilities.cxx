@@ -16,18 +16,6 @@ namespace imaging
     magick_image.write(0, 0, image.size()(1), image.size()(0), "K", Magick::DoublePixel, &image[ublas::fixed_vector<size_t, 2>(0, 0)]);
   }
   
-  template <>
-  void blur(Image<2, float_t> & image, float_t width, float_t sigma)
-  {
-    if(sigma == 0.0) return;
-    
-    Magick::Image magick_image(image.size()(1), image.size()(0), "K", Magick::DoublePixel, &image[ublas::fixed_vector<size_t, 2>(0, 0)]);
-    
-    magick_image.gaussianBlur(width, sigma);
-    
-    magick_image.write(0, 0, image.size()(1), image.size()(0), "K", Magick::DoublePixel, &image[ublas::fixed_vector<size_t, 2>(0, 0)]);
-  }
-  
   template <>
   void absolute_gradient(Image<2, float_t> & image)
   {
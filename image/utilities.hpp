@@ -21,10 +21,63 @@
 #define IMAGE_UTILITIES_H
 
 #include <image/Image.hpp>
+#include <image/RecursiveGaussianFilter.hpp>
+#include <image/Convolution.hpp>
 #include <image/Color.hpp>
 
 namespace imaging
 {
+  template <std::size_t N, class DATA_t> class MappedImage;
+  
+  /** \cond */
+  namespace image_impl
+  {
+    template <class DATA_t>
+    DATA_t linear_max(const DATA_t * data, size_t n_pixels)
+    {
+      DATA_t max_value = data[0];
+      
+      #pragma omp parallel if(long(n_pixels) >= PARALLEL_TRAVERSAL_SIZE)
+      {
+        DATA_t local_max_value = data[0];
+        
+        #pragma omp for nowait
+        for(long i = 0; i < long(n_pixels); ++i)
+          local_max_value = local_max_value < data[i] ? data[i] : local_max_value;
+          
+        #pragma omp critical(image_linear_max)
+        {
+          if(max_value < local_max_value) max_value = local_max_value;
+        }
+      }
+      
+      return max_value;
+    }
+    
+    template <class DATA_t>
+    DATA_t linear_min(const DATA_t * data, size_t n_pixels)
+    {
+      DATA_t min_value = data[0];
+      
+      #pragma omp parallel if(long(n_pixels) >= PARALLEL_TRAVERSAL_SIZE)
+      {
+        DATA_t local_min_value = data[0];
+        
+        #pragma omp for nowait
+        for(long i = 0; i < long(n_pixels); ++i)
+          local_min_value = local_min_value > data[i] ? data[i] : local_min_value;
+          
+        #pragma omp critical(image_linear_min)
+        {
+          if(min_value > local_min_value) min_value = local_min_value;
+        }
+      }
+      
+      return min_value;
+    }
+  }
+  /** \endcond */
+  
   /** \ingroup image
       <tt>\#include <image/utilities.hpp></tt>
       
@@ -79,17 +132,188 @@ namespace imaging
     }
   }
   
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Computes a scalar image \em out such that the divergence of the vector field \f$F \vec e_a\f$ equals \em image, where \f$F\f$ denotes \em out, \f$a\f$ equals \em axis and \f$\vec e_a\f$ is the <em>a</em>-th unit vector. This is done by setting
+      \f[
+        F(x_1, \ldots, x_a, \ldots, x_N) = \int_0^{x_a}f(x_1, \ldots, \xi, \ldots, x_N) d\xi\,,
+      \f]
+      i.e. by summing \em image along \em axis. In contrast to the vector field computed by compute_divergence_field(const float_accessor_t &, vector_accessor_t &) only one scalar per pixel is stored. BoundaryDiscretizer::integrate_vector_field(const const_scalar_accessor_t &, size_t) integrates the flux of the field over a shape boundary.
+      
+      \em image and \em out may refer to the same object.
+  */
+  template <class float_accessor_t, class scalar_accessor_t>
+  void compute_divergence_field(const float_accessor_t & image, size_t axis, scalar_accessor_t & out)
+  {
+    const size_t dimension = float_accessor_t::dimension;
+    
+    if(image.size() != out.size())
+      throw Exception("Exception: Dimensions in compute_divergence_field() do not agree.");
+      
+    if(axis >= dimension)
+      throw Exception("Exception: Invalid axis in compute_divergence_field().");
+      
+    for(size_t i = 0; i < dimension; ++i)
+      if(image.size()(i) == 0)
+        return;
+        
+    ublas::fixed_vector<size_t, dimension> index, offset;
+    index.assign(0);
+    offset.assign(0);
+    
+    do
+    {
+      out[index] = image[index];
+    }
+    while(increment_index(image.size(), axis, index));
+    
+    offset(axis) = 1;
+    
+    for(size_t j = 1; j < image.size()(axis); ++j)
+    {
+      index(axis) = j;
+      do
+      {
+        out[index] = out[index - offset] + image[index];
+      }
+      while(increment_index(image.size(), axis, index));
+    }
+  }
+  
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Computes the scalar divergence field of \em image along \em axis (cf. compute_divergence_field(const float_accessor_t &, size_t, scalar_accessor_t &)). This overload is chosen if both images are of type Image. It traverses the storage of the images linearly and processes independent lines in parallel for large images. If \em axis is 0, a line of pixels is added to the previous line in each step, which is particularly cache friendly.
+  */
+  template <size_t N>
+  void compute_divergence_field(const Image<N, float_t> & image, size_t axis, Image<N, float_t> & out)
+  {
+    if(image.size() != out.size())
+      throw Exception("Exception: Dimensions in compute_divergence_field() do not agree.");
+      
+    if(axis >= N)
+      throw Exception("Exception: Invalid axis in compute_divergence_field().");
+      
+    if(image.n_pixels() == 0)
+      return;
+      
+    // lines along axis start at outer * length * inner + i with 0 <= i < inner and are strided by inner
+    const size_t length = image.size()(axis);
+    size_t inner = 1;
+    
+    for(size_t i = axis + 1; i < N; ++i)
+      inner *= image.size()(i);
+      
+    const size_t outer = image.n_pixels() / (length * inner);
+    const float_t * source = image.data();
+    float_t * target = out.data();
+    
+    if(inner > 1)
+    {
+      // blocks of neighbouring lines are summed line by line
+      const size_t BLOCK_WIDTH = 1024;
+      const size_t n_inner_blocks = (inner + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+      const long n_blocks = long(outer * n_inner_blocks);
+      
+      #pragma omp parallel for if(long(image.n_pixels()) >= image_impl::PARALLEL_TRAVERSAL_SIZE)
+      for(long block = 0; block < n_blocks; ++block)
+      {
+        size_t o = size_t(block) / n_inner_blocks;
+        size_t begin = (size_t(block) % n_inner_blocks) * BLOCK_WIDTH;
+        size_t width = std::min(BLOCK_WIDTH, inner - begin);
+        const float_t * source_lines = source + o * length * inner + begin;
+        float_t * target_lines = target + o * length * inner + begin;
+        
+        for(size_t k = 0; k < width; ++k)
+          target_lines[k] = source_lines[k];
+          
+        for(size_t j = 1; j < length; ++j)
+        {
+          const float_t * source_line = source_lines + j * inner;
+          float_t * target_line = target_lines + j * inner;
+          const float_t * previous_line = target_line - inner;
+          
+          for(size_t k = 0; k < width; ++k)
+            target_line[k] = previous_line[k] + source_line[k];
+        }
+      }
+    }
+    else
+    {
+      #pragma omp parallel for if(long(image.n_pixels()) >= image_impl::PARALLEL_TRAVERSAL_SIZE)
+      for(long o = 0; o < long(outer); ++o)
+      {
+        const float_t * source_line = source + size_t(o) * length;
+        float_t * target_line = target + size_t(o) * length;
+        float_t sum = 0.0;
+        
+        for(size_t j = 0; j < length; ++j)
+        {
+          sum += source_line[j];
+          target_line[j] = sum;
+        }
+      }
+    }
+  }
+  
   /** \ingroup image 
       <tt>\#include <image/utilities.hpp></tt>
       
-      Blurs \em image by convoluting it with a Gaussian kernel with standard deviation \em sigma (in pixels). The parameter \em width determines the radius of the kernel in pixels. This function is currently implemented for 2-dimensional images only (using ImageMagick).
+      Blurs \em image by convoluting it with a Gaussian kernel with standard deviation \em sigma (in pixels). This function is currently implemented for images of the type <em>Image<N, float_t></em> only, see blur(Image<N, float_t> &, float_t, float_t). The parameter \em width is kept for compatibility and is ignored by this implementation.
   */
   template <class image_t>
   void blur(image_t & image, float_t width, float_t sigma)
   {}
   
-  template <>
-  void blur(Image<2, float_t> & image, float_t width, float_t sigma);
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Blurs \em image of arbitrary dimension by convoluting it with a Gaussian kernel with standard deviation \em sigma (in pixels). For \em sigma of at least 0.5 the convolution is approximated by a RecursiveGaussianFilter, i.e. its cost does not depend on \em sigma. The recursive filter is not accurate for smaller \em sigma; in this case \em image is convolved with a sampled and normalized Gaussian kernel of radius <tt>ceil(3 sigma)</tt>. In both cases the image is extended by its boundary values. The parameter \em width is ignored. Nothing is done if \em sigma is 0. Throws an Exception if \em sigma is negative.
+  */
+  template <size_t N>
+  void blur(Image<N, float_t> & image, float_t width, float_t sigma)
+  {
+    if(sigma == 0.0) return;
+    
+    if(sigma < 0.0)
+      throw Exception("Exception: Negative standard deviation in blur().");
+    
+    if(sigma >= 0.5)
+    {
+      RecursiveGaussianFilter(sigma).apply(image);
+      return;
+    }
+    
+    // sampled separable kernel; its entries are the products of the 1-dimensional weights
+    const size_t radius = size_t(ceil(3.0 * sigma));
+    std::vector<float_t> weights(2 * radius + 1);
+    float_t sum = 0.0;
+    
+    for(size_t i = 0; i < weights.size(); ++i)
+    {
+      float_t x = float_t(i) - float_t(radius);
+      weights[i] = exp(-x * x / (2.0 * sigma * sigma));
+      sum += weights[i];
+    }
+    
+    for(size_t i = 0; i < weights.size(); ++i)
+      weights[i] /= sum;
+    
+    Image<N, float_t> kernel(ublas::fixed_vector<size_t, N>(ublas::scalar_vector<size_t>(N, weights.size())));
+    
+    for(size_t i = 0; i < kernel.n_pixels(); ++i)
+    {
+      float_t value = 1.0;
+      
+      for(size_t j = 0, k = i; j < N; ++j, k /= weights.size())
+        value *= weights[k % weights.size()];
+        
+      kernel.data()[i] = value;
+    }
+    
+    Convolution<N>(kernel, Convolution<N>::REPLICATE_BOUNDARY).apply(image, image);
+  }
   
   /** \ingroup image
       <tt>\#include <image/utilities.hpp></tt>
@@ -144,6 +368,34 @@ namespace imaging
     return max_value;
   }
   
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Computes the maximal pixel value of \em image. The pixels are traversed linearly. 
+  */
+  template <std::size_t N, class DATA_t>
+  DATA_t max(const Image<N, DATA_t> & image)
+  {
+    if(image.empty()) 
+      throw Exception("Exception: passed empty image to max(const ImageInterface &).");
+      
+    return image_impl::linear_max(image.data(), image.n_pixels());
+  }
+  
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Computes the maximal pixel value of \em image. The pixels are traversed linearly. 
+  */
+  template <std::size_t N, class DATA_t>
+  DATA_t max(const MappedImage<N, DATA_t> & image)
+  {
+    if(image.n_pixels() == 0) 
+      throw Exception("Exception: passed empty image to max(const ImageInterface &).");
+      
+    return image_impl::linear_max(image.data(), image.n_pixels());
+  }
+  
   /** \ingroup image
       <tt>\#include <image/utilities.hpp></tt>
       
@@ -168,6 +420,34 @@ namespace imaging
     return min_value;
   }
   
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Computes the minimal pixel value of \em image. The pixels are traversed linearly. 
+  */
+  template <std::size_t N, class DATA_t>
+  DATA_t min(const Image<N, DATA_t> & image)
+  {
+    if(image.empty()) 
+      throw Exception("Exception: passed empty image to min(const ImageInterface &).");
+      
+    return image_impl::linear_min(image.data(), image.n_pixels());
+  }
+  
+  /** \ingroup image
+      <tt>\#include <image/utilities.hpp></tt>
+      
+      Computes the minimal pixel value of \em image. The pixels are traversed linearly. 
+  */
+  template <std::size_t N, class DATA_t>
+  DATA_t min(const MappedImage<N, DATA_t> & image)
+  {
+    if(image.n_pixels() == 0) 
+      throw Exception("Exception: passed empty image to min(const ImageInterface &).");
+      
+    return image_impl::linear_min(image.data(), image.n_pixels());
+  }
+  
   /** \ingroup image
       <tt>\#include <image/utilities.hpp></tt>
       
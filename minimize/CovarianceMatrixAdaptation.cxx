@@ -1,179 +1,119 @@
 #include <minimize/CovarianceMatrixAdaptation.hpp>
+#include <minimize/SeparableCovarianceMatrixAdaptation.hpp>
 
 #include <core/utilities.hpp>
-#include <core/MessageInterface.hpp>
-#include <core/distribution_utilities.hpp>
 #include <lapack/linear_algebra.hpp>
 
-#include <map>
-
 namespace imaging
 {
   CovarianceMatrixAdaptation::CovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update) :
-      _energy(energy)
+      CovarianceMatrixAdaptationBase(energy, "CovarianceMatrixAdaptation")
   {
     size_t lambda = 4 + size_t(floor(3.0 * log(float_t(_energy.dimension()))));
     init(sigma, min_update, lambda);
+    init_covariance();
   }
   
   
   CovarianceMatrixAdaptation::CovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update, std::size_t lambda) :
-      _energy(energy)
+      CovarianceMatrixAdaptationBase(energy, "CovarianceMatrixAdaptation")
   {
     init(sigma, min_update, lambda);
+    init_covariance();
   }
+  
+  CovarianceMatrixAdaptation::CovarianceMatrixAdaptation(EnergyInterface & energy, const SeparableCovarianceMatrixAdaptation & separable_cma) :
+      CovarianceMatrixAdaptationBase(energy, "CovarianceMatrixAdaptation")
+  {
+    if(separable_cma.covariance_diagonal().size() != _energy.dimension())
+      throw Exception("Exception: Dimensions of energy and separable CMA do not agree in CovarianceMatrixAdaptation::CovarianceMatrixAdaptation().");
       
-  void CovarianceMatrixAdaptation::init(float_t sigma, float_t min_update, std::size_t lambda)
-  { 
-    _lambda = lambda;
-    _sigma = sigma;
-    _mu = _lambda / 2;
-    _w.resize(_mu);
-    _n = _energy.dimension();
-    _C.resize(_n, _n);
-    _p_sigma.resize(_n);
-    _p_c.resize(_n);
-    _min_update = min_update;
-    _terminated = false;
-      
-    ublas::vector<float_t> w_prime(_mu);
+    init(separable_cma.sigma(), separable_cma.min_update(), separable_cma.lambda());
+    init_covariance();
     
-    float_t mu_prime = (float_t(_lambda) - 1.0) / 2.0;
-    
-    for(std::size_t i = 0; i < _mu; ++i)
-      w_prime(i) = log(mu_prime + 1.0) - log(float_t(i) + 1.0);
-      
-    float_t sum_of_w_prime = inner_prod(w_prime, ublas::scalar_vector<float_t>(w_prime.size(), 1.0));
+    for(std::size_t i = 0; i < _n; ++i)
+      _C(i, i) = separable_cma.covariance_diagonal()(i);
       
-    _w = w_prime / sum_of_w_prime;
-      
-    _mu_eff = 1.0 / inner_prod(_w, _w);
+    _p_sigma = separable_cma.sigma_path();
+    _p_c = separable_cma.covariance_path();
+    _n_threads = separable_cma.n_threads();
+    _seed = separable_cma.seed();
+    _n_generations = separable_cma.n_generations();
+  }
       
-    _c_sigma = (_mu_eff + 2.0) / (float_t(_n) + _mu_eff + 3.0);
-    
-    _d_sigma = 1.0 + 2.0 * max(0.0, sqrt( (_mu_eff - 1.0) / (float_t(_n) + 1.0) ) - 1.0 ) + _c_sigma;
-    
-    _c_c = 4.0 / (float_t(_n) + 4.0);
-    
-    _mu_cov = _mu_eff;
-    
-    _c_cov = 1.0 / _mu_cov * 2.0 / square(float_t(_n) + SQUARE_ROOT_2) +
-            (1.0 - 1.0 / _mu_cov) * min(1.0, (2 * _mu_eff - 1) / (square(float_t(_n) + 2) + _mu_eff) );
-            
+  void CovarianceMatrixAdaptation::init_covariance()
+  { 
+    _C.resize(_n, _n);
+    _B.resize(_n, _n);
+    _D.resize(_n);
+    _is_decomposed = false;
+    _decomposition_generation = 0;
     
     _C = ublas::identity_matrix<float_t>(_n);
     
-    _p_sigma = ublas::scalar_vector<float_t>(_n, 0.0);
-    
-    _p_c = ublas::scalar_vector<float_t>(_n, 0.0);
+    // cf. Hansen's tutorial: decompose C every lambda / (c_1 + c_mu) / n / 10 evaluations
+    _decomposition_interval = max(std::size_t(1), std::size_t(floor(1.0 / (_c_cov * float_t(_n) * 10.0))));
   }
     
-
-  bool CovarianceMatrixAdaptation::minimize(std::size_t n_max_steps, std::size_t & n_steps)
+  void CovarianceMatrixAdaptation::update_decomposition()
   {
-    if(_terminated)
-    {
-      n_steps = 0;
-      return true;
-    }
-    
-    float_t expected_norm = SQUARE_ROOT_2 * tgamma(float_t(_n + 1.0) / 2.0) / tgamma(float_t(_n) / 2.0); 
-    ublas::vector<float_t> m(_n); 
-    ublas::vector<float_t> y_w(_n);
-    ublas::matrix<float_t> sum_outer_product_y;
-    ublas::matrix<float_t> BD(_n, _n);
-    ublas::matrix<float_t> inverse_square_root_C(_n, _n);
+    ublas::vector<float_t> eigenvalues(_n);
     
-    std::vector< ublas::vector<float_t> > z(_lambda);
-    std::vector< ublas::vector<float_t> > y(_lambda);
-    std::vector< ublas::vector<float_t> > x(_lambda);
+    eigensystem(_C, _B, eigenvalues);
     
-    for(std::size_t i = 0; i < _lambda; ++i) z[i].resize(_n);
-    for(std::size_t i = 0; i < _lambda; ++i) y[i].resize(_n);
-    for(std::size_t i = 0; i < _lambda; ++i) x[i].resize(_n);
+    for(std::size_t i = 0; i < _n; ++i)
+      _D(i) = sqrt(fabs(eigenvalues(i)));
       
-    std::multimap<float_t, std::size_t> energies;
-    
-    m = _energy.current_argument();
+    _decomposition_generation = _n_generations;
+    _is_decomposed = true;
+  }
+  
+  void CovarianceMatrixAdaptation::prepare_sampling()
+  {
+    // C = B D^2 B^T is decomposed only every _decomposition_interval generations
+    if(! _is_decomposed || _n_generations - _decomposition_generation >= _decomposition_interval)
+      update_decomposition();
+  }
+  
+  void CovarianceMatrixAdaptation::transform_sample(const ublas::vector<float_t> & z, ublas::vector<float_t> & y, ublas::vector<float_t> & buffer) const
+  {
+    // y = B D z
+    noalias(buffer) = element_prod(_D, z);
+    noalias(y) = prod(_B, buffer);
+  }
+  
+  void CovarianceMatrixAdaptation::inverse_square_root_C(const ublas::vector<float_t> &, const ublas::vector<float_t> & z_w, ublas::vector<float_t> & result) const
+  {
+    // C^{-1/2} y_w = B D^{-1} B^T y_w = B z_w
+    noalias(result) = prod(_B, z_w);
+  }
+  
+  float_t CovarianceMatrixAdaptation::update_covariance(const std::vector< ublas::vector<float_t> > & y, const std::vector<std::size_t> & ranking, float_t delta_h_sigma)
+  {
+    // rank-one and rank-mu update of the upper triangle of C (without temporaries)
+    const float_t old_weight = 1.0 - _c_cov + _c_cov / _mu_cov * delta_h_sigma;
+    const float_t rank_one_weight = _c_cov / _mu_cov;
+    const float_t rank_mu_weight = _c_cov * ( 1.0 - 1.0 / _mu_cov );
     
-    for(n_steps = 0; n_steps < n_max_steps; ++n_steps)
-    {      
-      MessageInterface::out("CovarianceMatrixAdaptation: Step " + boost::lexical_cast<std::string>(n_steps + 1), MessageInterface::DEBUG_ONLY);
-      
-      symmetric_square_root(_C, BD);
-      
-      for(std::size_t k = 0; k < _lambda; ++k)
-        for(std::size_t i = 0; i < _n; ++i)
-          z[k](i) = normal_distribution();
-          
-      for(std::size_t k = 0; k < _lambda; ++k)
-        y[k] = prod(BD, z[k]);
-          
-      for(std::size_t k = 0; k < _lambda; ++k)
-        x[k] = m + _sigma * y[k];
-        
-      energies.clear();
-      
-      for(std::size_t k = 0; k < _lambda; ++k)
+    for(std::size_t i = 0; i < _n; ++i)
+    {
+      for(std::size_t j = i; j < _n; ++j)
       {
-        _energy.current_argument() = x[k];
-          
-        // the actual computational effort is hidden here:
-        _energy.set_argument();
+        float_t sum_outer_product_y = 0.0;
         
-        energies.insert(std::pair<float_t, std::size_t>(_energy.current_energy(), k));
-      }
-      
-      MessageInterface::out("Current minimal functional value: " + boost::lexical_cast<std::string>((*energies.begin()).first), MessageInterface::DEBUG_ONLY, +1);
-      
-      y_w = ublas::scalar_vector<float_t>(_n, 0.0);
-      
-      std::size_t i = 0;
-      for(std::multimap<float_t, std::size_t>::const_iterator iter = energies.begin();
-          iter != energies.end() && i < _mu; ++iter, ++i)
-        y_w += _w(i) * y[iter->second];
+        for(std::size_t l = 0; l < _mu; ++l)
+          sum_outer_product_y += _w(l) * y[ranking[l]](i) * y[ranking[l]](j);
           
-      m += _sigma * y_w;
-      
-      inverse_square_root(_C, inverse_square_root_C);
-      
-      _p_sigma = (1 - _c_sigma) * _p_sigma + sqrt(_c_sigma * (2 - _c_sigma) * _mu_eff) * prod(inverse_square_root_C, y_w);
-  
-      _sigma = exp( _c_sigma / _d_sigma * ( norm_2(_p_sigma) / expected_norm - 1 ) );
-      
-      float_t h_sigma;
-      if( norm_2(_p_sigma) / sqrt( 1 - pow(1 - _c_sigma, 2.0 * (float_t(n_steps) + 1.0) ) ) <
-          ( 1.4 + 2.0 / (float_t(_n) + 1.0) ) * expected_norm )
-        h_sigma = 1.0;
-      else
-        h_sigma = 0.0;
-        
-      float_t delta_h_sigma = (1 - h_sigma) * _c_c * (2 - _c_c);
-      
-      _p_c = (1 - _c_c) * _p_c + h_sigma * sqrt( _c_c * (2.0 - _c_c) * _mu_eff ) * y_w;
-      
-      sum_outer_product_y = ublas::scalar_matrix<float_t>(_n, _n, 0.0);
-      
-      i = 0;
-      for(std::multimap<float_t, std::size_t>::const_iterator iter = energies.begin();
-          iter != energies.end() && i < _mu; ++iter, ++i)
-        sum_outer_product_y += _w(i) * outer_prod(y[iter->second], y[iter->second]);
-        
-      _C = (1.0 - _c_cov) * _C + _c_cov/_mu_cov * ( outer_prod(_p_c, _p_c) + delta_h_sigma * _C ) +
-          _c_cov * ( 1.0 - 1.0/_mu_cov ) * sum_outer_product_y;
-      
-      if(_sigma * norm_frobenius(BD) < _min_update) 
-      {
-        _terminated = true;
-        break;
+        _C(i, j) = old_weight * _C(i, j) + rank_one_weight * _p_c(i) * _p_c(j) + rank_mu_weight * sum_outer_product_y;
+        _C(j, i) = _C(i, j);
       }
     }
     
-    _energy.current_argument() = m;
-    _energy.set_argument();
-    
-    return _terminated;
+    float_t trace_C = 0.0;
+    for(std::size_t i = 0; i < _n; ++i)
+      trace_C += _C(i, i);
+      
+    return trace_C;
   }
 
 }
-
@@ -20,39 +20,39 @@
 #ifndef MINIMIZE_COVARIANCEMATRIXADAPTATION_H
 #define MINIMIZE_COVARIANCEMATRIXADAPTATION_H
 
-#include <minimize/EnergyInterface.hpp>
-#include <minimize/MinimizerInterface.hpp>
+#include <minimize/CovarianceMatrixAdaptationBase.hpp>
 
 namespace imaging
 {
+  class SeparableCovarianceMatrixAdaptation;
+  
   /** \ingroup minimize
       \brief Minimizes energies using covariance matrix adaptation (CMA).
       
       This class attempts (module programming errors) to implement the covariance matrix adaptation as in <em><a href="http://www.bionik.tu-berlin.de/user/niko/cmatutorial.pdf">Nikolaus Hansen, "The CMA Evolution Strategy: A Tutorial"</a></em>.
+      
+      The candidates of a generation can be evaluated by several threads in parallel and are sampled from reproducible random number streams (see CovarianceMatrixAdaptationBase).
+      
+      The covariance matrix \f$C\f$ is not decomposed in every generation. Its eigensystem \f$C = BD^2B^T\f$ is recomputed every decomposition_interval() generations (by default \f$\max\{1, 1/(10 c_{\textrm{cov}} n)\}\f$ as suggested in the tutorial, i.e. roughly every \f$n/20\f$ generations) and used both to sample the candidates and to compute \f$C^{-1/2}\f$. Between two decompositions a generation costs \f$O(\lambda n^2)\f$ operations in addition to the energy evaluations.
   */
-  class CovarianceMatrixAdaptation : public MinimizerInterface
+  class CovarianceMatrixAdaptation : public CovarianceMatrixAdaptationBase
   {
-    std::size_t _lambda;
-    float_t _sigma;
-    std::size_t _mu;
-    ublas::vector<float_t> _w;
-    float_t _c_sigma;
-    float_t _d_sigma;
-    float_t _mu_eff;
-    float_t _mu_cov;
-    float_t _c_cov;
-    float_t _c_c;
-    std::size_t _n;
     ublas::matrix<float_t> _C;
-    ublas::vector<float_t> _p_sigma;     
-    ublas::vector<float_t> _p_c; 
-    bool _terminated;
-      
-    EnergyInterface & _energy;
+    ublas::matrix<float_t> _B;
+    ublas::vector<float_t> _D;
+    bool _is_decomposed;
+    unsigned long _decomposition_generation;
+    std::size_t _decomposition_interval;
     
-    float_t _min_update;
+    void init_covariance();
+    void update_decomposition();
     
-    void init(float_t sigma, float_t min_update, std::size_t lambda);
+  protected:
+    void restart_generations() { _is_decomposed = false; }
+    void prepare_sampling();
+    void transform_sample(const ublas::vector<float_t> & z, ublas::vector<float_t> & y, ublas::vector<float_t> & buffer) const;
+    void inverse_square_root_C(const ublas::vector<float_t> & y_w, const ublas::vector<float_t> & z_w, ublas::vector<float_t> & result) const;
+    float_t update_covariance(const std::vector< ublas::vector<float_t> > & y, const std::vector<std::size_t> & ranking, float_t delta_h_sigma);
   
   public:
     /** Construct a CMA object to minimize \em energy. The minimum should not be more 3 \em sigma away from the current argument of \em energy. The parameter \em lambda denotes the population size in the CMA algorithm. If the threshold \em minimal_update is not met during a step of the minimization the algorithm stops. To actually start the minimization the user must call minimize(). */
@@ -60,8 +60,15 @@ namespace imaging
       
     /** Construct a CMA object to minimize \em energy. The minimum should not be more 3 \em sigma away from the current argument of \em energy. If the threshold \em minimal_update is not met during a step of the minimization the algorithm stops. To actually start the minimization the user must call minimize(). */
     CovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update); 
-
-    bool minimize(size_t n_max_steps, size_t & n_actual_steps);
+    
+    /** Construct a CMA object which continues the minimization of \em energy by \em separable_cma with a full covariance matrix. The population size, the step size, the evolution paths, the threshold of the update and the random number streams are taken from \em separable_cma and the covariance matrix is initialized to its diagonal covariance matrix. The mean of the search distribution is the current argument of \em energy, which is the case after a call to SeparableCovarianceMatrixAdaptation::minimize(). */
+    CovarianceMatrixAdaptation(EnergyInterface & energy, const SeparableCovarianceMatrixAdaptation & separable_cma); 
+    
+    /** Returns the number of generations between two eigendecompositions of the covariance matrix. */
+    std::size_t decomposition_interval() const { return _decomposition_interval; }
+    
+    /** Sets the number of generations between two eigendecompositions of the covariance matrix to \em interval. If \em interval is 1 the covariance matrix is decomposed in each generation. */
+    void set_decomposition_interval(std::size_t interval) { _decomposition_interval = interval > 0 ? interval : 1; }
   };
 
 }
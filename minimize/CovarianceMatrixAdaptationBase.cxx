@@ -0,0 +1,258 @@
+#include <minimize/CovarianceMatrixAdaptationBase.hpp>
+
+#include <core/utilities.hpp>
+#include <core/MessageInterface.hpp>
+#include <core/distribution_utilities.hpp>
+
+#include <algorithm>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace imaging
+{
+  CovarianceMatrixAdaptationBase::CovarianceMatrixAdaptationBase(EnergyInterface & energy, const std::string & name) :
+      _name(name), _energy(energy)
+  {
+  }
+  
+  CovarianceMatrixAdaptationBase::~CovarianceMatrixAdaptationBase()
+  {
+    for(std::size_t i = 0; i < _clones.size(); ++i)
+      delete _clones[i];
+  }
+      
+  void CovarianceMatrixAdaptationBase::init(float_t sigma, float_t min_update, std::size_t lambda)
+  { 
+    _lambda = lambda;
+    _sigma = sigma;
+    _mu = _lambda / 2;
+    _w.resize(_mu);
+    _n = _energy.dimension();
+    _p_sigma.resize(_n);
+    _p_c.resize(_n);
+    _min_update = min_update;
+    _terminated = false;
+    _n_threads = 1;
+    _seed = static_cast<unsigned long>(uniform_distribution() * 4294967295.0);
+    _n_generations = 0;
+      
+    ublas::vector<float_t> w_prime(_mu);
+    
+    float_t mu_prime = (float_t(_lambda) - 1.0) / 2.0;
+    
+    for(std::size_t i = 0; i < _mu; ++i)
+      w_prime(i) = log(mu_prime + 1.0) - log(float_t(i) + 1.0);
+      
+    float_t sum_of_w_prime = inner_prod(w_prime, ublas::scalar_vector<float_t>(w_prime.size(), 1.0));
+      
+    _w = w_prime / sum_of_w_prime;
+      
+    _mu_eff = 1.0 / inner_prod(_w, _w);
+      
+    _c_sigma = (_mu_eff + 2.0) / (float_t(_n) + _mu_eff + 3.0);
+    
+    _d_sigma = 1.0 + 2.0 * max(0.0, sqrt( (_mu_eff - 1.0) / (float_t(_n) + 1.0) ) - 1.0 ) + _c_sigma;
+    
+    _c_c = 4.0 / (float_t(_n) + 4.0);
+    
+    _mu_cov = _mu_eff;
+    
+    _c_cov = 1.0 / _mu_cov * 2.0 / square(float_t(_n) + SQUARE_ROOT_2) +
+            (1.0 - 1.0 / _mu_cov) * min(1.0, (2 * _mu_eff - 1) / (square(float_t(_n) + 2) + _mu_eff) );
+    
+    _p_sigma = ublas::scalar_vector<float_t>(_n, 0.0);
+    
+    _p_c = ublas::scalar_vector<float_t>(_n, 0.0);
+  }
+  
+  void CovarianceMatrixAdaptationBase::update_clones()
+  {
+    for(std::size_t i = 0; i < _clones.size(); ++i)
+      delete _clones[i];
+      
+    _clones.clear();
+    
+  #ifdef _OPENMP
+    for(std::size_t i = 1; i < _n_threads; ++i)
+    {
+      EnergyInterface * clone = _energy.clone();
+      
+      if(! clone)
+        throw Exception("Exception: Energy can not be cloned for parallel evaluation in " + _name + "::minimize().");
+        
+      _clones.push_back(clone);
+    }
+  #endif
+  }
+  
+  struct CovarianceMatrixAdaptationBase::energy_order
+  {
+    const std::vector<float_t> & _energies;
+    
+    energy_order(const std::vector<float_t> & energies) : _energies(energies) {}
+    
+    bool operator()(std::size_t a, std::size_t b) const
+    {
+      return _energies[a] < _energies[b] || (_energies[a] == _energies[b] && a < b);
+    }
+  };
+  
+  void CovarianceMatrixAdaptationBase::evaluate_candidates(const ublas::vector<float_t> & m, std::vector< ublas::vector<float_t> > & z, std::vector< ublas::vector<float_t> > & y, std::vector< ublas::vector<float_t> > & x, std::vector<float_t> & energies)
+  {
+    bool failed = false;
+    std::string error_message;
+    
+    #pragma omp parallel num_threads(_n_threads)
+    {
+      EnergyInterface * energy = & _energy;
+      
+    #ifdef _OPENMP
+      if(omp_get_thread_num() > 0)
+        energy = _clones[omp_get_thread_num() - 1];
+    #endif
+    
+      // the evaluation times of the candidates may differ considerably
+      #pragma omp for schedule(dynamic)
+      for(long k = 0; k < long(_lambda); ++k)
+      {
+        try
+        {
+          normal_distribution(stream_seed(_seed, _n_generations, k), z[k]);
+          
+          // x[k] is used as temporary storage
+          transform_sample(z[k], y[k], x[k]);
+          noalias(x[k]) = m + _sigma * y[k];
+          
+          energy->current_argument() = x[k];
+          
+          // the actual computational effort is hidden here:
+          energy->set_argument();
+          
+          energies[k] = energy->current_energy();
+        }
+        catch(Exception & e)
+        {
+          #pragma omp critical(cma_error)
+          {
+            failed = true;
+            error_message = e.error_msg();
+          }
+        }
+        catch(std::exception & e)
+        {
+          #pragma omp critical(cma_error)
+          {
+            failed = true;
+            error_message = "Exception: " + std::string(e.what()) + " in " + _name + "::minimize().";
+          }
+        }
+        catch(...)
+        {
+          #pragma omp critical(cma_error)
+          {
+            failed = true;
+            error_message = "Exception: Unknown exception in " + _name + "::minimize().";
+          }
+        }
+      }
+    }
+    
+    if(failed)
+      throw Exception(error_message);
+  }
+
+  bool CovarianceMatrixAdaptationBase::minimize(std::size_t n_max_steps, std::size_t & n_steps)
+  {
+    if(_terminated)
+    {
+      n_steps = 0;
+      return true;
+    }
+    
+    // E|N(0, I)| (computed via lgamma() because tgamma() overflows for n > 340)
+    float_t expected_norm = SQUARE_ROOT_2 * exp(lgamma(float_t(_n + 1.0) / 2.0) - lgamma(float_t(_n) / 2.0)); 
+    ublas::vector<float_t> m(_n); 
+    ublas::vector<float_t> y_w(_n);
+    ublas::vector<float_t> z_w(_n);
+    ublas::vector<float_t> inverse_square_root_C_y_w(_n);
+    
+    std::vector< ublas::vector<float_t> > z(_lambda);
+    std::vector< ublas::vector<float_t> > y(_lambda);
+    std::vector< ublas::vector<float_t> > x(_lambda);
+    
+    for(std::size_t i = 0; i < _lambda; ++i) z[i].resize(_n);
+    for(std::size_t i = 0; i < _lambda; ++i) y[i].resize(_n);
+    for(std::size_t i = 0; i < _lambda; ++i) x[i].resize(_n);
+      
+    std::vector<float_t> energies(_lambda);
+    std::vector<std::size_t> ranking(_lambda);
+    
+    update_clones();
+    
+    m = _energy.current_argument();
+    
+    for(n_steps = 0; n_steps < n_max_steps; ++n_steps)
+    {      
+      MessageInterface::out(_name + ": Step " + boost::lexical_cast<std::string>(n_steps + 1), MessageInterface::DEBUG_ONLY);
+      
+      prepare_sampling();
+      
+      evaluate_candidates(m, z, y, x, energies);
+        
+      ++_n_generations;
+      
+      for(std::size_t k = 0; k < _lambda; ++k)
+        ranking[k] = k;
+        
+      std::sort(ranking.begin(), ranking.end(), energy_order(energies));
+      
+      MessageInterface::out("Current minimal functional value: " + boost::lexical_cast<std::string>(energies[ranking[0]]), MessageInterface::DEBUG_ONLY, +1);
+      
+      y_w.clear();
+      z_w.clear();
+      
+      for(std::size_t i = 0; i < _mu; ++i)
+      {
+        noalias(y_w) += _w(i) * y[ranking[i]];
+        noalias(z_w) += _w(i) * z[ranking[i]];
+      }
+          
+      noalias(m) += _sigma * y_w;
+      
+      inverse_square_root_C(y_w, z_w, inverse_square_root_C_y_w);
+      
+      _p_sigma = (1 - _c_sigma) * _p_sigma + sqrt(_c_sigma * (2 - _c_sigma) * _mu_eff) * inverse_square_root_C_y_w;
+  
+      _sigma *= exp( _c_sigma / _d_sigma * ( norm_2(_p_sigma) / expected_norm - 1 ) );
+      
+      float_t h_sigma;
+      if( norm_2(_p_sigma) / sqrt( 1 - pow(1 - _c_sigma, 2.0 * (float_t(n_steps) + 1.0) ) ) <
+          ( 1.4 + 2.0 / (float_t(_n) + 1.0) ) * expected_norm )
+        h_sigma = 1.0;
+      else
+        h_sigma = 0.0;
+        
+      float_t delta_h_sigma = (1 - h_sigma) * _c_c * (2 - _c_c);
+      
+      _p_c = (1 - _c_c) * _p_c + h_sigma * sqrt( _c_c * (2.0 - _c_c) * _mu_eff ) * y_w;
+      
+      float_t trace_C = update_covariance(y, ranking, delta_h_sigma);
+      
+      // sigma * |BD|_F = sigma * sqrt(trace(C))
+      if(_sigma * sqrt(trace_C) < _min_update) 
+      {
+        _terminated = true;
+        break;
+      }
+    }
+    
+    _energy.current_argument() = m;
+    _energy.set_argument();
+    
+    return _terminated;
+  }
+
+}
@@ -0,0 +1,136 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MINIMIZE_COVARIANCEMATRIXADAPTATIONBASE_H
+#define MINIMIZE_COVARIANCEMATRIXADAPTATIONBASE_H
+
+#include <minimize/EnergyInterface.hpp>
+#include <minimize/MinimizerInterface.hpp>
+
+#include <vector>
+#include <string>
+
+namespace imaging
+{
+  /** \ingroup minimize
+      \brief Common base class of CovarianceMatrixAdaptation and SeparableCovarianceMatrixAdaptation.
+      
+      This class implements the parts of the CMA evolution strategy which do not depend on the representation of the covariance matrix \f$C\f$: the selection weights and learning rates, the parallel evaluation of the candidates, the ranking of the candidates, the update of the mean, of the step size and of the evolution paths. Derived classes store \f$C\f$, sample from \f$N(0, C)\f$ and update \f$C\f$.
+      
+      The candidates of a generation can be evaluated by several threads in parallel (see set_n_threads()). Each thread then evaluates its candidates on its own copy of the energy, which is obtained from EnergyInterface::clone(). This requires the library to be compiled with OpenMP support.
+      
+      The samples of each candidate are drawn from a separate random number stream which is determined by the seed (see set_seed()), the index of the generation and the index of the candidate. Thus the result of the minimization does not depend on the number of threads, and runs with the same seed can be reproduced exactly.
+  */
+  class CovarianceMatrixAdaptationBase : public MinimizerInterface
+  {
+    std::string _name;
+    std::vector<EnergyInterface *> _clones;
+    
+    struct energy_order;
+    
+    CovarianceMatrixAdaptationBase(const CovarianceMatrixAdaptationBase &);
+    CovarianceMatrixAdaptationBase & operator=(const CovarianceMatrixAdaptationBase &);
+    
+    void update_clones();
+    void evaluate_candidates(const ublas::vector<float_t> & m, std::vector< ublas::vector<float_t> > & z, std::vector< ublas::vector<float_t> > & y, std::vector< ublas::vector<float_t> > & x, std::vector<float_t> & energies);
+    
+  protected:
+    std::size_t _lambda;
+    float_t _sigma;
+    std::size_t _mu;
+    ublas::vector<float_t> _w;
+    float_t _c_sigma;
+    float_t _d_sigma;
+    float_t _mu_eff;
+    float_t _mu_cov;
+    float_t _c_cov;
+    float_t _c_c;
+    std::size_t _n;
+    ublas::vector<float_t> _p_sigma;     
+    ublas::vector<float_t> _p_c; 
+    bool _terminated;
+      
+    EnergyInterface & _energy;
+    
+    float_t _min_update;
+    
+    std::size_t _n_threads;
+    unsigned long _seed;
+    unsigned long _n_generations;
+    
+    /** Constructs the common state for the minimization of \em energy. The string \em name is the class name used in messages. Derived classes must call init() in their constructors. */
+    CovarianceMatrixAdaptationBase(EnergyInterface & energy, const std::string & name);
+    
+    /** Sets the step size \em sigma, the threshold \em min_update, the population size \em lambda and the default weights and learning rates as in Hansen's tutorial. */
+    void init(float_t sigma, float_t min_update, std::size_t lambda);
+    
+    /** Is called by set_seed() after the generation count has been reset. */
+    virtual void restart_generations() {}
+    
+    /** Is called at the beginning of each generation before the candidates are sampled. */
+    virtual void prepare_sampling() {}
+    
+    /** Transforms the standard normal sample \em z to a sample \em y of \f$N(0, C)\f$. The vector \em buffer can be used as temporary storage. This function is called concurrently by several threads. */
+    virtual void transform_sample(const ublas::vector<float_t> & z, ublas::vector<float_t> & y, ublas::vector<float_t> & buffer) const = 0;
+    
+    /** Computes \f$C^{-1/2} y_w\f$, where \f$y_w\f$ is the weighted mean of the selected samples \em y and \f$z_w\f$ the weighted mean of the corresponding standard normal samples \em z. */
+    virtual void inverse_square_root_C(const ublas::vector<float_t> & y_w, const ublas::vector<float_t> & z_w, ublas::vector<float_t> & result) const = 0;
+    
+    /** Performs the rank-one and the rank-\f$\mu\f$ update of \f$C\f$ using the samples \em y sorted by \em ranking and the correction \em delta_h_sigma of the weight of the old covariance matrix. Returns the trace of the updated \f$C\f$. */
+    virtual float_t update_covariance(const std::vector< ublas::vector<float_t> > & y, const std::vector<std::size_t> & ranking, float_t delta_h_sigma) = 0;
+    
+  public:
+    ~CovarianceMatrixAdaptationBase();
+    
+    /** Returns the number of threads which evaluate the energy. */
+    std::size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads which evaluate the energy to \em n_threads. If \em n_threads is greater than 1 the energy must implement EnergyInterface::clone(). If the library was compiled without OpenMP support, the candidates are evaluated serially. */
+    void set_n_threads(std::size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    /** Returns the seed of the random number streams. */
+    unsigned long seed() const { return _seed; }
+    
+    /** Sets the seed of the random number streams to \em seed and restarts the generation count. By default the seed is drawn from uniform_distribution(). */
+    void set_seed(unsigned long seed) { _seed = seed; _n_generations = 0; restart_generations(); }
+    
+    /** Returns the number of generations computed since construction or the last call to set_seed(). */
+    unsigned long n_generations() const { return _n_generations; }
+    
+    /** Returns the population size. */
+    std::size_t lambda() const { return _lambda; }
+    
+    /** Returns the current step size. */
+    float_t sigma() const { return _sigma; }
+    
+    /** Returns the threshold of the update below which the minimization stops. */
+    float_t min_update() const { return _min_update; }
+    
+    /** Returns the current evolution path of the step size. */
+    const ublas::vector<float_t> & sigma_path() const { return _p_sigma; }
+    
+    /** Returns the current evolution path of the covariance matrix. */
+    const ublas::vector<float_t> & covariance_path() const { return _p_c; }
+
+    bool minimize(size_t n_max_steps, size_t & n_actual_steps);
+  };
+
+}
+
+#endif
@@ -69,6 +69,12 @@ namespace imaging
     {
       return _current_gradient;
     }
+    
+    /** Returns a copy of this adaptor (cf. FunctionalAdaptor::clone()). */
+    EnergyInterface * clone() const
+    {
+      return new DifferentiableFunctionalAdaptor<functional_t>(*this);
+    }
   };
 }
 
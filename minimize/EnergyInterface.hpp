@@ -28,6 +28,8 @@ namespace imaging
       \brief Abstract class interface for energies depending on vector valued input data.
       
       Classes implementing EnergyInterface always have a current argument which can be directly accessed from the outside. It is only when set_argument() is called that the energy value for the current argument is computed. In other words, instead of passing an argument to a member of the energy class the clients edit the argument inside the energy class and manually trigger its evaluation. This has the advantage that the argument has only to be stored once and is still always accesible from the outside. Minor modifications of the argument can be made without resetting it completely. Accessing the argument is expected to be cheap, only calls to set_argument() might be expensive.
+      
+      Energies which can be copied cheaply (compared to the effort of an evaluation) should implement clone(). This allows minimizers to evaluate several arguments concurrently on independent copies of the energy.
   */
   class EnergyInterface
   {
@@ -45,6 +47,9 @@ namespace imaging
     
     /** Returns the dimension the class expects as input data. The function current_argument() will return a vector of this dimension and the user should not change the size of this vector! */
     virtual std::size_t dimension() const = 0;
+    
+    /** Returns a new copy of the energy which can be evaluated independently of this object, e.g. by a different thread. The copy must be deleted by the caller. The default implementation returns 0, i.e. the energy can not be cloned. Parallel minimizers such as CovarianceMatrixAdaptation require this function to be implemented. */
+    virtual EnergyInterface * clone() const { return 0; }
   };
 }
 
@@ -66,6 +66,12 @@ namespace imaging
     {
       return _functional.dimension();
     }
+    
+    /** Returns a copy of this adaptor. The copy refers to the same functional as the original, i.e. the functional must support concurrent evaluations if the copy is used by a different thread. */
+    EnergyInterface * clone() const
+    {
+      return new FunctionalAdaptor<functional_t>(*this);
+    }
   };
 }
 
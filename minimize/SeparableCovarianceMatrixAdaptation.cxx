@@ -0,0 +1,74 @@
+#include <minimize/SeparableCovarianceMatrixAdaptation.hpp>
+
+#include <core/utilities.hpp>
+
+namespace imaging
+{
+  SeparableCovarianceMatrixAdaptation::SeparableCovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update) :
+      CovarianceMatrixAdaptationBase(energy, "SeparableCovarianceMatrixAdaptation")
+  {
+    size_t lambda = 4 + size_t(floor(3.0 * log(float_t(_energy.dimension()))));
+    init(sigma, min_update, lambda);
+    init_covariance();
+  }
+
+
+  SeparableCovarianceMatrixAdaptation::SeparableCovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update, std::size_t lambda) :
+      CovarianceMatrixAdaptationBase(energy, "SeparableCovarianceMatrixAdaptation")
+  {
+    init(sigma, min_update, lambda);
+    init_covariance();
+  }
+
+  void SeparableCovarianceMatrixAdaptation::init_covariance()
+  {
+    _C.resize(_n);
+    _D.resize(_n);
+
+    // the diagonal covariance matrix can be learned faster (Ros and Hansen)
+    _c_cov = min(1.0, _c_cov * (float_t(_n) + 2.0) / 3.0);
+
+    _C = ublas::scalar_vector<float_t>(_n, 1.0);
+  }
+
+  void SeparableCovarianceMatrixAdaptation::prepare_sampling()
+  {
+    for(std::size_t i = 0; i < _n; ++i)
+      _D(i) = sqrt(_C(i));
+  }
+
+  void SeparableCovarianceMatrixAdaptation::transform_sample(const ublas::vector<float_t> & z, ublas::vector<float_t> & y, ublas::vector<float_t> &) const
+  {
+    noalias(y) = element_prod(_D, z);
+  }
+
+  void SeparableCovarianceMatrixAdaptation::inverse_square_root_C(const ublas::vector<float_t> &, const ublas::vector<float_t> & z_w, ublas::vector<float_t> & result) const
+  {
+    // C^{-1/2} y_w = z_w
+    noalias(result) = z_w;
+  }
+
+  float_t SeparableCovarianceMatrixAdaptation::update_covariance(const std::vector< ublas::vector<float_t> > & y, const std::vector<std::size_t> & ranking, float_t delta_h_sigma)
+  {
+    // rank-one and rank-mu update of the diagonal of C
+    const float_t old_weight = 1.0 - _c_cov + _c_cov / _mu_cov * delta_h_sigma;
+    const float_t rank_one_weight = _c_cov / _mu_cov;
+    const float_t rank_mu_weight = _c_cov * ( 1.0 - 1.0 / _mu_cov );
+
+    float_t trace_C = 0.0;
+
+    for(std::size_t i = 0; i < _n; ++i)
+    {
+      float_t sum_squared_y = 0.0;
+
+      for(std::size_t l = 0; l < _mu; ++l)
+        sum_squared_y += _w(l) * square(y[ranking[l]](i));
+
+      _C(i) = old_weight * _C(i) + rank_one_weight * square(_p_c(i)) + rank_mu_weight * sum_squared_y;
+      trace_C += _C(i);
+    }
+
+    return trace_C;
+  }
+
+}
@@ -0,0 +1,69 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MINIMIZE_SEPARABLECOVARIANCEMATRIXADAPTATION_H
+#define MINIMIZE_SEPARABLECOVARIANCEMATRIXADAPTATION_H
+
+#include <minimize/CovarianceMatrixAdaptationBase.hpp>
+
+namespace imaging
+{
+  /** \ingroup minimize
+      \brief Minimizes energies using separable covariance matrix adaptation (sep-CMA).
+      
+      This class implements the variant of CovarianceMatrixAdaptation in <em>Raymond Ros and Nikolaus Hansen, "A Simple Modification in CMA-ES Achieving Linear Time and Space Complexity"</em>. The covariance matrix of the search distribution is restricted to a diagonal matrix and its learning rate is increased by the factor \f$(n+2)/3\f$. Sampling a candidate and updating the distribution costs \f$O(n)\f$ operations and the memory requirements are \f$O(\lambda n)\f$. This makes the algorithm applicable to energies with thousands of parameters (e.g. shapes with many control points), but the minimization of non-separable energies may take more steps than with the full covariance matrix.
+      
+      The minimization can be started with this class and continued with a full covariance matrix by constructing a CovarianceMatrixAdaptation object from the SeparableCovarianceMatrixAdaptation object:
+  \code
+  img::SeparableCovarianceMatrixAdaptation separable_cma(energy, 1.0, 1e-4);
+  separable_cma.minimize(100, n_steps);
+  
+  img::CovarianceMatrixAdaptation cma(energy, separable_cma);
+  cma.minimize(1000, n_steps);
+  \endcode
+      
+      The parallel evaluation of the candidates and the random number streams work as in CovarianceMatrixAdaptation (see CovarianceMatrixAdaptationBase).
+  */
+  class SeparableCovarianceMatrixAdaptation : public CovarianceMatrixAdaptationBase
+  {
+    ublas::vector<float_t> _C;
+    ublas::vector<float_t> _D;
+    
+    void init_covariance();
+    
+  protected:
+    void prepare_sampling();
+    void transform_sample(const ublas::vector<float_t> & z, ublas::vector<float_t> & y, ublas::vector<float_t> & buffer) const;
+    void inverse_square_root_C(const ublas::vector<float_t> & y_w, const ublas::vector<float_t> & z_w, ublas::vector<float_t> & result) const;
+    float_t update_covariance(const std::vector< ublas::vector<float_t> > & y, const std::vector<std::size_t> & ranking, float_t delta_h_sigma);
+  
+  public:
+    /** Construct a sep-CMA object to minimize \em energy. The parameters are the same as in CovarianceMatrixAdaptation::CovarianceMatrixAdaptation(EnergyInterface &, float_t, float_t, std::size_t). */
+    SeparableCovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update, std::size_t lambda);  
+      
+    /** Construct a sep-CMA object to minimize \em energy. The parameters are the same as in CovarianceMatrixAdaptation::CovarianceMatrixAdaptation(EnergyInterface &, float_t, float_t). */
+    SeparableCovarianceMatrixAdaptation(EnergyInterface & energy, float_t sigma, float_t min_update); 
+    
+    /** Returns the diagonal of the current covariance matrix. */
+    const ublas::vector<float_t> & covariance_diagonal() const { return _C; }
+  };
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include <minimize/SteepestDescent.hpp>
 #include <minimize/Lbfgs.hpp>
 #include <minimize/CovarianceMatrixAdaptation.hpp>
+#include <minimize/SeparableCovarianceMatrixAdaptation.hpp>
 #include <minimize/NlCg.hpp>
 #include <core/DifferentiableFunctionalInterface.hpp>
 #include <minimize/DifferentiableFunctionalAdaptor.hpp>
@@ -64,9 +65,10 @@ int main ( int argc, char **argv )
     Lbfgs lbfgs(functional_adaptor, epsilon);
     CovarianceMatrixAdaptation cma(functional_adaptor, 1.0, epsilon);
     NlCg nlcg(functional_adaptor, epsilon);
+    SeparableCovarianceMatrixAdaptation separable_cma(functional_adaptor, 1.0, epsilon);
     
-    std::vector<std::string> labels(4);
-    std::vector<MinimizerInterface *> minimizers(4);
+    std::vector<std::string> labels(5);
+    std::vector<MinimizerInterface *> minimizers(5);
     
     labels[0] = "Steepest Descent (gradient based)";
     minimizers[0] = & steepest_descent;
@@ -80,7 +82,10 @@ int main ( int argc, char **argv )
     labels[3] = "NL CG (nonlinear conjugated gradient, Fletcher-Reeves)";
     minimizers[3] = & nlcg;
     
-    for(std::size_t i = 0; i < 4; ++i)
+    labels[4] = "sep-CMA (evolutionary algorithm, diagonal covariance)";
+    minimizers[4] = & separable_cma;
+    
+    for(std::size_t i = 0; i < 5; ++i)
     {
       bool terminated;
       img::size_t n_actual_steps;
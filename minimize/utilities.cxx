@@ -0,0 +1,47 @@
+#include <minimize/utilities.hpp>
+
+#include <core/utilities.hpp>
+
+#include <algorithm>
+
+namespace imaging
+{
+  float_t finite_difference_derivative(EnergyInterface & energy, const ublas::vector<float_t> & direction, float_t step)
+  {
+    if(direction.size() != energy.dimension())
+      throw Exception("Exception: Dimensions of direction and energy argument do not agree in finite_difference_derivative().");
+      
+    if(step <= 0.0)
+      throw Exception("Exception: Non-positive step in finite_difference_derivative().");
+      
+    ublas::vector<float_t> argument = energy.current_argument();
+    
+    energy.current_argument() = argument + step * direction;
+    energy.set_argument();
+    float_t forward_energy = energy.current_energy();
+    
+    energy.current_argument() = argument - step * direction;
+    energy.set_argument();
+    float_t backward_energy = energy.current_energy();
+    
+    energy.current_argument() = argument;
+    energy.set_argument();
+    
+    return (forward_energy - backward_energy) / (2.0 * step);
+  }
+  
+  float_t gradient_error(DifferentiableEnergyInterface & energy, const ublas::vector<float_t> & direction, float_t step)
+  {
+    float_t difference_derivative = finite_difference_derivative(energy, direction, step);
+    
+    energy.set_argument_with_gradient();
+    float_t gradient_derivative = inner_prod(energy.current_gradient(), direction);
+    
+    float_t scale = std::max(abs(difference_derivative), abs(gradient_derivative));
+    
+    if(scale == 0.0)
+      return 0.0;
+      
+    return abs(gradient_derivative - difference_derivative) / scale;
+  }
+}
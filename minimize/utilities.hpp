@@ -0,0 +1,43 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MINIMIZE_UTILITIES_H
+#define MINIMIZE_UTILITIES_H
+
+#include <minimize/DifferentiableEnergyInterface.hpp>
+
+
+namespace imaging
+{
+  /** \ingroup minimize
+      <tt>\#include <minimize/utilities.hpp></tt>
+      
+      Returns the central finite difference <tt>(E(x + h d) - E(x - h d)) / 2h</tt> of \em energy at its current argument \em x in the direction \em d = \em direction with the step \em h = \em step. The energy is evaluated by set_argument(). Upon return the current argument of \em energy is restored and set_argument() has been called for it.
+  */
+  float_t finite_difference_derivative(EnergyInterface & energy, const ublas::vector<float_t> & direction, float_t step);
+  
+  /** \ingroup minimize
+      <tt>\#include <minimize/utilities.hpp></tt>
+      
+      Compares the gradient of \em energy at its current argument to the finite differences of the energy values. Returns the absolute difference of the directional derivative <tt>\<gradient, direction\></tt> and finite_difference_derivative(energy, direction, step) relative to the larger of both absolute values. The energy and its gradient are recomputed for the current argument upon return. Use this function to verify the implementation of set_argument_with_gradient().
+  */
+  float_t gradient_error(DifferentiableEnergyInterface & energy, const ublas::vector<float_t> & direction, float_t step);
+}
+
+#endif
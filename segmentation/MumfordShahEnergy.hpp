@@ -28,9 +28,37 @@
 #include <shape/ShapeEnergyInterface.hpp>
 #include <minimize/DifferentiableEnergyInterface.hpp>
 
+#include <boost/shared_ptr.hpp>
+
 
 namespace imaging 
 {
+  /** \cond */
+  namespace mumford_shah_energy_impl
+  {
+    // the sum of 1 along an axis, i.e. the scalar divergence field of the constant image 1
+    template <std::size_t N>
+    class volume_prefix_image
+    {
+      ublas::fixed_vector<size_t, N> _size;
+      std::size_t _axis;
+      
+    public:
+      static const std::size_t dimension = N;
+      typedef float_t data_t;
+      
+      volume_prefix_image(const ublas::fixed_vector<size_t, N> & size, std::size_t axis) : _size(size), _axis(axis) {}
+      
+      float_t operator[](const ublas::fixed_vector<size_t, N> & index) const { return float_t(index(_axis) + 1); }
+      
+      const ublas::fixed_vector<size_t, N> & size() const { return _size; }
+    };
+    
+    template <std::size_t N>
+    const std::size_t volume_prefix_image<N>::dimension;
+  }
+  /** \endcond */
+  
   /** \ingroup segmentation
       \brief Simplified Mumford-Shah energy for arbitrary shape classes.
       
@@ -56,16 +84,40 @@ namespace imaging
       \f[
       v \mapsto I_\beta^{\textrm{SMS}}\big(\textrm{Exp}_\mu(v)\big)\,. 
       \f]
+      
+      The region integrals are computed as flux integrals over the shape boundary by the divergence theorem. By default the energy stores three vector fields and a copy of the image for this purpose, i.e. <tt>3N + 1</tt> values per pixel (storage mode VECTOR_FIELD_STORAGE). If the energy is constructed with the storage mode PREFIX_IMAGE_STORAGE it stores the sums of the image and of its square along the first axis instead (cf. compute_divergence_field(const float_accessor_t &, size_t, scalar_accessor_t &)). The field of the volume is known analytically and the image values are recovered from the differences of neighbouring sums. This mode requires 2 values per pixel and its fields are computed in a single linear and parallel pass. The energies of both modes differ slightly because the flux integrals are discretized differently. The stored fields are shared by the copies returned by clone().
+      
+      If the boundary discretizer of \em shape_t provides shape derivatives (see BoundaryDiscretizer::evaluate_derivatives()), set_argument_with_gradient() computes the gradient in a single pass over the boundary. This assumes that \f$\textrm{Exp}_\mu(v + w) = \textrm{Exp}_{\textrm{Exp}_\mu(v)}(w)\f$, which holds for BsplineShape and Circle. Otherwise the gradient is approximated by finite differences, which requires <tt>dimension() + 1</tt> evaluations of the shape boundary.
+      
+      In both cases the gradient is the shape derivative \f$\int_{\partial\mathcal{I}} \big((u_1 - f)^2 - (u_2 - f)^2\big)\, \langle n, \delta x \rangle\, ds\f$ of the region terms plus the derivative of the boundary term, discretized at the integration points of the boundary. It approximates the derivative of the energy computed by set_argument(). Because the stored fields are sampled at pixel positions the computed energy is piecewise constant on the scale of the pixels, i.e. finite differences of the energy agree with the gradient only for steps which move the boundary by about one pixel (see finite_difference_derivative() and the program segmentation/segmentation.cpp).
   */
   template <class shape_t>
   class MumfordShahEnergy : public DifferentiableEnergyInterface, public ShapeEnergyInterface<shape_t>
   {
     const static std::size_t N = shape_t::SHAPE_DIMENSION;
     
-    Image<N, ublas::fixed_vector<float_t, N> > _contrast_vector_field;
-    Image<N, ublas::fixed_vector<float_t, N> > _squared_contrast_vector_field;
-    Image<N, ublas::fixed_vector<float_t, N> > _volume_vector_field;
-    Image<N, float_t> _image;
+    // the axis along which the images are summed in PREFIX_IMAGE_STORAGE mode
+    const static std::size_t PREFIX_AXIS = 0;
+    
+  public:
+    /** The storage modes of the fields which are integrated over the shape boundary. */
+    enum storage_modes { VECTOR_FIELD_STORAGE, PREFIX_IMAGE_STORAGE };
+    
+  private:
+    // the fields which are integrated over the shape boundary, only the fields of the storage mode are used
+    struct stored_fields
+    {
+      Image<N, float_t> contrast_prefix;
+      Image<N, float_t> squared_contrast_prefix;
+      Image<N, ublas::fixed_vector<float_t, N> > contrast_vector_field;
+      Image<N, ublas::fixed_vector<float_t, N> > squared_contrast_vector_field;
+      Image<N, ublas::fixed_vector<float_t, N> > volume_vector_field;
+      Image<N, float_t> image;
+    };
+    
+    storage_modes _storage_mode;
+    // the fields are not modified after the construction and shared by clones
+    boost::shared_ptr<const stored_fields> _fields;
     float_t _beta;
     std::size_t _n_integration_points;
     
@@ -80,15 +132,22 @@ namespace imaging
     float_t _squared_image_contrast;
     
     void compute_energy(float_t & u_1, float_t & u_2, float_t & energy);
+    bool image_value(const ublas::fixed_vector<float_t, N> & point, float_t & value) const;
+    void compute_analytic_gradient(const BoundaryDiscretizer<N> & discretizer, float_t u_1, float_t u_2);
+    void compute_finite_difference_gradient(const BoundaryDiscretizer<N> & discretizer, float_t u_1, float_t u_2);
        
   public:
   
-    /** Constructs a MumfordShahEnergy energy object from an image accessor and shape statistics. */
+    /** Constructs a MumfordShahEnergy energy object from an image accessor and shape statistics. The fields which are integrated over the shape boundary are stored as specified by \em storage_mode. */
     template <class const_accessor_t>
     MumfordShahEnergy(const const_accessor_t & image,
                 const shape_t & initial_shape,
                 float_t beta,
-                std::size_t n_integration_points);
+                std::size_t n_integration_points,
+                storage_modes storage_mode = VECTOR_FIELD_STORAGE);
+    
+    /** Returns the storage mode of the fields which are integrated over the shape boundary. */
+    storage_modes storage_mode() const { return _storage_mode; }
     
     ublas::vector<float_t> & current_argument() { return _current_argument; }
     float_t current_energy() const { return _current_energy; }
@@ -99,6 +158,9 @@ namespace imaging
     
     void set_argument();
     void set_argument_with_gradient();
+    
+    /** Returns a copy of the energy object which shares the stored fields with this object. */
+    EnergyInterface * clone() const { return static_cast<DifferentiableEnergyInterface *>(new MumfordShahEnergy<shape_t>(*this)); }
   };
   
   template <class shape_t>
@@ -106,47 +168,88 @@ namespace imaging
   MumfordShahEnergy<shape_t>::MumfordShahEnergy(const const_accessor_t & image,
                 const shape_t & initial_shape,
                 float_t beta,
-                std::size_t n_integration_points) :
+                std::size_t n_integration_points,
+                storage_modes storage_mode) :
+    _storage_mode(storage_mode),
     _beta(beta),
     _initial_shape(initial_shape),
     _current_shape(initial_shape),
     _n_integration_points(n_integration_points),
     _current_argument(ublas::scalar_vector<float_t>(initial_shape.dimension(), 0.0)),
-    _current_gradient(initial_shape.dimension()),
-    _contrast_vector_field(image.size()),
-    _squared_contrast_vector_field(image.size()),
-    _volume_vector_field(image.size()),
-    _image(image)
+    _current_gradient(initial_shape.dimension())
   {
-    Image<N, float_t> squared_image(_image.size());
-    ublas::fixed_vector<size_t, N> index;
-    index.assign(0);
-    do
-    {
-      squared_image[index] = square(_image[index]);
-    }
-    while(increment_index(_image.size(), index));
-  
-    compute_divergence_field(image, _contrast_vector_field);
-    compute_divergence_field(squared_image, _squared_contrast_vector_field);
-    compute_divergence_field(ScalarImage<N, float_t>(image.size(), 1.0), _volume_vector_field);
+    boost::shared_ptr<stored_fields> fields(new stored_fields);
     
     _image_volume = 1.0;
     
     for(std::size_t i = 0; i < N; ++i)
       _image_volume *= float_t(image.size()(i));
       
+    if(_storage_mode == PREFIX_IMAGE_STORAGE)
+    {
+      fields->contrast_prefix = image;
+      fields->squared_contrast_prefix.resize(image.size());
+      
+      float_t * pixels = fields->contrast_prefix.data();
+      float_t * squared_pixels = fields->squared_contrast_prefix.data();
+      const long n_pixels = long(fields->contrast_prefix.n_pixels());
+      
+      #pragma omp parallel for if(n_pixels >= image_impl::PARALLEL_TRAVERSAL_SIZE)
+      for(long i = 0; i < n_pixels; ++i)
+        squared_pixels[i] = square(pixels[i]);
+        
+      compute_divergence_field(fields->contrast_prefix, PREFIX_AXIS, fields->contrast_prefix);
+      compute_divergence_field(fields->squared_contrast_prefix, PREFIX_AXIS, fields->squared_contrast_prefix);
+      
+      // the sums of the last pixels along the prefix axis are the sums over the whole image,
+      // because PREFIX_AXIS is the first axis these pixels are stored at the end of the image
+      _image_contrast = 0.0;
+      _squared_image_contrast = 0.0;
+      
+      if(n_pixels > 0)
+      {
+        const std::size_t n_last = fields->contrast_prefix.n_pixels() / image.size()(PREFIX_AXIS);
+        const std::size_t first_last = fields->contrast_prefix.n_pixels() - n_last;
+        
+        for(std::size_t i = first_last; i < std::size_t(n_pixels); ++i)
+        {
+          _image_contrast += pixels[i];
+          _squared_image_contrast += squared_pixels[i];
+        }
+      }
+      
+      _fields = fields;
+      set_argument_with_gradient();
+      return;
+    }
+    
+    fields->contrast_vector_field.resize(image.size());
+    fields->squared_contrast_vector_field.resize(image.size());
+    fields->volume_vector_field.resize(image.size());
+    fields->image = image;
+    
+    Image<N, float_t> squared_image(fields->image.size());
+    
+    // fields->image and squared_image are traversed linearly
+    const float_t * pixels = fields->image.data();
+    float_t * squared_pixels = squared_image.data();
+    const std::size_t n_pixels = fields->image.n_pixels();
+    
     _image_contrast = 0.0;
     _squared_image_contrast = 0.0;
     
-    index.assign(0);
-    do
+    for(std::size_t i = 0; i < n_pixels; ++i)
     {
-      _image_contrast += _image[index];
-      _squared_image_contrast += squared_image[index];
+      squared_pixels[i] = square(pixels[i]);
+      _image_contrast += pixels[i];
+      _squared_image_contrast += squared_pixels[i];
     }
-    while(increment_index(_image.size(), index));
-                                                        
+  
+    compute_divergence_field(image, fields->contrast_vector_field);
+    compute_divergence_field(squared_image, fields->squared_contrast_vector_field);
+    compute_divergence_field(ScalarImage<N, float_t>(image.size(), 1.0), fields->volume_vector_field);
+    
+    _fields = fields;
     set_argument_with_gradient();
   }
   
@@ -161,60 +264,116 @@ namespace imaging
   
   template <class shape_t>
   void MumfordShahEnergy<shape_t>::set_argument_with_gradient()
+  {
+    float_t u_1, u_2;
+    
+    compute_energy(u_1, u_2, _current_energy);
+    
+    std::auto_ptr< BoundaryDiscretizer<shape_t::SHAPE_DIMENSION> > discretizer = _current_shape.boundary_discretizer(_n_integration_points);
+
+    if(discretizer->has_derivatives())
+      compute_analytic_gradient(*discretizer, u_1, u_2);
+    else
+      compute_finite_difference_gradient(*discretizer, u_1, u_2);
+  }
+  
+  template <class shape_t>
+  bool MumfordShahEnergy<shape_t>::image_value(const ublas::fixed_vector<float_t, N> & point, float_t & value) const
+  {
+    // explicit cast of floating point values in "point" to pixel position!
+    ublas::fixed_vector<size_t, N> pixel_position = ublas::fixed_vector<size_t, N>(point);   
+    
+    if(_storage_mode == PREFIX_IMAGE_STORAGE)
+    {
+      for(std::size_t i = 0; i < N; ++i)
+      {
+        if( ! ( pixel_position(i) < _fields->contrast_prefix.size()(i) ) )
+          return false;
+      }
+      
+      value = _fields->contrast_prefix[pixel_position];
+      
+      if(pixel_position(PREFIX_AXIS) > 0)
+      {
+        pixel_position(PREFIX_AXIS) -= 1;
+        value -= _fields->contrast_prefix[pixel_position];
+      }
+      
+      return true;
+    }
+    
+    for(std::size_t i = 0; i < N; ++i)
+    {
+      if( ! ( pixel_position(i) < _fields->image.size()(i) ) )
+        return false;
+    }
+    
+    value = _fields->image[pixel_position];
+    
+    return true;
+  }
+  
+  template <class shape_t>
+  void MumfordShahEnergy<shape_t>::compute_analytic_gradient(const BoundaryDiscretizer<N> & discretizer, float_t u_1, float_t u_2)
+  {
+    ublas::fixed_vector<float_t, N> point, normal;
+    std::vector<std::size_t> parameters;
+    std::vector< ublas::fixed_vector<float_t, N> > point_derivatives, normal_derivatives;
+    float_t value;
+    
+    _current_gradient = ublas::scalar_vector<float_t>(dimension(), 0.0);
+    
+    // one pass over the boundary: each point contributes to the parameters it depends on
+    for(std::size_t j = 0; j < _n_integration_points; ++j)
+    {
+      point = discretizer(j, normal);
+      discretizer.evaluate_derivatives(j, parameters, point_derivatives, normal_derivatives);
+      
+      float_t image_factor = 0.0;
+      
+      if(image_value(point, value))
+        image_factor = square(u_1 - value) - square(u_2 - value);
+      
+      for(std::size_t l = 0; l < parameters.size(); ++l)
+        _current_gradient(parameters[l]) += image_factor * inner_prod(normal, point_derivatives[l]) +
+                                            2.0 * _beta * inner_prod(normal, normal_derivatives[l]);
+    }
+  }
+  
+  template <class shape_t>
+  void MumfordShahEnergy<shape_t>::compute_finite_difference_gradient(const BoundaryDiscretizer<N> & discretizer, float_t u_1, float_t u_2)
   {
     shape_t perturbed_shape;
     ublas::vector<float_t> perturbed_argument(dimension());
-    ublas::vector<float_t> statistics_gradient(dimension());
     const float_t FINITE_H = 0.001;
-    ublas::fixed_vector<float_t, shape_t::SHAPE_DIMENSION> point, normal;
-    float_t u_1, u_2;
+    ublas::fixed_vector<float_t, N> point, normal;
     
     perturbed_argument = _current_argument;
     _current_gradient = ublas::scalar_vector<float_t>(dimension(), 0.0);
     
-    compute_energy(u_1, u_2, _current_energy);
-    
-    std::auto_ptr< BoundaryDiscretizer<shape_t::SHAPE_DIMENSION> > discretizer = _current_shape.boundary_discretizer(_n_integration_points);
-
     for(std::size_t k = 0; k < dimension(); ++k)
     {
       perturbed_argument(k) += FINITE_H;
       
       _initial_shape.exponential(perturbed_argument, perturbed_shape);
       
-      std::auto_ptr< BoundaryDiscretizer<shape_t::SHAPE_DIMENSION> > perturbed_discretizer = perturbed_shape.boundary_discretizer(_n_integration_points);
+      std::auto_ptr< BoundaryDiscretizer<N> > perturbed_discretizer = perturbed_shape.boundary_discretizer(_n_integration_points);
 
-      ublas::fixed_vector<float_t, shape_t::SHAPE_DIMENSION> perturbed_point, perturbed_normal, shape_derivative, shape_normal_derivative;
-      float_t image_value;
+      ublas::fixed_vector<float_t, N> perturbed_point, perturbed_normal, shape_derivative, shape_normal_derivative;
+      float_t value;
   
       for(std::size_t j = 0; j < _n_integration_points; ++j)
       {
         perturbed_point = (*perturbed_discretizer)(j, perturbed_normal);
-        point = (*discretizer)(j, normal);
+        point = discretizer(j, normal);
         
         shape_derivative = 1.0 / FINITE_H * (perturbed_point - point);
         shape_normal_derivative = 1.0 / FINITE_H * (perturbed_normal - normal);
         
-        // explicit cast of floating point values in "point" to pixel position!
-        ublas::fixed_vector<size_t, N> pixel_position = ublas::fixed_vector<size_t, N>(point);   
-        bool is_valid_pixel = true;
-        
-        for(std::size_t i = 0; i < N; ++i)
-        {
-          if( ! ( pixel_position(i) < _image.size()(i) ) )
-          {
-            is_valid_pixel = false;
-            break;
-          }
-        }
-        
-        if(is_valid_pixel)
+        if(image_value(point, value))
         {
-        
-          image_value = _image[pixel_position];
-          
-          _current_gradient(k) += ( square(u_1 - image_value) - square(u_2 - image_value) ) *
-                                  inner_prod(normal, shape_derivative) * sqrt(norm_2(normal));
+          _current_gradient(k) += ( square(u_1 - value) - square(u_2 - value) ) *
+                                  inner_prod(normal, shape_derivative);
         }
         _current_gradient(k) += 2.0 * _beta * inner_prod(normal, shape_normal_derivative);
       }  
@@ -236,12 +395,21 @@ namespace imaging
     
     std::auto_ptr< BoundaryDiscretizer<shape_t::SHAPE_DIMENSION> > discretizer = _current_shape.boundary_discretizer(_n_integration_points);
     
-    inner_contrast = discretizer->integrate_vector_field(_contrast_vector_field);
-    inner_squared_contrast = discretizer->integrate_vector_field(_squared_contrast_vector_field);
-    inner_volume = discretizer->integrate_vector_field(_volume_vector_field);
+    if(_storage_mode == PREFIX_IMAGE_STORAGE)
+    {
+      inner_contrast = discretizer->integrate_vector_field(_fields->contrast_prefix, PREFIX_AXIS);
+      inner_squared_contrast = discretizer->integrate_vector_field(_fields->squared_contrast_prefix, PREFIX_AXIS);
+      inner_volume = discretizer->integrate_vector_field(mumford_shah_energy_impl::volume_prefix_image<N>(_fields->contrast_prefix.size(), PREFIX_AXIS), PREFIX_AXIS);
+    }
+    else
+    {
+      inner_contrast = discretizer->integrate_vector_field(_fields->contrast_vector_field);
+      inner_squared_contrast = discretizer->integrate_vector_field(_fields->squared_contrast_vector_field);
+      inner_volume = discretizer->integrate_vector_field(_fields->volume_vector_field);
+    }
     
     outer_contrast = _image_contrast - inner_contrast;
-    outer_squared_contrast = _squared_image_contrast - outer_squared_contrast;
+    outer_squared_contrast = _squared_image_contrast - inner_squared_contrast;
     outer_volume = _image_volume - inner_volume;
     
     u_1 = inner_contrast / inner_volume;
@@ -26,6 +26,7 @@
 #include <shape/BoundaryDiscretizer.hpp>
 
 #include <set>
+#include <boost/shared_ptr.hpp>
 
 
 namespace imaging
@@ -60,7 +61,8 @@ namespace imaging
   {
     const static std::size_t SHAPE_DIMENSION = shape_t::SHAPE_DIMENSION;
     
-    Image<SHAPE_DIMENSION, float_t> _edge_map;
+    // the edge map is not modified after the construction and shared by clones
+    boost::shared_ptr< const Image<SHAPE_DIMENSION, float_t> > _edge_map;
     float_t _beta;
     std::size_t _n_integration_points;
     
@@ -76,7 +78,7 @@ namespace imaging
                  const shape_t & initial_shape,
                  float_t beta,
                  std::size_t n_integration_points) :
-    _edge_map(edge_map),
+    _edge_map(new Image<SHAPE_DIMENSION, float_t>(edge_map)),
     _initial_shape(initial_shape), 
     _beta(beta),
     _n_integration_points(n_integration_points),
@@ -115,11 +117,17 @@ namespace imaging
       std::auto_ptr< BoundaryDiscretizer<shape_t::SHAPE_DIMENSION> > edge_map_discretizer = _current_shape.boundary_discretizer(_n_integration_points);
 
       boundary_area = edge_map_discretizer->compute_boundary_area();
-      edge_energy = edge_map_discretizer->integrate(_edge_map);
+      edge_energy = edge_map_discretizer->integrate(*_edge_map);
       
       _current_energy = - edge_energy + _beta * boundary_area;
                     
     }           
+    
+    /** Returns a copy of the energy object which shares the edge map with this object. */
+    EnergyInterface * clone() const
+    {
+      return new SnakesEnergy<shape_t>(*this);
+    }
   };
 }
 
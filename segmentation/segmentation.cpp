@@ -0,0 +1,93 @@
+#include <segmentation/MumfordShahEnergy.hpp>
+#include <minimize/utilities.hpp>
+#include <shape/Circle.hpp>
+#include <shape/BsplineShape.hpp>
+#include <image/Image.hpp>
+
+#include <core/utilities.hpp>
+
+using namespace imaging;
+
+const img::float_t STEP = 1.0;
+const img::float_t TOLERANCE = 0.1;
+
+template <class shape_t>
+bool check_gradient(const std::string & label, const Image<2, img::float_t> & image, const shape_t & shape,
+                    const ublas::vector<img::float_t> & direction, typename MumfordShahEnergy<shape_t>::storage_modes storage_mode)
+{
+  MumfordShahEnergy<shape_t> energy(image, shape, 0.01, 400, storage_mode);
+  
+  // MumfordShahEnergy inherits EnergyInterface twice
+  DifferentiableEnergyInterface & differentiable_energy = energy;
+  
+  img::float_t difference_derivative = finite_difference_derivative(differentiable_energy, direction, STEP);
+  img::float_t error = gradient_error(differentiable_energy, direction, STEP);
+  
+  std::cout << label << ": " << inner_prod(energy.current_gradient(), direction) 
+            << " (gradient), " << difference_derivative 
+            << " (finite differences), relative error " << error << std::endl;
+  
+  return error < TOLERANCE;
+}
+
+int main ( int argc, char **argv )
+{
+  try
+  {
+    // a disk of radius 30 around (60, 70)
+    Image<2, img::float_t> image(ublas::fixed_vector<img::size_t, 2>(128, 128));
+    
+    for(img::size_t x = 0; x < 128; ++x)
+      for(img::size_t y = 0; y < 128; ++y)
+        image[ublas::fixed_vector<img::size_t, 2>(x, y)] = square(img::float_t(x) - 60.0) + square(img::float_t(y) - 70.0) < 900.0 ? 1.0 : 0.0;
+    
+    // the initial shapes are slightly smaller and displaced
+    Circle circle(ublas::fixed_vector<img::float_t, 2>(62.0, 66.0), 25.0);
+    
+    PeriodicBspline< ublas::fixed_vector<img::float_t, 2> > curve(4, 16);
+    curve.regular_knots(0.0, 1.0);
+    for(img::size_t i = 0; i < 16; ++i)
+      curve.set_coefficient(i, ublas::fixed_vector<img::float_t, 2>(62.0 + 25.0 * cos(2.0 * PI * i / 16.0), 66.0 - 25.0 * sin(2.0 * PI * i / 16.0)));
+    BsplineShape bspline_shape(curve);
+    
+    // the directions mainly grow the shapes, the energy changes by much less along random directions;
+    // the radius of the circle is parametrized logarithmically, i.e. 0.04 corresponds to one pixel
+    ublas::vector<img::float_t> circle_direction(3);
+    circle_direction(0) = -0.3;
+    circle_direction(1) = 0.6;
+    circle_direction(2) = 0.04;
+    
+    ublas::vector<img::float_t> bspline_direction(32);
+    for(img::size_t i = 0; i < 16; ++i)
+    {
+      bspline_direction(2 * i) = cos(2.0 * PI * i / 16.0) * (1.0 + 0.5 * sin(3.0 * i));
+      bspline_direction(2 * i + 1) = - sin(2.0 * PI * i / 16.0) * (1.0 + 0.5 * cos(2.0 * i));
+    }
+    bspline_direction /= norm_2(bspline_direction);
+    
+    std::cout << "Gradients of the Mumford-Shah energy compared to finite differences (step " << STEP << ")\n" << std::endl;
+    
+    bool passed = true;
+    
+    passed &= check_gradient("Circle, vector fields", image, circle, circle_direction, MumfordShahEnergy<Circle>::VECTOR_FIELD_STORAGE);
+    passed &= check_gradient("Circle, prefix images", image, circle, circle_direction, MumfordShahEnergy<Circle>::PREFIX_IMAGE_STORAGE);
+    passed &= check_gradient("B-spline, vector fields", image, bspline_shape, bspline_direction, MumfordShahEnergy<BsplineShape>::VECTOR_FIELD_STORAGE);
+    passed &= check_gradient("B-spline, prefix images", image, bspline_shape, bspline_direction, MumfordShahEnergy<BsplineShape>::PREFIX_IMAGE_STORAGE);
+    
+    if(! passed)
+    {
+      std::cerr << "The gradients differ from the finite differences by more than " << TOLERANCE << "." << std::endl;
+      
+      return EXIT_FAILURE;
+    }
+  }
+
+  catch ( Exception &exception )
+  {
+    std::cerr << exception.error_msg() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
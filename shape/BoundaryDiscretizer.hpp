@@ -22,6 +22,8 @@
 
 #include <shape/Box.hpp>
 
+#include <vector>
+
 namespace imaging
 {
   /** \cond */
@@ -75,6 +77,8 @@ namespace imaging
       \brief Abstract class interface for discretizations of shape boundaries. 
       
       Objects derived from this class can be evaluated in a finite number of sample points on the boundary of a shape. In addition to the coordinates of the sample point they must provide the outer normal in that point. The length of the normal must be such that the lengthes of all normals sum up to the area of the shape boundary. In other words, the length of the normal corresponds to the area of the infinitesimal boundary element around the normal.
+      
+      Optionally, a discretizer can provide the derivatives of the sample points and normals with respect to the shape parameters (see has_derivatives() and evaluate_derivatives()). Energies such as MumfordShahEnergy use them to compute their gradients analytically instead of by finite differences.
   */
   template <size_t N>
   class BoundaryDiscretizer
@@ -98,6 +102,17 @@ namespace imaging
     /** Sets \em point to the coordinates of the <em>i</em>-th disretization point and stores the boundary normal in this point in \em normal. The normal must be scaled to the area of the infinitesimal boundary element around the point. This function must be implemented in classes derived from BoundaryDiscretizer. For the actual evaluation of a discretization point the user should use operator(). */ 
     virtual void evaluate(size_t i, ublas::fixed_vector<float_t, SHAPE_DIMENSION> & point, ublas::fixed_vector<float_t, SHAPE_DIMENSION> & normal, float_t & curvature) const = 0;
     
+    /** Returns true if the discretizer provides the derivatives of its discretization points and normals with respect to the shape parameters (see evaluate_derivatives()). The default implementation returns false. */
+    virtual bool has_derivatives() const { return false; }
+    
+    /** Computes the derivatives of the <em>i</em>-th discretization point and its (scaled) normal with respect to the parameters of the discretized shape. The parameters are the components of the vector passed to ShapeInterface::exponential() of the discretized shape and the derivatives are evaluated at the zero vector. Only parameters with possibly non-zero derivatives are reported: after the call \em parameters contains the indices of these parameters, and \em point_derivatives and \em normal_derivatives contain the corresponding derivatives of the point and the normal. An index can occur more than once, in which case the derivatives must be added. The vectors are resized by this function; they should be reused by the caller to avoid memory allocations. 
+    
+    This function must be implemented if has_derivatives() returns true. The default implementation throws an exception. */
+    virtual void evaluate_derivatives(size_t i, std::vector<size_t> & parameters, std::vector< ublas::fixed_vector<float_t, SHAPE_DIMENSION> > & point_derivatives, std::vector< ublas::fixed_vector<float_t, SHAPE_DIMENSION> > & normal_derivatives) const
+    {
+      throw Exception("Exception: Shape derivatives are not implemented in BoundaryDiscretizer::evaluate_derivatives().");
+    }
+    
     /** Evaluates the coordinates of the <em>i</em>-th discretization point, sets \em normal to the boundary normal and \em curvature to the curvature in this point. The normal is scaled to the area of the infinitesimal boundary element around the point. */
     ublas::fixed_vector<float_t, SHAPE_DIMENSION> operator()(size_t i, ublas::fixed_vector<float_t, SHAPE_DIMENSION> & normal, float_t & curvature) const
     {
@@ -207,7 +222,67 @@ namespace imaging
       return result;
     }
     
+    /** Integrates the vector field \f$F \vec e_a\f$ over a boundary discretization, where \f$a\f$ equals \em axis and \f$\vec e_a\f$ is the <em>a</em>-th unit vector. I.e. only the <em>a</em>-th component of the normals contributes. The scalar function \f$F\f$ is the integral along \em axis of a pixelwise constant function \f$f\f$, and \em scalar_field contains its values at the upper boundaries of the pixels, i.e. the sums of \f$f\f$ along \em axis as computed by compute_divergence_field(const float_accessor_t &, size_t, scalar_accessor_t &). Within a pixel \f$F\f$ is interpolated linearly along \em axis, which is exact for pixelwise constant functions. Outside of \em scalar_field the field is extended in the same way as in integrate_vector_field(const const_vector_accessor_t &): beyond the upper boundary of \em axis it is constant along \em axis and otherwise it is 0. */
+    template <class const_scalar_accessor_t>
+    float_t integrate_vector_field(const const_scalar_accessor_t & scalar_field, size_t axis) const
+    {
+      float_t result = 0.0;
+      ublas::fixed_vector<float_t, SHAPE_DIMENSION> point, normal;
+      ublas::fixed_vector<size_t, const_scalar_accessor_t::dimension> pixel_position;
+
+      for(size_t i = 0; i < n_points(); ++i)
+      {
+        point = (*this)(i, normal);
+        bool is_valid_pixel = true;
+        bool is_beyond_axis = false;
+        
+        for(size_t j = 0; j < const_scalar_accessor_t::dimension; ++j)
+        {
+          // explicit cast of floating point values in "point" to pixel position!
+          if(point(j) < 0.0)
+            is_valid_pixel = false;
+          else
+          {
+            pixel_position(j) = size_t(point(j));
             
+            if( ! ( pixel_position(j) < scalar_field.size()(j) ) )
+            {
+              if(j == axis)
+              {
+                pixel_position(j) = scalar_field.size()(j) - 1;
+                is_beyond_axis = true;
+              }
+              else
+                is_valid_pixel = false;
+            }
+          }
+        }
+        
+        if(! is_valid_pixel)
+          continue;
+          
+        float_t value = scalar_field[pixel_position];
+        
+        if(! is_beyond_axis)
+        {
+          // interpolate between the sum at the lower boundary of the pixel and the sum at its upper boundary
+          float_t t = point(axis) - float_t(pixel_position(axis));
+          float_t lower_value = 0.0;
+          
+          if(pixel_position(axis) > 0)
+          {
+            pixel_position(axis) -= 1;
+            lower_value = scalar_field[pixel_position];
+          }
+          
+          value = (1.0 - t) * lower_value + t * value;
+        }
+        
+        result += value * normal(axis);
+      }
+
+      return result;
+    }
     
     /** Compute the bounding box of a boundary discretization. */
     Box<SHAPE_DIMENSION> compute_bounding_box() const
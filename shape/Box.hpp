@@ -66,6 +66,12 @@ namespace imaging
       _upper_corner = accessor.size();
     }
     
+    /** Returns the lower corner of the box, i.e. the corner with the smallest coordinates. */
+    const ublas::fixed_vector<float_t, N> & lower_corner() const { return _lower_corner; }
+    
+    /** Returns the upper corner of the box, i.e. the corner with the largest coordinates. */
+    const ublas::fixed_vector<float_t, N> & upper_corner() const { return _upper_corner; }
+    
     /** Sets the box to the empty box. */
     void set_empty()
     {
@@ -51,6 +51,37 @@ namespace imaging
     curvature = boundary_discretizer_impl::compute_curve_curvature(tangent, second_derivative);
   }
   
+  void BsplineShape::Discretizer::evaluate_derivatives(size_t i, std::vector<size_t> & parameters, std::vector< ublas::fixed_vector<float_t, 2> > & point_derivatives, std::vector< ublas::fixed_vector<float_t, 2> > & normal_derivatives) const
+  {
+    const PeriodicBspline< ublas::fixed_vector<float_t, 2> > & curve = _spline_curve._curve;
+    ublas::vector<float_t> values, derivatives;
+    
+    size_t first = curve.basis_splines(i * _step_size, values, derivatives);
+    
+    parameters.resize(2 * values.size());
+    point_derivatives.resize(2 * values.size());
+    normal_derivatives.resize(2 * values.size());
+    
+    // the parameters 2j and 2j + 1 are the offsets of the j-th coefficient,
+    // the normal is the tangent rotated by 90 degrees
+    for(size_t j = 0; j < values.size(); ++j)
+    {
+      size_t coefficient = (first + j) % curve.n_coefficients();
+      
+      parameters[2 * j] = 2 * coefficient;
+      point_derivatives[2 * j](0) = values(j);
+      point_derivatives[2 * j](1) = 0.0;
+      normal_derivatives[2 * j](0) = 0.0;
+      normal_derivatives[2 * j](1) = _step_size * derivatives(j);
+      
+      parameters[2 * j + 1] = 2 * coefficient + 1;
+      point_derivatives[2 * j + 1](0) = 0.0;
+      point_derivatives[2 * j + 1](1) = values(j);
+      normal_derivatives[2 * j + 1](0) = - _step_size * derivatives(j);
+      normal_derivatives[2 * j + 1](1) = 0.0;
+    }
+  }
+  
   std::auto_ptr< BoundaryDiscretizer<2> > BsplineShape::boundary_discretizer(size_t n_points) const
   {
     return std::auto_ptr< BoundaryDiscretizer<2> >(new Discretizer(*this, n_points));
@@ -77,6 +77,10 @@ namespace imaging
     Discretizer(const BsplineShape  & spline_curve, size_t n_points);
     
     void evaluate(size_t i, ublas::fixed_vector<float_t, 2> & point, ublas::fixed_vector<float_t, 2> & normal, float_t & curvature) const;
+    
+    bool has_derivatives() const { return true; }
+    
+    void evaluate_derivatives(size_t i, std::vector<size_t> & parameters, std::vector< ublas::fixed_vector<float_t, 2> > & point_derivatives, std::vector< ublas::fixed_vector<float_t, 2> > & normal_derivatives) const;
   };
   /** \endcond */
   
@@ -61,6 +61,28 @@ namespace imaging
     curvature = 1.0 / _circle.radius();
   }
   
+  void Circle::Discretizer::evaluate_derivatives(size_t i, std::vector<size_t> & parameters, std::vector< ublas::fixed_vector<float_t, SHAPE_DIMENSION> > & point_derivatives, std::vector< ublas::fixed_vector<float_t, SHAPE_DIMENSION> > & normal_derivatives) const
+  {
+    parameters.resize(3);
+    point_derivatives.resize(3);
+    normal_derivatives.resize(3);
+    
+    // the center is translated by the first two parameters, the normals do not change
+    for(size_t k = 0; k < 2; ++k)
+    {
+      parameters[k] = k;
+      point_derivatives[k].assign(0.0);
+      point_derivatives[k](k) = 1.0;
+      normal_derivatives[k].assign(0.0);
+    }
+    
+    // the radius is scaled by exp() of the third parameter
+    parameters[2] = 2;
+    point_derivatives[2](0) = _circle.radius() * cos(i * _step_size);
+    point_derivatives[2](1) = _circle.radius() * sin(i * _step_size);
+    normal_derivatives[2] = _step_size * point_derivatives[2];
+  }
+  
   std::auto_ptr< BoundaryDiscretizer<2> > Circle::boundary_discretizer(size_t n_points) const
   {
     return std::auto_ptr< BoundaryDiscretizer<2> >(new Discretizer(*this, n_points));
@@ -82,6 +82,10 @@ namespace imaging
     Discretizer(const Circle & circle, size_t n_points);
 
     void evaluate (size_t i, ublas::fixed_vector<float_t, SHAPE_DIMENSION> & point, ublas::fixed_vector<float_t, SHAPE_DIMENSION> & normal, float_t & curvature) const;
+    
+    bool has_derivatives() const { return true; }
+    
+    void evaluate_derivatives(size_t i, std::vector<size_t> & parameters, std::vector< ublas::fixed_vector<float_t, SHAPE_DIMENSION> > & point_derivatives, std::vector< ublas::fixed_vector<float_t, SHAPE_DIMENSION> > & normal_derivatives) const;
   };
   /** \endcond */
 }
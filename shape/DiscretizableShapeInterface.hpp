@@ -38,6 +38,8 @@ namespace imaging
     return boundary_discretizer->integrate(image);
   }
   \endcode
+  
+      The boundary discretizers of some shapes (e.g. BsplineShape and Circle) also provide the derivatives of the discretization with respect to the shape parameters (see BoundaryDiscretizer::evaluate_derivatives()).
   */
   template <size_t N>
   class DiscretizableShapeInterface
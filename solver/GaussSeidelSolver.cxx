@@ -0,0 +1,56 @@
+#include <solver/GaussSeidelSolver.hpp>
+
+namespace imaging
+{
+  void GaussSeidelSolver::solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    if(eqs.size1() != eqs.size2() || eqs.size2() != rhs.size())
+      throw Exception("Exception: Dimensions do not agree in GaussSeidelSolver::solve().");
+      
+    const size_t size = rhs.size();
+    
+    if(result.size() != size)
+    {
+      result.resize(size);
+      result.clear();
+    }
+    
+    if(size == 0)
+      return;
+    
+    // rows with index larger than filled1() - 2 are empty
+    const size_t last_row = eqs.filled1() - 1;
+    const size_t * row_starts = & eqs.index1_data()[0];
+    const size_t * columns = & eqs.index2_data()[0];
+    const float_t * values = & eqs.value_data()[0];
+    
+    if(last_row < size)
+      throw Exception("Exception: Zero diagonal entry in GaussSeidelSolver::solve().");
+    
+    for(size_t iteration = 0; iteration < _n_iterations; ++iteration)
+    {
+      for(size_t sweep = 0; sweep < 2; ++sweep)
+      {
+        for(size_t n = 0; n < size; ++n)
+        {
+          const size_t i = sweep == 0 ? n : size - 1 - n;
+          float_t value = rhs(i);
+          float_t diagonal = 0.0;
+          
+          for(size_t pos = row_starts[i]; pos < row_starts[i + 1]; ++pos)
+          {
+            if(columns[pos] == i)
+              diagonal = values[pos];
+            else
+              value -= values[pos] * result(columns[pos]);
+          }
+          
+          if(diagonal == 0.0)
+            throw Exception("Exception: Zero diagonal entry in GaussSeidelSolver::solve().");
+            
+          result(i) = value / diagonal;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,44 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLVER_GAUSSSEIDELSOLVER_H
+#define SOLVER_GAUSSSEIDELSOLVER_H
+
+#include <solver/SolverInterface.hpp>
+
+namespace imaging
+{
+  /** \ingroup solver
+      \brief Symmetric Gauss-Seidel iteration.
+      
+      Each iteration consists of a forward and a backward Gauss-Seidel sweep over the rows of the compressed system matrix. The iteration starts from the current content of \em result if it has the dimension of the system and from zero otherwise. This class is mainly intended to be used as smoother in MultigridSolver. Because the forward and the backward sweep are adjoint to each other, a fixed number of iterations starting from zero defines a symmetric positive definite preconditioner for symmetric positive definite systems.
+  */
+  class GaussSeidelSolver : public SolverInterface
+  {
+    size_t _n_iterations;
+    
+  public:
+    /** Constructs a Gauss-Seidel solver which performs \em n_iterations symmetric sweeps. */
+    GaussSeidelSolver(size_t n_iterations = 1) : _n_iterations(n_iterations) {}
+    
+    void solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+  };
+}
+
+#endif
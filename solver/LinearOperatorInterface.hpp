@@ -0,0 +1,48 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLVER_LINEAROPERATORINTERFACE_H
+#define SOLVER_LINEAROPERATORINTERFACE_H
+
+#include <core/imaging2.hpp>
+
+namespace imaging
+{
+  /** \ingroup solver
+      \brief Abstract class interface for linear operators which are not stored as a matrix.
+      
+      Iterative solvers such as PcgSolver only need to apply the system matrix to vectors. Classes implementing this interface provide the action of a square matrix without storing it, e.g. MatrixFreeOperator evaluates the stiffness operator of a finite element discretization on the fly.
+  */
+  class LinearOperatorInterface
+  {
+  public:
+    virtual ~LinearOperatorInterface() {}
+    
+    /** Returns the number of rows (and columns) of the operator. */
+    virtual size_t size() const = 0;
+    
+    /** Applies the operator to \em x and writes the result to \em y. The vector \em y is resized to size() if necessary. */
+    virtual void apply(const ublas::vector<float_t> & x, ublas::vector<float_t> & y) const = 0;
+    
+    /** Writes the diagonal of the operator to \em diagonal. The vector \em diagonal is resized to size() if necessary. This is used by Jacobi preconditioners. */
+    virtual void diagonal(ublas::vector<float_t> & diagonal) const = 0;
+  };
+}
+
+#endif
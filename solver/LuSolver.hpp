@@ -21,6 +21,9 @@
 #define SOLVER_LUSOLVER_H
 
 #include <solver/SolverInterface.hpp>
+#include <solver/SpoolesFactorization.hpp>
+
+#include <boost/shared_ptr.hpp>
                     
 namespace imaging
 {                                      
@@ -28,13 +31,54 @@ namespace imaging
       \brief Wrapper class for the LU solver provided by SPOOLES.
       
       This class implements a conjugated gradients solver by interfacing <a href="http://www.netlib.org/linalg/spooles/spooles.2.2.html">SPOOLES</a>.
+      
+      The factorization is computed in three phases. analyze() computes a fill reducing ordering and the symbolic factorization of the sparsity pattern of a matrix, factorize() computes the numeric LU factorization of a matrix with this pattern and solve() solves the factorized system for one or several right hand sides. If only the values of the system matrix change from one solve to the next (e.g. in implicit time stepping on a fixed Grid) the symbolic analysis is performed once:
+  \code
+  img::LuSolver solver;
+  solver.analyze(stiffness_matrix);
+  
+  for(std::size_t i = 0; i < n_steps; ++i)
+  {
+    // assemble stiffness_matrix and force_vector...
+    solver.factorize(stiffness_matrix);
+    solver.solve(force_vector, solution);
+  }
+  \endcode
+  
+      LuSolver objects can be copied. A copy shares the factorization of the original until analyze() or factorize() is called on either of them. That object then starts with a new analysis, i.e. factorize() analyzes the pattern of its argument first.
   */
   class LuSolver : public SolverInterface
   {
-
+    boost::shared_ptr<SpoolesFactorization> _factorization;
+    
+    // the factorization which is not shared with copies of this object
+    SpoolesFactorization & unshared_factorization()
+    {
+      if(! _factorization.unique())
+        _factorization.reset(new SpoolesFactorization(false, "LuSolver"));
+        
+      return *_factorization;
+    }
+    
   public:
-    LuSolver() {}
+    LuSolver() : _factorization(new SpoolesFactorization(false, "LuSolver")) {}
+    
+    /** Computes the ordering and the symbolic factorization of the sparsity pattern of \em pattern. The values of \em pattern are ignored. This invalidates a previously computed factorization. */
+    void analyze(const ublas::compressed_matrix<float_t> & pattern) { unshared_factorization().analyze(pattern); }
+    
+    /** Computes the numeric factorization of \em eqs. If analyze() has not been called before, it is called for \em eqs. Otherwise the sparsity pattern of \em eqs must be the same as the analyzed pattern, else an Exception is thrown. */
+    void factorize(const ublas::compressed_matrix<float_t> & eqs) { unshared_factorization().factorize(eqs); }
+    
+    /** Returns true if factorize() has been called successfully, i.e. if solve() can be called without a system matrix. */
+    bool is_factorized() const { return _factorization->is_factorized(); }
+    
+    /** Solves the factorized system for the right hand side \em rhs and writes the solution to \em result. */
+    void solve(const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const { _factorization->solve(rhs, result); }
+    
+    /** Solves the factorized system for each column of \em rhs and writes the solutions to the corresponding columns of \em result. */
+    void solve(const ublas::matrix<float_t> & rhs, ublas::matrix<float_t> & result) const { _factorization->solve(rhs, result); }
     
+    /** Solves the system defined by \em eqs and \em rhs in a single step. This does not change the state of the solver, i.e. the ordering and factorization are recomputed for each call. */
     void solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
   };
 
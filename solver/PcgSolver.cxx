@@ -0,0 +1,376 @@
+#include <solver/PcgSolver.hpp>
+#include <core/MessageInterface.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+namespace imaging
+{
+  /* Computes matrix-vector products directly on the compressed row storage of a matrix. Rows with index larger than filled1() - 2 are empty. */
+  class PcgSolver::matrix_operator
+  {
+    const ublas::compressed_matrix<float_t> & _eqs;
+    size_t _n_threads;
+    
+  public:
+    matrix_operator(const ublas::compressed_matrix<float_t> & eqs, size_t n_threads) : _eqs(eqs), _n_threads(n_threads) {}
+    
+    size_t size() const { return _eqs.size1(); }
+    
+    void apply(const ublas::vector<float_t> & x, ublas::vector<float_t> & y) const
+    {
+      const long n_rows = long(_eqs.size1());
+      const long last_row = long(_eqs.filled1()) - 1;
+      const size_t * row_starts = & _eqs.index1_data()[0];
+      const size_t * columns = & _eqs.index2_data()[0];
+      const float_t * values = & _eqs.value_data()[0];
+      const float_t * x_data = & x.data()[0];
+      float_t * y_data = & y.data()[0];
+      
+      #pragma omp parallel for num_threads(_n_threads) schedule(static)
+      for(long i = 0; i < n_rows; ++i)
+      {
+        float_t value = 0.0;
+        
+        if(i < last_row)
+          for(size_t pos = row_starts[i]; pos < row_starts[i + 1]; ++pos)
+            value += values[pos] * x_data[columns[pos]];
+          
+        y_data[i] = value;
+      }
+    }
+    
+    void diagonal(ublas::vector<float_t> & diagonal) const
+    {
+      const size_t last_row = _eqs.filled1() - 1;
+      const size_t * row_starts = & _eqs.index1_data()[0];
+      const size_t * columns = & _eqs.index2_data()[0];
+      
+      diagonal.resize(_eqs.size1(), false);
+      diagonal.clear();
+      
+      for(size_t i = 0; i < diagonal.size() && i < last_row; ++i)
+      {
+        const size_t * position = std::lower_bound(columns + row_starts[i], columns + row_starts[i + 1], i);
+        
+        if(position != columns + row_starts[i + 1] && *position == i)
+          diagonal(i) = _eqs.value_data()[position - columns];
+      }
+    }
+  };
+  
+  
+  void PcgSolver::solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    if(eqs.size1() != eqs.size2() || eqs.size2() != rhs.size())
+      throw Exception("Exception: Dimensions do not agree in PcgSolver::solve().");
+      
+    if(_preconditioner == SOLVER_PRECONDITIONER && ! _solver_preconditioner)
+      throw Exception("Exception: No preconditioner set in PcgSolver::solve().");
+      
+    if((_preconditioner == SSOR_PRECONDITIONER || _preconditioner == IC0_PRECONDITIONER) && rhs.size() > 0)
+      find_diagonal(eqs);
+      
+    if(_preconditioner == IC0_PRECONDITIONER && rhs.size() > 0)
+      factorize_ic0(eqs);
+      
+    iterate(matrix_operator(eqs, _n_threads), & eqs, rhs, result);
+  }
+  
+  
+  void PcgSolver::solve(const LinearOperatorInterface & op, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    if(op.size() != rhs.size())
+      throw Exception("Exception: Dimensions do not agree in PcgSolver::solve().");
+      
+    if(_preconditioner == SSOR_PRECONDITIONER || _preconditioner == IC0_PRECONDITIONER || _preconditioner == SOLVER_PRECONDITIONER)
+      throw Exception("Exception: Preconditioner requires an assembled matrix in PcgSolver::solve().");
+      
+    iterate(op, 0, rhs, result);
+  }
+  
+  
+  template <class operator_t>
+  void PcgSolver::iterate(const operator_t & op, const ublas::compressed_matrix<float_t> * eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    const size_t size = rhs.size();
+    const long n = long(size);
+    
+    if(result.size() != size)
+    {
+      result.resize(size);
+      result.clear();
+    }
+    
+    _n_iterations = 0;
+    _residual = 0.0;
+    
+    if(size == 0)
+      return;
+      
+    // resizing to the same size does not reallocate the work vectors
+    _r.resize(size, false);
+    _z.resize(size, false);
+    _p.resize(size, false);
+    _q.resize(size, false);
+    
+    if(_preconditioner == JACOBI_PRECONDITIONER)
+    {
+      op.diagonal(_inverse_diagonal);
+      
+      for(size_t i = 0; i < size; ++i)
+        _inverse_diagonal(i) = _inverse_diagonal(i) != 0.0 ? 1.0 / _inverse_diagonal(i) : 1.0;
+    }
+    
+    float_t rhs_norm = std::sqrt(inner_product(rhs, rhs));
+    if(rhs_norm == 0.0)
+    {
+      result.clear();
+      return;
+    }
+    
+    float_t * x = & result.data()[0];
+    float_t * r = & _r.data()[0];
+    float_t * p = & _p.data()[0];
+    const float_t * z = & _z.data()[0];
+    const float_t * q = & _q.data()[0];
+    const float_t * b = & rhs.data()[0];
+    
+    op.apply(result, _q);
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static)
+    for(long i = 0; i < n; ++i)
+      r[i] = b[i] - q[i];
+    
+    float_t residual_norm = std::sqrt(inner_product(_r, _r));
+    float_t rho = 0.0, rho_old = 0.0;
+    
+    while(residual_norm > _tolerance * rhs_norm && _n_iterations < _n_max_iterations)
+    {
+      precondition(eqs, _r, _z);
+      
+      rho = inner_product(_r, _z);
+      const float_t beta = _n_iterations == 0 ? 0.0 : rho / rho_old;
+      
+      #pragma omp parallel for num_threads(_n_threads) schedule(static)
+      for(long i = 0; i < n; ++i)
+        p[i] = z[i] + beta * p[i];
+        
+      op.apply(_p, _q);
+      
+      const float_t p_q = inner_product(_p, _q);
+      if(p_q <= 0.0)
+        throw Exception("Exception: System is not positive definite in PcgSolver::solve().");
+      
+      const float_t alpha = rho / p_q;
+      float_t residual_square = 0.0;
+      
+      #pragma omp parallel for num_threads(_n_threads) schedule(static) reduction(+:residual_square)
+      for(long i = 0; i < n; ++i)
+      {
+        x[i] += alpha * p[i];
+        r[i] -= alpha * q[i];
+        residual_square += r[i] * r[i];
+      }
+      
+      rho_old = rho;
+      residual_norm = std::sqrt(residual_square);
+      ++_n_iterations;
+    }
+    
+    _residual = residual_norm / rhs_norm;
+    
+    if(residual_norm > _tolerance * rhs_norm)
+      MessageInterface::out("PcgSolver (Warning): Failure to converge in the maximal number of iterations!!", MessageInterface::DEBUG_ONLY);
+  }
+  
+  
+  float_t PcgSolver::inner_product(const ublas::vector<float_t> & x, const ublas::vector<float_t> & y) const
+  {
+    const long n = long(x.size());
+    const float_t * x_data = & x.data()[0];
+    const float_t * y_data = & y.data()[0];
+    float_t value = 0.0;
+    
+    #pragma omp parallel for num_threads(_n_threads) schedule(static) reduction(+:value)
+    for(long i = 0; i < n; ++i)
+      value += x_data[i] * y_data[i];
+      
+    return value;
+  }
+  
+  
+  void PcgSolver::find_diagonal(const ublas::compressed_matrix<float_t> & eqs) const
+  {
+    const size_t size = eqs.size1();
+    const size_t last_row = eqs.filled1() - 1;
+    const size_t * row_starts = & eqs.index1_data()[0];
+    const size_t * columns = & eqs.index2_data()[0];
+    
+    _diagonal_positions.assign(size, size_t(-1));
+    
+    for(size_t i = 0; i < size && i < last_row; ++i)
+    {
+      const size_t * diagonal = std::lower_bound(columns + row_starts[i], columns + row_starts[i + 1], i);
+      
+      if(diagonal != columns + row_starts[i + 1] && *diagonal == i)
+        _diagonal_positions[i] = size_t(diagonal - columns);
+    }
+  }
+  
+  
+  void PcgSolver::factorize_ic0(const ublas::compressed_matrix<float_t> & eqs) const
+  {
+    const size_t size = eqs.size1();
+    const size_t * row_starts = & eqs.index1_data()[0];
+    const size_t * columns = & eqs.index2_data()[0];
+    const float_t * values = & eqs.value_data()[0];
+    
+    // the factor L is stored at the positions of the lower triangle (including the diagonal) of eqs
+    _factor.resize(eqs.nnz());
+    
+    for(size_t i = 0; i < size; ++i)
+    {
+      if(_diagonal_positions[i] == size_t(-1))
+        throw Exception("Exception: Missing diagonal entry in PcgSolver::factorize_ic0().");
+        
+      const size_t row_begin = row_starts[i];
+      const size_t row_diagonal = _diagonal_positions[i];
+      float_t diagonal_value = values[row_diagonal];
+      
+      for(size_t pos = row_begin; pos < row_diagonal; ++pos)
+      {
+        const size_t k = columns[pos];
+        
+        // sum of L(i, j) * L(k, j) over the common columns j < k of the rows i and k
+        float_t sum = 0.0;
+        size_t pos_i = row_begin, pos_k = row_starts[k];
+        const size_t end_k = _diagonal_positions[k];
+        
+        while(pos_i < pos && pos_k < end_k)
+        {
+          if(columns[pos_i] < columns[pos_k])
+            ++pos_i;
+          else if(columns[pos_i] > columns[pos_k])
+            ++pos_k;
+          else
+            sum += _factor[pos_i++] * _factor[pos_k++];
+        }
+        
+        _factor[pos] = (values[pos] - sum) / _factor[end_k];
+        diagonal_value -= _factor[pos] * _factor[pos];
+      }
+      
+      if(diagonal_value <= 0.0)
+        throw Exception("Exception: Incomplete Cholesky factorization failed (system is not positive definite) in PcgSolver::factorize_ic0().");
+        
+      _factor[row_diagonal] = std::sqrt(diagonal_value);
+    }
+  }
+  
+  
+  void PcgSolver::precondition(const ublas::compressed_matrix<float_t> * eqs, const ublas::vector<float_t> & r, ublas::vector<float_t> & z) const
+  {
+    const long n = long(r.size());
+    const float_t * r_data = & r.data()[0];
+    float_t * z_data = & z.data()[0];
+    
+    switch(_preconditioner)
+    {
+    case JACOBI_PRECONDITIONER:
+      {
+        const float_t * inverse_diagonal = & _inverse_diagonal.data()[0];
+        
+        #pragma omp parallel for num_threads(_n_threads) schedule(static)
+        for(long i = 0; i < n; ++i)
+          z_data[i] = inverse_diagonal[i] * r_data[i];
+      }
+      break;
+    case SSOR_PRECONDITIONER:
+      apply_ssor(*eqs, r, z);
+      break;
+    case IC0_PRECONDITIONER:
+      apply_ic0(*eqs, r, z);
+      break;
+    case SOLVER_PRECONDITIONER:
+      z.clear();
+      _solver_preconditioner->solve(*eqs, r, z);
+      break;
+    default:
+      #pragma omp parallel for num_threads(_n_threads) schedule(static)
+      for(long i = 0; i < n; ++i)
+        z_data[i] = r_data[i];
+    }
+  }
+  
+  
+  void PcgSolver::apply_ssor(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & r, ublas::vector<float_t> & z) const
+  {
+    const size_t size = eqs.size1();
+    const size_t last_row = eqs.filled1() - 1;
+    const size_t * row_starts = & eqs.index1_data()[0];
+    const size_t * columns = & eqs.index2_data()[0];
+    const float_t * values = & eqs.value_data()[0];
+    
+    if(_relaxation <= 0.0 || _relaxation >= 2.0)
+      throw Exception("Exception: Relaxation parameter not in (0, 2) in PcgSolver::apply_ssor().");
+      
+    // forward sweep: (D / w + L) z = r, followed by z = D / w * z
+    for(size_t i = 0; i < size; ++i)
+    {
+      if(_diagonal_positions[i] == size_t(-1) || values[_diagonal_positions[i]] == 0.0)
+        throw Exception("Exception: Zero diagonal entry in PcgSolver::apply_ssor().");
+        
+      float_t value = r(i);
+      for(size_t pos = row_starts[i]; pos < _diagonal_positions[i]; ++pos)
+        value -= values[pos] * z(columns[pos]);
+        
+      z(i) = value * _relaxation / values[_diagonal_positions[i]];
+    }
+    
+    for(size_t i = 0; i < size; ++i)
+      z(i) *= values[_diagonal_positions[i]] / _relaxation;
+    
+    // backward sweep: (D / w + U) z = z
+    for(size_t i = size; i-- > 0;)
+    {
+      float_t value = z(i);
+      
+      if(i < last_row)
+        for(size_t pos = _diagonal_positions[i] + 1; pos < row_starts[i + 1]; ++pos)
+          value -= values[pos] * z(columns[pos]);
+        
+      z(i) = value * _relaxation / values[_diagonal_positions[i]];
+    }
+    
+    for(size_t i = 0; i < size; ++i)
+      z(i) *= (2.0 - _relaxation) / _relaxation;
+  }
+  
+  
+  void PcgSolver::apply_ic0(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & r, ublas::vector<float_t> & z) const
+  {
+    const size_t size = eqs.size1();
+    const size_t * row_starts = & eqs.index1_data()[0];
+    const size_t * columns = & eqs.index2_data()[0];
+    
+    // forward substitution: L y = r
+    for(size_t i = 0; i < size; ++i)
+    {
+      float_t value = r(i);
+      for(size_t pos = row_starts[i]; pos < _diagonal_positions[i]; ++pos)
+        value -= _factor[pos] * z(columns[pos]);
+        
+      z(i) = value / _factor[_diagonal_positions[i]];
+    }
+    
+    // backward substitution: L^T z = y, L^T is traversed by columns
+    for(size_t i = size; i-- > 0;)
+    {
+      z(i) /= _factor[_diagonal_positions[i]];
+      
+      for(size_t pos = row_starts[i]; pos < _diagonal_positions[i]; ++pos)
+        z(columns[pos]) -= _factor[pos] * z(i);
+    }
+  }
+}
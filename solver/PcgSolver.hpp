@@ -0,0 +1,109 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLVER_PCGSOLVER_H
+#define SOLVER_PCGSOLVER_H
+
+#include <solver/SolverInterface.hpp>
+#include <solver/LinearOperatorInterface.hpp>
+
+#include <vector>
+
+namespace imaging
+{
+  /** \ingroup solver
+      \brief Multithreaded preconditioned conjugate gradients solver for symmetric positive definite systems.
+      
+      This class implements a conjugate gradients solver in C++. In contrast to CgSolver, which interfaces ITPACK, it operates directly on the compressed row storage of the system matrix without copying it. Matrix-vector products, inner products and vector updates are distributed to n_threads() threads. The work vectors (and the incomplete Cholesky factor) are kept by the solver and reused by subsequent calls to solve().
+      
+      PcgSolver also accepts any implementation of LinearOperatorInterface instead of an assembled matrix, in particular MatrixFreeOperator. In this case only the Jacobi preconditioner (which uses LinearOperatorInterface::diagonal()) is available.
+      
+      The iteration stops if the euclidean norm of the residual is smaller than the tolerance times the norm of the right hand side or if the maximal number of iterations is reached. The solver starts from the current content of \em result if it has the dimension of the system (warm start) and from zero otherwise. In time stepping schemes, where the solution of the previous step is a good initial guess, the solver then converges in a few iterations.
+  */
+  class PcgSolver : public SolverInterface
+  {
+  public:
+    /** Available preconditioners. SSOR_PRECONDITIONER, IC0_PRECONDITIONER (incomplete Cholesky factorization without fill-in) and SOLVER_PRECONDITIONER (see set_preconditioner()) are only available for assembled matrices. */
+    enum preconditioner_types { NO_PRECONDITIONER, JACOBI_PRECONDITIONER, SSOR_PRECONDITIONER, IC0_PRECONDITIONER, SOLVER_PRECONDITIONER };
+    
+  private:
+    class matrix_operator;
+    
+    size_t _n_max_iterations;
+    float_t _tolerance;
+    preconditioner_types _preconditioner;
+    float_t _relaxation;
+    size_t _n_threads;
+    const SolverInterface * _solver_preconditioner;
+    
+    mutable size_t _n_iterations;
+    mutable float_t _residual;
+    mutable ublas::vector<float_t> _r, _z, _p, _q, _inverse_diagonal;
+    mutable std::vector<float_t> _factor;
+    mutable std::vector<size_t> _diagonal_positions;
+    
+    template <class operator_t>
+    void iterate(const operator_t & op, const ublas::compressed_matrix<float_t> * eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    
+    void find_diagonal(const ublas::compressed_matrix<float_t> & eqs) const;
+    void factorize_ic0(const ublas::compressed_matrix<float_t> & eqs) const;
+    void precondition(const ublas::compressed_matrix<float_t> * eqs, const ublas::vector<float_t> & r, ublas::vector<float_t> & z) const;
+    void apply_ssor(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & r, ublas::vector<float_t> & z) const;
+    void apply_ic0(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & r, ublas::vector<float_t> & z) const;
+    
+    float_t inner_product(const ublas::vector<float_t> & x, const ublas::vector<float_t> & y) const;
+    
+  public:
+    /** Constructs a PCG solver. The solver iterates at most \em n_max_iterations times until the relative residual is smaller than \em tolerance. The vector operations are executed by \em n_threads threads. */
+    PcgSolver(size_t n_max_iterations = 10000, float_t tolerance = 1e-8, preconditioner_types preconditioner = JACOBI_PRECONDITIONER, size_t n_threads = 1) :
+      _n_max_iterations(n_max_iterations), _tolerance(tolerance), _preconditioner(preconditioner), _relaxation(1.0),
+      _n_threads(n_threads > 0 ? n_threads : 1), _solver_preconditioner(0), _n_iterations(0), _residual(0.0) {}
+    
+    /** Sets the relative residual at which the iteration stops. */
+    void set_tolerance(float_t tolerance) { _tolerance = tolerance; }
+    
+    /** Returns the relative residual at which the iteration stops. */
+    float_t tolerance() const { return _tolerance; }
+    
+    /** Sets the relaxation parameter of the SSOR preconditioner. It must lie in the interval (0, 2). The default value 1 corresponds to the symmetric Gauss-Seidel method. */
+    void set_relaxation(float_t relaxation) { _relaxation = relaxation; }
+    
+    /** Uses \em preconditioner as preconditioner. In each iteration the preconditioned residual is computed by calling SolverInterface::solve() for the system matrix and the current residual, starting from zero. The preconditioner must be a fixed symmetric positive definite linear operation, e.g. a fixed number of cycles of MultigridSolver. Only a reference to \em preconditioner is stored. */
+    void set_preconditioner(const SolverInterface & preconditioner) { _solver_preconditioner = & preconditioner; _preconditioner = SOLVER_PRECONDITIONER; }
+    
+    /** Returns the number of threads. */
+    size_t n_threads() const { return _n_threads; }
+    
+    /** Sets the number of threads. */
+    void set_n_threads(size_t n_threads) { _n_threads = n_threads > 0 ? n_threads : 1; }
+    
+    void solve(const ublas::compressed_matrix<float_t> & eqs, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    
+    /** Solves the system defined by the operator \em op and the vector \em rhs and writes the solution to \em result. */
+    void solve(const LinearOperatorInterface & op, const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    
+    /** Returns the number of iterations of the last call to solve(). */
+    size_t n_iterations() const { return _n_iterations; }
+    
+    /** Returns the relative residual after the last call to solve(). */
+    float_t residual() const { return _residual; }
+  };
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <solver/SpoolesFactorization.hpp>
+
+#include <solver/utilities.hpp>
+
+extern "C"
+{
+  void * spooles_analyze(int iterative, int n_block_indices, int const *block_indices,
+                         int const *column_indices);
+  int spooles_factorize(void *handle, double const *values);
+  int spooles_solve(void *handle, int nrhs, double const *rhs, double *result);
+  void spooles_free(void *handle);
+}
+
+namespace imaging
+{
+  /** \cond */
+  void SpoolesFactorization::clear()
+  {
+    if(_handle)
+      spooles_free(_handle);
+      
+    _handle = 0;
+    _is_factorized = false;
+  }
+  
+  void SpoolesFactorization::analyze(const ublas::compressed_matrix<float_t> & pattern)
+  {
+    if(pattern.size1() != pattern.size2() || pattern.size1() == 0)
+      throw Exception("Exception: Matrix is not square or empty in " + _owner + "::analyze().");
+      
+    clear();
+    sparse2raw(pattern, _values, _column_indices, _block_indices);
+    
+    _handle = spooles_analyze(_iterative, _block_indices.size(), &_block_indices[0], &_column_indices[0]);
+    
+    if(! _handle)
+      throw Exception("Exception: Analysis of the sparsity pattern failed in " + _owner + "::analyze().");
+  }
+  
+  bool SpoolesFactorization::copy_values(const ublas::compressed_matrix<float_t> & eqs)
+  {
+    if(eqs.size1() != size() || eqs.size2() != size())
+      return false;
+      
+    ublas::compressed_matrix<float_t>::const_iterator1 iter1;
+    ublas::compressed_matrix<float_t>::const_iterator2 iter2;
+    
+    std::size_t index = 0;
+    
+    // traverse the entries in the same order as sparse2raw() and compare them to the analyzed pattern
+    for(iter1 = eqs.begin1(); iter1 != eqs.end1(); ++iter1)
+    {
+      for(iter2 = iter1.begin(); iter2 != iter1.end(); ++iter2)
+      {
+        if(index == _column_indices.size() || _column_indices[index] != int(iter2.index2() + 1))
+          return false;
+          
+        _values[index] = *iter2;
+        index++;
+      }
+      
+      if(_block_indices[iter1.index1() + 1] != int(index + 1))
+        return false;
+    }
+    
+    return index == _column_indices.size();
+  }
+  
+  void SpoolesFactorization::factorize(const ublas::compressed_matrix<float_t> & eqs)
+  {
+    if(! is_analyzed())
+      analyze(eqs);
+      
+    if(! copy_values(eqs))
+      throw Exception("Exception: Sparsity pattern differs from the analyzed pattern in " + _owner + "::factorize().");
+      
+    _is_factorized = spooles_factorize(_handle, &_values[0]);
+    
+    if(! _is_factorized)
+      throw Exception("Exception: Factorization failed (matrix is singular) in " + _owner + "::factorize().");
+  }
+  
+  void SpoolesFactorization::solve(const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const
+  {
+    if(! is_factorized())
+      throw Exception("Exception: No factorization available in " + _owner + "::solve().");
+      
+    if(rhs.size() != size())
+      throw Exception("Exception: Dimensions do not agree in " + _owner + "::solve().");
+      
+    result.resize(rhs.size());
+    
+    if(! spooles_solve(_handle, 1, &rhs[0], &result[0]))
+      throw Exception("Exception: Solution failed in " + _owner + "::solve().");
+  }
+  
+  void SpoolesFactorization::solve(const ublas::matrix<float_t> & rhs, ublas::matrix<float_t> & result) const
+  {
+    if(! is_factorized())
+      throw Exception("Exception: No factorization available in " + _owner + "::solve().");
+      
+    if(rhs.size1() != size())
+      throw Exception("Exception: Dimensions do not agree in " + _owner + "::solve().");
+      
+    const size_t n = rhs.size1();
+    const size_t n_rhs = rhs.size2();
+    
+    result.resize(n, n_rhs, false);
+    
+    if(n_rhs == 0)
+      return;
+      
+    // SPOOLES expects the right hand sides column by column
+    std::vector<float_t> rhs_columns(n * n_rhs);
+    std::vector<float_t> result_columns(n * n_rhs);
+    
+    for(size_t j = 0; j < n_rhs; ++j)
+      for(size_t i = 0; i < n; ++i)
+        rhs_columns[j * n + i] = rhs(i, j);
+        
+    if(! spooles_solve(_handle, n_rhs, &rhs_columns[0], &result_columns[0]))
+      throw Exception("Exception: Solution failed in " + _owner + "::solve().");
+      
+    for(size_t j = 0; j < n_rhs; ++j)
+      for(size_t i = 0; i < n; ++i)
+        result(i, j) = result_columns[j * n + i];
+  }
+  /** \endcond */
+}
@@ -0,0 +1,64 @@
+/* 
+*  Copyright 2009 University of Innsbruck, Infmath Imaging
+*
+*  This file is part of imaging2.
+*
+*  Imaging2 is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Imaging2 is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with stromx-studio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLVER_SPOOLESFACTORIZATION_H
+#define SOLVER_SPOOLESFACTORIZATION_H
+
+#include <core/imaging2.hpp>
+
+#include <vector>
+#include <string>
+
+namespace imaging
+{
+  /** \cond */
+  class SpoolesFactorization
+  {
+    void * _handle;
+    bool _iterative;
+    bool _is_factorized;
+    std::string _owner;
+    std::vector<int> _column_indices;
+    std::vector<int> _block_indices;
+    // the values of the matrix to be factorized in the order of the analyzed pattern
+    std::vector<float_t> _values;
+    
+    SpoolesFactorization(const SpoolesFactorization &);
+    SpoolesFactorization & operator=(const SpoolesFactorization &);
+    
+    void clear();
+    bool copy_values(const ublas::compressed_matrix<float_t> & eqs);
+    
+  public:
+    SpoolesFactorization(bool iterative, const std::string & owner) : _handle(0), _iterative(iterative), _is_factorized(false), _owner(owner) {}
+    ~SpoolesFactorization() { clear(); }
+    
+    bool is_analyzed() const { return _handle != 0; }
+    bool is_factorized() const { return _is_factorized; }
+    size_t size() const { return _block_indices.size() > 0 ? _block_indices.size() - 1 : 0; }
+    
+    void analyze(const ublas::compressed_matrix<float_t> & pattern);
+    void factorize(const ublas::compressed_matrix<float_t> & eqs);
+    void solve(const ublas::vector<float_t> & rhs, ublas::vector<float_t> & result) const;
+    void solve(const ublas::matrix<float_t> & rhs, ublas::matrix<float_t> & result) const;
+  };
+  /** \endcond */
+}
+
+#endif
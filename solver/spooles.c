@@ -5,6 +5,7 @@
 #include <spooles/Graph.h>
 
 #include <string.h>
+#include <stdlib.h>
 
 #define METHODS 10
 
@@ -958,3 +959,356 @@ InpMtx_createGraph (InpMtx *mtxA, Graph    *graph)
 
 
 
+/*  factorization.c  */
+/*--------------------------------------------------------------------*/
+/*
+   ---------------------------------------------------------------
+   factor-once, solve-many interface
+
+   spooles_analyze() computes the ordering and the symbolic
+   factorization of a sparsity pattern, spooles_factorize() computes
+   the numeric factorization for values in this pattern and
+   spooles_solve() solves for one or more right hand sides. If the
+   factorization is iterative the factor is used as preconditioner
+   of BiCGStab, otherwise the systems are solved directly.
+   ---------------------------------------------------------------
+*/
+typedef struct _SpoolesFactorization SpoolesFactorization ;
+struct _SpoolesFactorization {
+  int             neqns ;
+  int             nent ;
+  int             iterative ;
+  int             symmetryflag ;
+  int             pivotingflag ;
+  int             sparsityflag ;
+  double          tau ;
+  double          droptol ;
+  double          conv_tol ;
+  int             msglvl ;
+  FILE            *msgFile ;
+  int             *block_indices ;
+  int             *column_indices ;
+  ETree           *frontETree ;
+  IV              *oldToNewIV ;
+  IV              *newToOldIV ;
+  IVL             *symbfacIVL ;
+  InpMtx          *mtxA ;
+  FrontMtx        *frontmtx ;
+  SubMtxManager   *mtxmanager ;
+} ;
+
+
+static InpMtx *
+spooles_create_input_matrix(SpoolesFactorization *data, double const *values)
+/*
+   ---------------------------------------------------------
+   create the InpMtx object from the stored sparsity pattern,
+   permute it if the ordering is known and convert it to 
+   chevron coordinates. if values is NULL all entries are 1.
+   ---------------------------------------------------------
+*/
+{
+  InpMtx  *mtxA ;
+  int     my_i, my_j ;
+  
+  mtxA = InpMtx_new() ;
+  InpMtx_init(mtxA, INPMTX_BY_ROWS, SPOOLES_REAL, data->nent, data->neqns) ;
+  
+  for(my_i = 0; my_i < data->neqns; ++my_i)
+    for(my_j = data->block_indices[my_i] - 1; my_j < data->block_indices[my_i + 1] - 1; ++my_j)
+      InpMtx_inputRealEntry(mtxA, my_i, data->column_indices[my_j] - 1, 
+                            values ? values[my_j] : 1.0) ;
+  
+  InpMtx_changeStorageMode(mtxA, INPMTX_BY_VECTORS) ;
+  
+  if ( data->oldToNewIV != NULL ) {
+    InpMtx_permute(mtxA, IV_entries(data->oldToNewIV), IV_entries(data->oldToNewIV)) ;
+    InpMtx_changeCoordType(mtxA, INPMTX_BY_CHEVRONS) ;
+    InpMtx_changeStorageMode(mtxA, INPMTX_BY_VECTORS) ;
+  }
+  
+  return(mtxA) ;
+}
+
+
+static void
+spooles_clear_factor(SpoolesFactorization *data)
+{
+  if ( data->frontmtx != NULL ) {
+    FrontMtx_free(data->frontmtx) ;
+    data->frontmtx = NULL ;
+  }
+  if ( data->mtxmanager != NULL ) {
+    SubMtxManager_free(data->mtxmanager) ;
+    data->mtxmanager = NULL ;
+  }
+  if ( data->mtxA != NULL ) {
+    InpMtx_free(data->mtxA) ;
+    data->mtxA = NULL ;
+  }
+}
+
+
+void
+spooles_free(void *handle)
+{
+  SpoolesFactorization *data = (SpoolesFactorization *) handle ;
+  
+  if ( data == NULL )
+    return ;
+  
+  spooles_clear_factor(data) ;
+  
+  if ( data->symbfacIVL != NULL ) IVL_free(data->symbfacIVL) ;
+  if ( data->oldToNewIV != NULL ) IV_free(data->oldToNewIV) ;
+  if ( data->newToOldIV != NULL ) IV_free(data->newToOldIV) ;
+  if ( data->frontETree != NULL ) ETree_free(data->frontETree) ;
+  if ( data->msgFile != NULL && data->msgFile != stdout ) fclose(data->msgFile) ;
+  
+  free(data->block_indices) ;
+  free(data->column_indices) ;
+  free(data) ;
+}
+
+
+void *
+spooles_analyze(int iterative, int n_block_indices, int const *block_indices, 
+                int const *column_indices)
+/*
+   --------------------------------------------------------------
+   compute the fill reducing ordering and the symbolic 
+   factorization of the pattern given by block_indices and
+   column_indices (one based compressed row storage). returns
+   NULL on failure.
+   --------------------------------------------------------------
+*/
+{
+  SpoolesFactorization  *data ;
+  InpMtx                *mtxA ;
+  Graph                 *graph ;
+  IVL                   *adjIVL ;
+  int                   nedges, seed ;
+  
+  if ( n_block_indices < 2 )
+    return(NULL) ;
+  
+  data = (SpoolesFactorization *) calloc(1, sizeof(SpoolesFactorization)) ;
+  if ( data == NULL )
+    return(NULL) ;
+  
+  data->neqns = n_block_indices - 1 ;
+  data->nent = block_indices[n_block_indices - 1] - 1 ;
+  data->iterative = iterative ;
+  data->msglvl = 0 ;
+  
+  /* same parameters as spooles_lu_solve() and spooles_bicgstab_solve() */
+  if ( iterative ) {
+    data->symmetryflag = SPOOLES_NONSYMMETRIC ;
+    data->pivotingflag = SPOOLES_PIVOTING ;
+    data->sparsityflag = FRONTMTX_DENSE_FRONTS ;
+    data->tau = 1.0 ;
+    data->droptol = 1E-3 ;
+    data->conv_tol = 1E-5 ;
+    data->msgFile = fopen("spooles.log", "w") ;
+    if ( data->msgFile == NULL )
+      data->msgFile = stdout ;
+  } else {
+    data->symmetryflag = SPOOLES_NONSYMMETRIC ;
+    data->pivotingflag = SPOOLES_NO_PIVOTING ;
+    data->sparsityflag = FRONTMTX_DENSE_FRONTS ;
+    data->tau = 100. ;
+    data->droptol = 0.0 ;
+    data->msgFile = stdout ;
+  }
+  
+  data->block_indices = (int *) malloc(n_block_indices * sizeof(int)) ;
+  data->column_indices = (int *) malloc((data->nent > 0 ? data->nent : 1) * sizeof(int)) ;
+  if ( data->block_indices == NULL || data->column_indices == NULL ) {
+    spooles_free(data) ;
+    return(NULL) ;
+  }
+  memcpy(data->block_indices, block_indices, n_block_indices * sizeof(int)) ;
+  memcpy(data->column_indices, column_indices, data->nent * sizeof(int)) ;
+  
+  /*
+    ------------------------------
+    order the graph of the pattern
+    ------------------------------
+  */
+  mtxA = spooles_create_input_matrix(data, NULL) ;
+  
+  seed = rand() ;
+  graph = Graph_new() ;
+  adjIVL = InpMtx_fullAdjacency(mtxA) ;
+  nedges = IVL_tsize(adjIVL) ;
+  Graph_init2(graph, 0, data->neqns, 0, nedges, data->neqns, nedges, adjIVL,
+              NULL, NULL) ;
+  
+  if ( iterative )
+    data->frontETree = orderViaBestOfNDandMS(graph, 500, 1000, 64, seed, 
+                                             data->msglvl, data->msgFile) ;
+  else
+    data->frontETree = orderViaMMD(graph, seed, data->msglvl, data->msgFile) ;
+  
+  Graph_free(graph) ;
+  
+  if ( iterative )
+    ETree_leftJustify(data->frontETree) ;
+  
+  /*
+    ----------------------------------------------------
+    get the permutations, permute the front tree and the 
+    matrix and compute the symbolic factorization
+    ----------------------------------------------------
+  */
+  data->oldToNewIV = ETree_oldToNewVtxPerm(data->frontETree) ;
+  data->newToOldIV = ETree_newToOldVtxPerm(data->frontETree) ;
+  ETree_permuteVertices(data->frontETree, data->oldToNewIV) ;
+  
+  InpMtx_permute(mtxA, IV_entries(data->oldToNewIV), IV_entries(data->oldToNewIV)) ;
+  InpMtx_changeCoordType(mtxA, INPMTX_BY_CHEVRONS) ;
+  InpMtx_changeStorageMode(mtxA, INPMTX_BY_VECTORS) ;
+  
+  data->symbfacIVL = SymbFac_initFromInpMtx(data->frontETree, mtxA) ;
+  
+  InpMtx_free(mtxA) ;
+  
+  return(data) ;
+}
+
+
+int
+spooles_factorize(void *handle, double const *values)
+/*
+   ------------------------------------------------------------
+   compute the numeric factorization of the matrix with the 
+   analyzed pattern and the entries values. returns 1 on success 
+   and 0 if the matrix is singular or an error occured.
+   ------------------------------------------------------------
+*/
+{
+  SpoolesFactorization  *data = (SpoolesFactorization *) handle ;
+  ChvManager            *chvmanager ;
+  Chv                   *rootchv ;
+  double                cpus[10] ;
+  int                   stats[20] ;
+  int                   error ;
+  
+  spooles_clear_factor(data) ;
+  
+  data->mtxA = spooles_create_input_matrix(data, values) ;
+  
+  data->frontmtx = FrontMtx_new() ;
+  data->mtxmanager = SubMtxManager_new() ;
+  SubMtxManager_init(data->mtxmanager, NO_LOCK, 0) ;
+  FrontMtx_init(data->frontmtx, data->frontETree, data->symbfacIVL, 
+                SPOOLES_REAL, data->symmetryflag, data->sparsityflag, 
+                data->pivotingflag, NO_LOCK, 0, NULL, 
+                data->mtxmanager, data->msglvl, data->msgFile) ;
+  
+  chvmanager = ChvManager_new() ;
+  ChvManager_init(chvmanager, NO_LOCK, 1) ;
+  DVfill(10, cpus, 0.0) ;
+  IVfill(20, stats, 0) ;
+  rootchv = FrontMtx_factorInpMtx(data->frontmtx, data->mtxA, data->tau, 
+                                  data->droptol, chvmanager, &error, cpus, 
+                                  stats, data->msglvl, data->msgFile) ;
+  ChvManager_free(chvmanager) ;
+  
+  if ( rootchv != NULL || error >= 0 ) {
+    spooles_clear_factor(data) ;
+    return(0) ;
+  }
+  
+  FrontMtx_postProcess(data->frontmtx, data->msglvl, data->msgFile) ;
+  
+  /* the input matrix is only needed by the iterative solver */
+  if ( ! data->iterative ) {
+    InpMtx_free(data->mtxA) ;
+    data->mtxA = NULL ;
+  }
+  
+  return(1) ;
+}
+
+
+int
+spooles_solve(void *handle, int nrhs, double const *rhs, double *result)
+/*
+   ----------------------------------------------------------------
+   solve the factorized system for nrhs right hand sides. rhs and 
+   result store the right hand sides and the solutions column by 
+   column. returns 1 on success and 0 if no factorization exists.
+   ----------------------------------------------------------------
+*/
+{
+  SpoolesFactorization  *data = (SpoolesFactorization *) handle ;
+  DenseMtx              *mtxY, *mtxX, *mtxB, *mtxZ ;
+  double                cpus[10] ;
+  int                   neqns, my_i, my_j, rc = 1 ;
+  
+  if ( data == NULL || data->frontmtx == NULL )
+    return(0) ;
+  
+  neqns = data->neqns ;
+  
+  mtxY = DenseMtx_new() ;
+  DenseMtx_init(mtxY, SPOOLES_REAL, 0, 0, neqns, nrhs, 1, neqns) ;
+  
+  for(my_j = 0; my_j < nrhs; ++my_j)
+    for(my_i = 0; my_i < neqns; ++my_i)
+      DenseMtx_setRealEntry(mtxY, my_i, my_j, rhs[my_j * neqns + my_i]) ;
+  
+  DenseMtx_permuteRows(mtxY, data->oldToNewIV) ;
+  
+  mtxX = DenseMtx_new() ;
+  DenseMtx_init(mtxX, SPOOLES_REAL, 0, 0, neqns, nrhs, 1, neqns) ;
+  DenseMtx_zero(mtxX) ;
+  
+  if ( ! data->iterative ) {
+    DVfill(10, cpus, 0.0) ;
+    FrontMtx_solve(data->frontmtx, mtxX, mtxY, data->mtxmanager, 
+                   cpus, data->msglvl, data->msgFile) ;
+  } else {
+    /* the iterative solvers of SPOOLES accept one right hand side only */
+    mtxB = DenseMtx_new() ;
+    DenseMtx_init(mtxB, SPOOLES_REAL, 0, 0, neqns, 1, 1, neqns) ;
+    mtxZ = DenseMtx_new() ;
+    DenseMtx_init(mtxZ, SPOOLES_REAL, 0, 0, neqns, 1, 1, neqns) ;
+    
+    for(my_j = 0; my_j < nrhs && rc >= 0; ++my_j) {
+      double value ;
+      
+      for(my_i = 0; my_i < neqns; ++my_i) {
+        DenseMtx_realEntry(mtxY, my_i, my_j, &value) ;
+        DenseMtx_setRealEntry(mtxB, my_i, 0, value) ;
+      }
+      DenseMtx_zero(mtxZ) ;
+      
+      rc = bicgstabr(neqns, SPOOLES_REAL, data->symmetryflag, data->mtxA, 
+                     data->frontmtx, mtxZ, mtxB, 0, data->conv_tol, 
+                     data->msglvl, data->msgFile) ;
+      
+      for(my_i = 0; my_i < neqns; ++my_i) {
+        DenseMtx_realEntry(mtxZ, my_i, 0, &value) ;
+        DenseMtx_setRealEntry(mtxX, my_i, my_j, value) ;
+      }
+    }
+    
+    DenseMtx_free(mtxB) ;
+    DenseMtx_free(mtxZ) ;
+  }
+  
+  DenseMtx_permuteRows(mtxX, data->newToOldIV) ;
+  
+  for(my_j = 0; my_j < nrhs; ++my_j)
+    for(my_i = 0; my_i < neqns; ++my_i)
+      DenseMtx_realEntry(mtxX, my_i, my_j, &result[my_j * neqns + my_i]) ;
+  
+  DenseMtx_free(mtxX) ;
+  DenseMtx_free(mtxY) ;
+  
+  return(rc >= 0 ? 1 : 0) ;
+}
+
+/*--------------------------------------------------------------------*/
@@ -64,6 +64,45 @@ namespace imaging
     {
       return ( t >= first_knot() && t <= last_knot() );
     }
+    
+    // computes the basis splines of order 1 to spline_order() at t in the knot interval i;
+    // basis_splines(ii - i + k - 1, j) is the basis spline ii of order j + 1
+    void compute_basis_spline_table(float_t t, size_t i, ublas::matrix<float_t> & basis_splines) const
+    {
+      size_t k = _spline_order;
+      size_t i_offset = i - k + 1;
+
+      typename ublas::matrix<float_t>::iterator1 iter1;
+      typename ublas::matrix<float_t>::iterator2 iter2;
+
+      for(iter1 = basis_splines.begin1(); iter1 != basis_splines.end1(); ++iter1)
+        for(iter2 = iter1.begin(); iter2 != iter1.end(); ++iter2)
+          *iter2 = 0.0;
+
+      basis_splines(i - i_offset, 0) = 1;
+
+      for(size_t j = 1; j < k; ++j)
+        for(size_t ii = i - j; ii <= i; ++ii)
+        {
+          float_t n_1, n_2;
+
+          if(_knots(ii + j) == _knots(ii))
+            n_1 = 0;
+          else
+            n_1 = (t - _knots(ii)) /
+                  (_knots(ii + j) - _knots(ii));
+
+          if(_knots(ii + j + 1) == _knots(ii + 1))
+            n_2 = 1;
+          else
+            n_2 = (_knots(ii + j + 1) - t) /
+                  (_knots(ii + j + 1) - _knots(ii + 1));
+
+          basis_splines(ii - i_offset, j) =
+            basis_splines(ii - i_offset, j - 1) * n_1 +
+            basis_splines(ii + 1 - i_offset, j - 1) * n_2;
+        }
+    }
 
   public:
     Bspline() : _knots(), _coefficients() {}
@@ -188,36 +227,7 @@ namespace imaging
       size_t i_offset = i - k + 1;
       ublas::matrix<float_t> basis_splines(k + 1, k);
 
-      typename ublas::matrix<float_t>::iterator1 iter1;
-      typename ublas::matrix<float_t>::iterator2 iter2;
-
-      for(iter1 = basis_splines.begin1(); iter1 != basis_splines.end1(); ++iter1)
-        for(iter2 = iter1.begin(); iter2 != iter1.end(); ++iter2)
-          *iter2 = 0.0;
-
-      basis_splines(i - i_offset, 0) = 1;
-
-      for(size_t j = 1; j < k; ++j)
-        for(size_t ii = i - j; ii <= i; ++ii)
-        {
-          float_t n_1, n_2;
-
-          if(_knots(ii + j) == _knots(ii))
-            n_1 = 0;
-          else
-            n_1 = (t - _knots(ii)) /
-                  (_knots(ii + j) - _knots(ii));
-
-          if(_knots(ii + j + 1) == _knots(ii + 1))
-            n_2 = 1;
-          else
-            n_2 = (_knots(ii + j + 1) - t) /
-                  (_knots(ii + j + 1) - _knots(ii + 1));
-
-          basis_splines(ii - i_offset, j) =
-            basis_splines(ii - i_offset, j - 1) * n_1 +
-            basis_splines(ii + 1 - i_offset, j - 1) * n_2;
-        }
+      compute_basis_spline_table(t, i, basis_splines);
 
 
       DATA_t value = DATA_t(0.0);
@@ -256,6 +266,45 @@ namespace imaging
 
     }
     
+    /** Evaluates the basis splines which do not vanish at \em t. The index of the first of these basis splines is returned. Their values at \em t are stored in \em values and their first derivatives in \em derivatives, i.e. the value of the B-spline at \em t is the sum of <tt>values(j) * coefficient(first + j)</tt> for \em j from 0 to <tt>spline_order() - 1</tt>, where \em first is the returned index. Both vectors are resized to spline_order(). If \em t is outside the spline support, all values and derivatives are set to 0. Use this function to compute the derivatives of the B-spline with respect to its coefficients. */
+    size_t basis_splines(float_t t, ublas::vector<float_t> & values, ublas::vector<float_t> & derivatives) const
+    {
+      size_t k = _spline_order;
+
+      values.resize(k);
+      derivatives.resize(k);
+      values.clear();
+      derivatives.clear();
+
+      if ( ! is_in_spline_support(t) || t < _knots(_spline_order - 1) )
+        return 0;
+
+      size_t i = determine_interval(t);
+      size_t i_offset = i - k + 1;
+      ublas::matrix<float_t> basis_splines(k + 1, k);
+
+      compute_basis_spline_table(t, i, basis_splines);
+
+      for (size_t ii = i - k + 1; ii <= i; ++ii)
+      {
+        values(ii - i_offset) = basis_splines(ii - i_offset, k - 1);
+
+        // derivative of the first derivative in operator() with respect to coefficient ii
+        if(k > 1)
+        {
+          if(ii >= i - k + 2 && _knots(ii + k - 1) != _knots(ii))
+            derivatives(ii - i_offset) += basis_splines(ii - i_offset, k - 2) / (_knots(ii + k - 1) - _knots(ii));
+
+          if(ii + 1 <= i && _knots(ii + k) != _knots(ii + 1))
+            derivatives(ii - i_offset) -= basis_splines(ii + 1 - i_offset, k - 2) / (_knots(ii + k) - _knots(ii + 1));
+
+          derivatives(ii - i_offset) *= k - 1;
+        }
+      }
+
+      return i_offset;
+    }
+    
     /** Returns true if \em t is in the support of the <em>i</em>-th basis spline defined by the current knots of this spline. */
     bool is_in_basis_spline_support(size_t i, float_t t) const
     {
@@ -122,6 +122,14 @@ namespace imaging
       return value;
     }
 
+    /** Evaluates the basis splines which do not vanish at \em t (cf. Bspline::basis_splines()). The index of the coefficient which corresponds to the first of these basis splines is returned. Because the spline is periodic, the coefficient of the <em>j</em>-th basis spline is <tt>(first + j) % n_coefficients()</tt>, where \em first is the returned index. */
+    size_t basis_splines(float_t t, ublas::vector<float_t> & values, ublas::vector<float_t> & derivatives) const
+    {
+      size_t first = Bspline<DATA_t>::basis_splines(transform_parameter(t), values, derivatives);
+      
+      return ( first + n_coefficients() - ( Bspline<DATA_t>::spline_order() - 1 ) % n_coefficients() ) % n_coefficients();
+    }
+
     void regular_knots(float_t x_0, float_t x_1)
     {
       float_t offset = (x_1 - x_0) / float_t(n_coefficients());